@@ -168,6 +168,52 @@ public:
     void toggleDebug();
     bool getDebug() const;
 
+    // Tile cache
+    // Sets the number of bytes each source may spend on keeping parsed tiles
+    // that went out of view, so that they don't have to be reloaded when they
+    // come back. Defaults to 0, which disables the cache.
+    void setSourceTileCacheSize(size_t bytes);
+    size_t getSourceTileCacheSize() const;
+
+    // GPU upload
+    // Sets how many bytes of newly parsed tile data are uploaded to the GPU per frame. Tiles are
+    // drawn once all of their data is uploaded, and loaded parent or child tiles stand in for
+    // them until then. Defaults to 1 MB; 0 uploads everything in the next frame.
+    void setUploadBudget(size_t bytes);
+    size_t getUploadBudget() const;
+
+    struct UploadStats {
+        size_t lastFrameBytes = 0;
+        size_t maxFrameBytes = 0;
+        uint64_t totalBytes = 0;
+        // Frames that uploaded anything.
+        uint64_t frames = 0;
+    };
+    UploadStats getUploadStats() const;
+
+    // Fill batching
+    // Draws the opaque fills without patterns of each layer from all tiles with a few draw calls
+    // when the tiles have the same zoom level, instead of clipping and drawing every tile on its
+    // own. Tiles keep a copy of their fill geometry in memory for this, so it applies to tiles
+    // that are loaded after enabling it. Defaults to false.
+    void setFillBatching(bool value);
+    bool getFillBatching() const;
+
+    // Tile workers
+    struct WorkerStats {
+        // Parse jobs waiting for a worker thread now, and the most that ever waited at once.
+        unsigned int queued = 0;
+        unsigned int maxQueued = 0;
+        uint64_t started = 0;
+        uint64_t canceled = 0;
+        // Time jobs spent in the queue before a worker thread picked them up.
+        uint64_t totalWaitNs = 0;
+        uint64_t maxWaitNs = 0;
+    };
+    // Returns the numbers of the running worker pool, or of the last one after the map thread
+    // stopped.
+    WorkerStats getWorkerStats() const;
+
     inline const TransformState &getState() const { return state; }
     std::chrono::steady_clock::time_point getTime() const;
     inline AnnotationManager& getAnnotationManager() const { return *annotationManager; }
@@ -187,6 +233,8 @@ private:
     void setup();
 
     void updateTiles();
+    // Uploads newly parsed tiles within the budget. Runs before each frame is drawn.
+    void uploadTiles();
     void updateSources();
     void updateSources(const util::ptr<StyleLayerGroup> &group);
 
@@ -245,6 +293,16 @@ private:
     // Stores whether the map thread has been stopped already.
     std::atomic_bool isStopped;
 
+    // Written by the map thread, read by getUploadStats().
+    UploadStats uploadStats;
+    mutable std::mutex mutexUploadStats;
+
+    // Guards replacing the worker pool, which getWorkerStats() reads from other threads, and the
+    // final numbers of the last pool.
+    WorkerStats workerStats;
+    mutable std::mutex mutexWorkerStats;
+    void resetWorkers(std::unique_ptr<uv::worker> replacement = nullptr);
+
     Transform transform;
     TransformState state;
 
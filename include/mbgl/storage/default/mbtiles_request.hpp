@@ -0,0 +1,26 @@
+#ifndef MBGL_STORAGE_DEFAULT_MBTILES_REQUEST
+#define MBGL_STORAGE_DEFAULT_MBTILES_REQUEST
+
+#include "shared_request_base.hpp"
+
+namespace mbgl {
+
+// Reads from a local MBTiles file. "mbtiles:///path/to/file.mbtiles" returns the metadata as
+// TileJSON, whose tile URLs have the form "mbtiles:///path/to/file.mbtiles/{z}/{x}/{y}".
+class MBTilesRequest : public SharedRequestBase {
+public:
+    MBTilesRequest(DefaultFileSource *source, const Resource &resource);
+
+    void start(uv_loop_t *loop, std::unique_ptr<Response> response = nullptr);
+    void cancel();
+
+private:
+    ~MBTilesRequest();
+    void *ptr = nullptr;
+
+    friend class MBTilesRequestImpl;
+};
+
+}
+
+#endif
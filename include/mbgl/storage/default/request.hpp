@@ -27,7 +27,7 @@ public:
     Request(const Resource &resource, uv_loop_t *loop, const Environment &env, Callback callback);
 
 public:
-    // May be called from any thread.
+    // May be called from any thread. A stale response is followed by a second call.
     void notify(const std::shared_ptr<const Response> &response);
     void destruct();
 
@@ -44,11 +44,19 @@ private:
     struct Canceled;
     std::unique_ptr<Canceled> canceled;
     Callback callback;
+
+    // The response that wasn't delivered yet, and whether the request is done after delivering it.
+    std::mutex mutex;
     std::shared_ptr<const Response> response;
+    bool completed = false;
 
 public:
     const Resource resource;
 
+    // The current priority. Starts out as the resource's priority and is only accessed in the file
+    // source's thread afterwards; see FileSource::setPriority().
+    double priority;
+
     // The environment ref is used to associate requests with a particular environment. This allows
     // us to only terminate requests associated with that environment, e.g. when the map the env
     // belongs to is discarded.
@@ -8,6 +8,9 @@
 #include <mbgl/util/util.hpp>
 #include <mbgl/util/noncopyable.hpp>
 
+#include <algorithm>
+#include <limits>
+#include <memory>
 #include <string>
 #include <set>
 #include <vector>
@@ -45,6 +48,24 @@ public:
         MBGL_VERIFY_THREAD(tid);
 
         observers.insert(request);
+
+        if (staleResponse && request->resource.acceptsStale) {
+            // Catch up with the observers that already got the expired data.
+            request->notify(staleResponse);
+        }
+    }
+
+    // Delivers an expired cached response to all observers that accept it before the request is
+    // started to revalidate it. Observers that subscribe later get it too.
+    void notifyStale(std::shared_ptr<const Response> response) {
+        MBGL_VERIFY_THREAD(tid);
+
+        staleResponse = std::move(response);
+        for (const auto req : observers) {
+            if (req->resource.acceptsStale) {
+                req->notify(staleResponse);
+            }
+        }
     }
 
     void unsubscribe(Request *request) {
@@ -68,6 +89,23 @@ public:
         return observers.empty();
     }
 
+    bool observes(Request *request) const {
+        MBGL_VERIFY_THREAD(tid);
+
+        return observers.find(request) != observers.end();
+    }
+
+    // The most urgent priority of all observers.
+    double priority() const {
+        MBGL_VERIFY_THREAD(tid);
+
+        double result = std::numeric_limits<double>::infinity();
+        for (const auto req : observers) {
+            result = std::min(result, req->priority);
+        }
+        return result;
+    }
+
     std::vector<Request *> removeAllInEnvironment(const Environment &env) {
         MBGL_VERIFY_THREAD(tid);
 
@@ -95,6 +133,9 @@ protected:
 public:
     const Resource resource;
 
+    // The expired response the observers that accept stale data already got, if any.
+    std::shared_ptr<const Response> staleResponse;
+
 protected:
     DefaultFileSource *source = nullptr;
 
@@ -3,10 +3,14 @@
 
 #include <mbgl/storage/file_cache.hpp>
 
+#include <atomic>
 #include <string>
 #include <thread>
+#include <unordered_set>
+#include <vector>
 
 typedef struct uv_loop_s uv_loop_t;
+typedef struct uv_timer_s uv_timer_t;
 
 namespace mapbox { namespace util { template<typename... Types> class variant; } }
 namespace mapbox { namespace sqlite { class Database; class Statement; } }
@@ -17,34 +21,74 @@ namespace util { template <typename T> class AsyncQueue; }
 
 class SQLiteCache : public FileCache {
     struct GetAction;
+    struct BatchGetAction;
     struct PutAction;
     struct RefreshAction;
+    struct PinAction;
     struct StopAction;
-    using Action = mapbox::util::variant<GetAction, PutAction, RefreshAction, StopAction>;
+    using Action = mapbox::util::variant<GetAction, BatchGetAction, PutAction, RefreshAction,
+                                         PinAction, StopAction>;
     using Queue = util::AsyncQueue<Action>;
 
 public:
-    SQLiteCache(const std::string &path = ":memory:");
+    static const uint64_t defaultMaximumSize = 50 * 1024 * 1024;
+
+    // maximumSize is the number of bytes of stored data above which the least recently used
+    // entries are evicted.
+    SQLiteCache(const std::string &path = ":memory:", uint64_t maximumSize = defaultMaximumSize);
     ~SQLiteCache();
 
+    // Can be called from any thread; takes effect with the next batch of writes.
+    void setMaximumSize(uint64_t size);
+
     void get(const Resource &resource, std::function<void(std::unique_ptr<Response>)> callback);
+    void get(const std::vector<Resource> &resources, BatchCallback callback);
     void put(const Resource &resource, std::shared_ptr<const Response> response, Hint hint);
+    void pin(const Resource &resource);
 
 private:
     struct ActionDispatcher;
     void process(GetAction &action);
+    void process(BatchGetAction &action);
     void process(PutAction &action);
     void process(RefreshAction &action);
+    void process(PinAction &action);
     void process(StopAction &action);
+    void processPendingGets();
+    std::vector<std::unique_ptr<Response>> getAll(const std::vector<std::string> &unifiedURLs);
 
     void createDatabase();
+    void computeSize();
+    void beginTransaction();
+    void commitTransaction();
+    void flushAccessTimes();
+    void evict();
 
     const std::string path;
+    std::atomic<uint64_t> maximumSize;
     uv_loop_t *loop = nullptr;
     Queue *queue = nullptr;
     std::thread thread;
     std::unique_ptr<::mapbox::sqlite::Database> db;
-    std::unique_ptr<::mapbox::sqlite::Statement> getStmt, putStmt, refreshStmt;
+    std::unique_ptr<::mapbox::sqlite::Statement> getManyStmt, putStmt, refreshStmt, pinStmt;
+    std::unique_ptr<::mapbox::sqlite::Statement> sizeStmt, accessStmt;
+    std::unique_ptr<::mapbox::sqlite::Statement> evictSelectStmt, evictDeleteStmt;
+
+    // Gets that arrived during the current loop iteration; they are answered together once the
+    // queue is drained.
+    std::vector<std::unique_ptr<GetAction>> pendingGets;
+    std::vector<std::unique_ptr<BatchGetAction>> pendingBatchGets;
+
+    // Writes are collected in one transaction that is committed when the timer fires or when
+    // enough writes have accumulated.
+    uv_timer_t *commitTimer = nullptr;
+    bool inTransaction = false;
+    unsigned int pendingWrites = 0;
+
+    // Sum of the `size` column of entries that aren't pinned, and URLs whose access time needs to
+    // be written with the next batch. Both are only used on the cache thread.
+    uint64_t currentSize = 0;
+    std::unordered_set<std::string> accessedURLs;
 };
 
 }
@@ -3,13 +3,20 @@
 
 #include <mbgl/storage/file_source.hpp>
 #include <mbgl/storage/file_cache.hpp>
+#include <mbgl/storage/offline.hpp>
 
+#include <atomic>
+#include <map>
+#include <memory>
 #include <set>
 #include <unordered_map>
+#include <unordered_set>
 #include <thread>
 
 namespace mapbox { namespace util { template<typename... Types> class variant; } }
 
+namespace uv { class worker; }
+
 namespace mbgl {
 
 namespace util { template <typename T> class AsyncQueue; }
@@ -25,13 +32,42 @@ public:
     Request *request(const Resource &resource, uv_loop_t *loop, const Environment &env,
                      Callback callback) override;
     void cancel(Request *request) override;
+    void setPriority(Request *request, double priority) override;
     void request(const Resource &resource, const Environment &env, Callback callback) override;
 
     void abort(const Environment &env) override;
 
+    // Downloads a region into the cache and pins it there. Returns nullptr if this file source has
+    // no cache. The download must be destroyed before the file source.
+    std::unique_ptr<OfflineDownload> downloadRegion(const OfflineRegion &region,
+                                                    OfflineDownload::ProgressCallback progress,
+                                                    OfflineDownload::CompletionCallback completion);
+
+    // Limits the number of HTTP requests that are in flight at the same time. Further requests wait
+    // in a queue until a running request completes. Can be called from any thread.
+    void setMaximumConcurrentRequests(unsigned int maximum);
+    static const unsigned int defaultMaximumConcurrentRequests = 20;
+
+    // Limits the number of connections that are open to the same host. Requests beyond that wait
+    // for a free connection. Takes effect for connections opened afterwards. Can be called from
+    // any thread.
+    void setMaximumConnectionsPerHost(unsigned int maximum);
+    unsigned int getMaximumConnectionsPerHost() const;
+    static const unsigned int defaultMaximumConnectionsPerHost = 6;
+
+    // When enabled, requests that accept stale data get an expired cached response right away
+    // while it is revalidated in the background, and a second response only if the data changed.
+    // Disabled by default. Can be called from any thread.
+    void setStaleWhileRevalidate(bool enabled);
+
     void notify(SharedRequestBase *sharedRequest, const std::set<Request *> &observers,
                 std::shared_ptr<const Response> response, FileCache::Hint hint);
 
+    // The threads that read local files, like assets and MBTiles. Parallel reads from disk overlap
+    // without blocking the file source loop. Only valid in the file source loop.
+    uv::worker &getReaders();
+    static const unsigned int readerThreads = 4;
+
 public:
     const std::string assetRoot;
 
@@ -39,23 +75,57 @@ private:
     struct ActionDispatcher;
     struct AddRequestAction;
     struct RemoveRequestAction;
-    struct ResultAction;
+    struct SetPriorityAction;
+    struct ResultsAction;
     struct StopAction;
     struct AbortAction;
-    using Action = mapbox::util::variant<AddRequestAction, RemoveRequestAction, ResultAction,
-                                         StopAction, AbortAction>;
+    using Action = mapbox::util::variant<AddRequestAction, RemoveRequestAction, SetPriorityAction,
+                                         ResultsAction, StopAction, AbortAction>;
     using Queue = util::AsyncQueue<Action>;
 
     void process(AddRequestAction &action);
     void process(RemoveRequestAction &action);
-    void process(ResultAction &action);
+    void process(SetPriorityAction &action);
+    void process(ResultsAction &action);
     void process(StopAction &action);
     void process(AbortAction &action);
 
     SharedRequestBase *find(const Resource &resource);
 
+    void lookupPendingResources();
+    void stop();
+    void processResult(const Resource &resource, std::unique_ptr<Response> response);
+
+    void startRequest(SharedRequestBase *sharedRequest, std::unique_ptr<Response> response);
+    void startQueuedRequests();
+    void updatePriority(SharedRequestBase *sharedRequest);
+    void removeRequest(SharedRequestBase *sharedRequest);
+
     std::unordered_map<Resource, SharedRequestBase *, Resource::Hash> pending;
 
+    // New requests of the current loop iteration. They are looked up in the cache together once
+    // the queue is drained.
+    std::vector<Resource> pendingLookups;
+
+    // Batches that were handed to the cache and whose results haven't arrived yet. The cache calls
+    // back into the file source, so a stop waits for them.
+    unsigned int activeLookups = 0;
+    bool stopping = false;
+
+    // HTTP requests that are in flight, and those that wait for a free slot together with the
+    // cached response they revalidate. Queued requests are ordered by priority, then by arrival.
+    using QueueKey = std::pair<double, uint64_t>;
+    std::atomic<unsigned int> maximumConcurrentRequests { defaultMaximumConcurrentRequests };
+    std::atomic<unsigned int> maximumConnectionsPerHost { defaultMaximumConnectionsPerHost };
+    std::unordered_set<SharedRequestBase *> activeRequests;
+    std::map<QueueKey, std::pair<SharedRequestBase *, std::unique_ptr<Response>>> queuedRequests;
+    std::unordered_map<SharedRequestBase *, QueueKey> queuedKeys;
+    uint64_t queuedSequence = 0;
+
+    std::atomic<bool> staleWhileRevalidate { false };
+
+    std::unique_ptr<uv::worker> readers;
+
     uv_loop_t *loop = nullptr;
     FileCache *cache = nullptr;
     Queue *queue = nullptr;
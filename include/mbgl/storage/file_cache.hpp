@@ -5,6 +5,7 @@
 
 #include <functional>
 #include <memory>
+#include <vector>
 
 namespace mbgl {
 
@@ -19,7 +20,16 @@ public:
 
     virtual void get(const Resource &resource,
                      std::function<void(std::unique_ptr<Response>)> callback) = 0;
+
+    // Looks up several resources at once. The callback receives one response per resource, in the
+    // same order, with nullptr for resources that aren't stored.
+    using BatchCallback = std::function<void(std::vector<std::unique_ptr<Response>>)>;
+    virtual void get(const std::vector<Resource> &resources, BatchCallback callback) = 0;
     virtual void put(const Resource &resource, std::shared_ptr<const Response> response, Hint hint) = 0;
+
+    // Marks a stored resource as part of an offline region so that eviction never removes it. Later
+    // puts of the same resource keep the mark.
+    virtual void pin(const Resource &resource) = 0;
 };
 
 }
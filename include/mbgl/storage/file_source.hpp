@@ -32,6 +32,10 @@ public:
                              Callback callback) = 0;
     virtual void cancel(Request *request) = 0;
 
+    // Changes the priority of a request that hasn't completed yet; see Resource::priority. Must be
+    // called from the thread the request was created in, and not after canceling it.
+    virtual void setPriority(Request *request, double priority) = 0;
+
     // These can be called from any thread. The callback will be invoked in an arbitrary other thread.
     // You cannot cancel these requests.
     virtual void request(const Resource &resource, const Environment &env, Callback callback) = 0;
@@ -0,0 +1,119 @@
+#ifndef MBGL_STORAGE_OFFLINE
+#define MBGL_STORAGE_OFFLINE
+
+#include <mbgl/storage/resource.hpp>
+#include <mbgl/util/geo.hpp>
+#include <mbgl/util/noncopyable.hpp>
+
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace uv { class async; }
+
+namespace mbgl {
+
+class FileSource;
+class FileCache;
+class Environment;
+class Request;
+class Response;
+class Style;
+
+struct OfflineRegion {
+    // Identifies the region in the cache. Downloading a region with the same name again resumes
+    // where the previous download left off.
+    std::string name;
+
+    std::string styleURL;
+    std::string accessToken;
+    LatLngBounds bounds;
+    double minZoom = 0;
+    double maxZoom = 16;
+    float pixelRatio = 1;
+};
+
+struct OfflineProgress {
+    // Zero until the style and all of its sources have been loaded.
+    uint64_t requiredResources = 0;
+    uint64_t completedResources = 0;
+
+    // Resources that completed with an error. They count as completed and are not retried.
+    uint64_t failedResources = 0;
+
+    // Bytes received during this download, not counting resources completed in earlier runs.
+    uint64_t completedBytes = 0;
+};
+
+// Loads the style, TileJSONs, sprite, glyphs and tiles of a region through the file source and pins
+// them in the cache. Requests run in a thread owned by the download, and the callbacks are invoked
+// in that thread. Destroying the download cancels it; the progress made so far is kept.
+class OfflineDownload : private util::noncopyable {
+public:
+    using ProgressCallback = std::function<void(const OfflineProgress &)>;
+
+    // error is empty when all resources completed. Failed individual resources don't fail the
+    // download.
+    using CompletionCallback = std::function<void(const OfflineProgress &, const std::string &error)>;
+
+    OfflineDownload(FileSource &fileSource, FileCache &cache, const OfflineRegion &region,
+                    ProgressCallback progress, CompletionCallback completion,
+                    unsigned int maximumConcurrentRequests = 8);
+    ~OfflineDownload();
+
+private:
+    // All of these run in the download thread.
+    void loadStyle(const Response &res);
+    void loadedSource();
+    void enumerateResources();
+    void requestResources();
+    void completed(std::size_t index, const Response &res);
+    void saveProgress();
+    void finish(const std::string &error);
+    void terminate();
+
+    FileCache &cache;
+    const OfflineRegion region;
+    const Resource progressResource;
+    const ProgressCallback progressCallback;
+    const CompletionCallback completionCallback;
+    const unsigned int maximumConcurrentRequests;
+
+    std::unique_ptr<Environment> env;
+    std::unique_ptr<uv::async> asyncStart;
+    std::unique_ptr<uv::async> asyncTerminate;
+    std::thread thread;
+
+    // The stored progress of an earlier run, handed over from the cache thread.
+    std::mutex storedMutex;
+    std::condition_variable storedCondition;
+    bool storedLoaded = false;
+    uint64_t storedCompleted = 0;
+    uint64_t storedRequired = 0;
+    uint64_t storedHash = 0;
+
+    std::unique_ptr<Style> style;
+    Request *styleRequest = nullptr;
+    std::vector<Request *> sourceRequests;
+    unsigned int pendingSources = 0;
+
+    // Every resource of the region in a stable order. Everything below `watermark` is done.
+    std::vector<Resource> resources;
+    uint64_t resourcesHash = 0;
+    std::vector<bool> done;
+    std::size_t watermark = 0;
+    std::size_t next = 0;
+    std::unordered_map<std::size_t, Request *> active;
+    OfflineProgress progress;
+    bool finished = false;
+};
+
+}
+
+#endif
@@ -15,9 +15,22 @@ struct Resource {
         JSON = 4,
     };
 
+    Resource(Kind kind_, const std::string &url_, double priority_ = 0, bool acceptsStale_ = false)
+        : kind(kind_), url(url_), priority(priority_), acceptsStale(acceptsStale_) {}
+
     const Kind kind;
     const std::string url;
 
+    // Requests with lower values are started first when the file source limits the number of
+    // concurrent requests. Style, sprite, glyph and TileJSON requests use 0; tiles use one more
+    // than their distance to the viewport center. Doesn't take part in comparisons.
+    const double priority;
+
+    // The requester can handle an expired cached response (see Response::stale) followed by the
+    // revalidated one, or by a confirmation that the data didn't change (Response::notModified).
+    // Only used when the file source serves stale data; doesn't take part in comparisons.
+    const bool acceptsStale;
+
     inline bool operator==(const Resource &res) const {
         return kind == res.kind && url == res.url;
     }
@@ -2,6 +2,7 @@
 #define MBGL_STORAGE_RESPONSE
 
 #include <string>
+#include <memory>
 
 namespace mbgl {
 
@@ -14,7 +15,26 @@ public:
     int64_t modified = 0;
     int64_t expires = 0;
     std::string etag;
-    std::string data;
+
+    // An expired cached response that is delivered while it is revalidated. The request stays
+    // alive until the revalidation finished and its callback is invoked a second time, so it can
+    // still be canceled or re-prioritized in between.
+    bool stale = false;
+
+    // The server confirmed the cached response with a 304. The data is the cached data, and the
+    // cache only updates the expiration date. Consumers that already processed the data can keep
+    // the results. Requesters that got a stale response also get this when the revalidation
+    // returned the same data, or failed.
+    bool notModified = false;
+
+    // The payload is immutable and shared between the cache, the response and its consumers,
+    // so it can be handed along without copying. It is never null.
+    std::shared_ptr<const std::string> data = std::make_shared<const std::string>();
+
+    // The content encoding of the data. Tile data is handed along as the server sent it, e.g.
+    // "gzip", and inflated with util::decompress() by the worker that parses it. All other
+    // responses are always decoded, and this is empty.
+    std::string encoding;
 };
 
 }
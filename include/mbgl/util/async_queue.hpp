@@ -24,8 +24,10 @@ namespace util {
 template <typename T>
 class AsyncQueue {
 public:
-    AsyncQueue(uv_loop_t *loop, std::function<void(T &)> fn) :
-          callback(fn) {
+    // drained_ is optional and called after each run of callbacks once the queue is empty, which
+    // lets the consumer act on everything that arrived during one loop iteration at once.
+    AsyncQueue(uv_loop_t *loop, std::function<void(T &)> fn, std::function<void()> drained_ = nullptr) :
+          callback(fn), drained(drained_) {
         async.data = this;
         uv_async_init(loop, &async, [](UV_ASYNC_PARAMS(handle)) {
             auto q = reinterpret_cast<AsyncQueue *>(handle->data);
@@ -80,6 +82,10 @@ private:
             mutex.unlock();
             callback(*item);
         }
+
+        if (drained) {
+            drained();
+        }
     }
 
 private:
@@ -87,6 +93,7 @@ private:
     uv_async_t async;
     std::queue<std::unique_ptr<T>> queue;
     std::function<void(T &)> callback;
+    std::function<void()> drained;
 };
 
 }
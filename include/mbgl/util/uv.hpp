@@ -3,6 +3,7 @@
 
 #include <string>
 #include <memory>
+#include <stdexcept>
 
 typedef struct uv_handle_s uv_handle_t;
 typedef struct uv_async_s uv_async_t;
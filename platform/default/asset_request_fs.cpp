@@ -3,6 +3,7 @@
 #include <mbgl/util/std.hpp>
 #include <mbgl/util/util.hpp>
 #include <mbgl/util/uv.hpp>
+#include <mbgl/util/uv_detail.hpp>
 
 #include <uv.h>
 
@@ -14,34 +15,74 @@
 #include <boost/algorithm/string.hpp>
 #pragma GCC diagnostic pop
 
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
 #include <cassert>
+#include <cerrno>
+#include <cstring>
 
 
 namespace algo = boost::algorithm;
 
 namespace mbgl {
 
+namespace {
+
+// Returns the message libuv reports for an errno value, so that errors read the same as they did
+// when files were read through uv_fs.
+const char *errorMessage(int err) {
+#if UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR <= 10
+    uv_err_code code = UV_UNKNOWN;
+    switch (err) {
+        case ENOENT: code = UV_ENOENT; break;
+        case EACCES: code = UV_EACCES; break;
+        case EPERM: code = UV_EPERM; break;
+        case EISDIR: code = UV_EISDIR; break;
+        case ENOTDIR: code = UV_ENOTDIR; break;
+        case ENAMETOOLONG: code = UV_ENAMETOOLONG; break;
+        case ELOOP: code = UV_ELOOP; break;
+        case EMFILE: code = UV_EMFILE; break;
+        case ENFILE: code = UV_ENFILE; break;
+        case ENOMEM: code = UV_ENOMEM; break;
+        case EBADF: code = UV_EBADF; break;
+        case EINVAL: code = UV_EINVAL; break;
+        case EAGAIN: code = UV_EAGAIN; break;
+        case EBUSY: code = UV_EBUSY; break;
+        case ENODEV: code = UV_ENODEV; break;
+        case EIO: code = UV_EIO; break;
+        case EFBIG: code = UV_EFBIG; break;
+    }
+    return uv_strerror(uv_err_t { code, err });
+#else
+    // libuv error codes are negated errno values on this platform.
+    return uv_strerror(-err);
+#endif
+}
+
+}
+
 class AssetRequestImpl {
     MBGL_STORE_THREAD(tid)
 
 public:
-    AssetRequestImpl(AssetRequest *request, uv_loop_t *loop);
+    AssetRequestImpl(AssetRequest *request, uv::worker &readers);
     ~AssetRequestImpl();
 
-    static void fileOpened(uv_fs_t *req);
-    static void fileStated(uv_fs_t *req);
-    static void fileRead(uv_fs_t *req);
-    static void fileClosed(uv_fs_t *req);
-    static void notifyError(uv_fs_t *req);
-    static void cleanup(uv_fs_t *req);
-
+    static void work(void *data);
+    static void afterWork(void *data, int status);
 
     AssetRequest *request = nullptr;
-    bool canceled = false;
-    uv_fs_t req;
-    uv_file fd = -1;
-    uv_buf_t buffer;
+    uv::worker &readers;
+    uv_worker_item_t *item = nullptr;
+
+    // Only touched by the reader thread until afterWork runs.
+    std::string path;
     std::unique_ptr<Response> response;
+
+private:
+    void read();
 };
 
 AssetRequestImpl::~AssetRequestImpl() {
@@ -52,11 +93,9 @@ AssetRequestImpl::~AssetRequestImpl() {
     }
 }
 
-AssetRequestImpl::AssetRequestImpl(AssetRequest *request_, uv_loop_t *loop) : request(request_) {
-    req.data = this;
-
+AssetRequestImpl::AssetRequestImpl(AssetRequest *request_, uv::worker &readers_)
+    : request(request_), readers(readers_) {
     const auto &url = request->resource.url;
-    std::string path;
     if (url.size() <= 8 || url[8] == '/') {
         // This is an empty or absolute path.
         path = url.substr(8);
@@ -65,143 +104,77 @@ AssetRequestImpl::AssetRequestImpl(AssetRequest *request_, uv_loop_t *loop) : re
         path = request->source->assetRoot + "/" + url.substr(8);
     }
 
-    uv_fs_open(loop, &req, path.c_str(), O_RDONLY, S_IRUSR, fileOpened);
+    item = readers.add(this, request->priority(), work, afterWork);
 }
 
-void AssetRequestImpl::fileOpened(uv_fs_t *req) {
-    assert(req->data);
-    auto self = reinterpret_cast<AssetRequestImpl *>(req->data);
-    MBGL_VERIFY_THREAD(self->tid);
+void AssetRequestImpl::work(void *data) {
+    reinterpret_cast<AssetRequestImpl *>(data)->read();
+}
 
-    if (req->result < 0) {
-        // Opening failed or was canceled. There isn't much left we can do.
-        notifyError(req);
-        cleanup(req);
-    } else {
-        const uv_file fd = uv_file(req->result);
+void AssetRequestImpl::read() {
+    response = util::make_unique<Response>();
 
-        // We're going to reuse this handle, so we need to cleanup first.
-        uv_fs_req_cleanup(req);
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        response->status = Response::Error;
+        response->message = errorMessage(errno);
+        return;
+    }
 
-        if (self->canceled) {
-            // The request was canceled.
-            uv_fs_close(req->loop, req, fd, fileClosed);
-        } else {
-            self->fd = fd;
-            uv_fs_fstat(req->loop, req, fd, fileStated);
+    struct stat info;
+    int err = 0;
+    if (fstat(fd, &info) != 0) {
+        err = errno;
+    } else if (S_ISDIR(info.st_mode)) {
+        err = EISDIR;
+    } else {
+        // Read straight into the buffer that the response is going to hand out.
+        auto data = std::make_shared<std::string>(std::size_t(info.st_size), '\0');
+        std::size_t offset = 0;
+        while (offset < data->size()) {
+            const ssize_t result = pread(fd, &(*data)[offset], data->size() - offset, off_t(offset));
+            if (result < 0 && errno == EINTR) {
+                continue;
+            } else if (result < 0) {
+                err = errno;
+                break;
+            } else if (result == 0) {
+                // The file was truncated while we were reading it.
+                data->resize(offset);
+                break;
+            }
+            offset += std::size_t(result);
         }
+        response->data = std::move(data);
     }
-}
-
-void AssetRequestImpl::fileStated(uv_fs_t *req) {
-    assert(req->data);
-    auto self = reinterpret_cast<AssetRequestImpl *>(req->data);
-    MBGL_VERIFY_THREAD(self->tid);
 
-    if (req->result != 0 || self->canceled) {
-        // Stating failed or was canceled. We already have an open file handle
-        // though, which we'll have to close.
-        notifyError(req);
+    close(fd);
 
-        uv_fs_req_cleanup(req);
-        uv_fs_close(req->loop, req, self->fd, fileClosed);
+    if (err) {
+        response = util::make_unique<Response>();
+        response->status = Response::Error;
+        response->message = errorMessage(err);
     } else {
-#if UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR <= 10
-        auto stat = static_cast<const uv_statbuf_t *>(req->ptr);
-#else
-        auto stat = static_cast<const uv_stat_t *>(req->ptr);
-#endif
-        if (stat->st_size > std::numeric_limits<int>::max()) {
-            // File is too large for us to open this way because uv_buf's only support unsigned
-            // ints as maximum size.
-            auto response = util::make_unique<Response>();
-            response->status = Response::Error;
-#if UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR <= 10
-            response->message = uv_strerror(uv_err_t {UV_EFBIG, 0});
-#else
-            response->message = uv_strerror(UV_EFBIG);
-#endif
-            assert(self->request);
-            self->request->notify(std::move(response), FileCache::Hint::No);
-            delete self->request;
-
-            uv_fs_req_cleanup(req);
-            uv_fs_close(req->loop, req, self->fd, fileClosed);
-        } else {
-            self->response = util::make_unique<Response>();
+        response->status = Response::Successful;
 #ifdef __APPLE__
-            self->response->modified = stat->st_mtimespec.tv_sec;
-#else
-            self->response->modified = stat->st_mtime;
-#endif
-            self->response->etag = std::to_string(stat->st_ino);
-            const auto size = (unsigned int)(stat->st_size);
-            self->response->data.resize(size);
-            self->buffer = uv_buf_init(const_cast<char *>(self->response->data.data()), size);
-            uv_fs_req_cleanup(req);
-#if UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR <= 10
-            uv_fs_read(req->loop, req, self->fd, self->buffer.base, self->buffer.len, -1, fileRead);
+        response->modified = info.st_mtimespec.tv_sec;
 #else
-            uv_fs_read(req->loop, req, self->fd, &self->buffer, 1, 0, fileRead);
+        response->modified = info.st_mtime;
 #endif
-        }
+        response->etag = std::to_string(info.st_ino);
     }
 }
 
-void AssetRequestImpl::fileRead(uv_fs_t *req) {
-    assert(req->data);
-    auto self = reinterpret_cast<AssetRequestImpl *>(req->data);
+void AssetRequestImpl::afterWork(void *data, int) {
+    auto self = reinterpret_cast<AssetRequestImpl *>(data);
     MBGL_VERIFY_THREAD(self->tid);
 
-    if (req->result < 0 || self->canceled) {
-        // Stating failed or was canceled. We already have an open file handle
-        // though, which we'll have to close.
-        notifyError(req);
-    } else {
-        // File was successfully read.
-        self->response->status = Response::Successful;
-        assert(self->request);
+    // The request is gone if it was canceled. Canceled items that hadn't started have no response.
+    if (self->request && self->response) {
         self->request->notify(std::move(self->response), FileCache::Hint::No);
         delete self->request;
     }
 
-    uv_fs_req_cleanup(req);
-    uv_fs_close(req->loop, req, self->fd, fileClosed);
-}
-
-void AssetRequestImpl::fileClosed(uv_fs_t *req) {
-    assert(req->data);
-    auto self = reinterpret_cast<AssetRequestImpl *>(req->data);
-    MBGL_VERIFY_THREAD(self->tid);
-    (void(self)); // Silence unused variable error in Release mode
-
-    if (req->result < 0) {
-        // Closing the file failed. But there isn't anything we can do.
-    }
-
-    cleanup(req);
-}
-
-void AssetRequestImpl::notifyError(uv_fs_t *req) {
-    assert(req->data);
-    auto self = reinterpret_cast<AssetRequestImpl *>(req->data);
-    MBGL_VERIFY_THREAD(self->tid);
-
-    if (req->result < 0 && !self->canceled && req->result != UV_ECANCELED) {
-        auto response = util::make_unique<Response>();
-        response->status = Response::Error;
-        response->message = uv::getFileRequestError(req);
-        assert(self->request);
-        self->request->notify(std::move(response), FileCache::Hint::No);
-        delete self->request;
-    }
-}
-
-void AssetRequestImpl::cleanup(uv_fs_t *req) {
-    assert(req->data);
-    auto self = reinterpret_cast<AssetRequestImpl *>(req->data);
-    MBGL_VERIFY_THREAD(self->tid);
-    uv_fs_req_cleanup(req);
     delete self;
 }
 
@@ -220,14 +193,14 @@ AssetRequest::~AssetRequest() {
     }
 }
 
-void AssetRequest::start(uv_loop_t *loop, std::unique_ptr<Response> response) {
+void AssetRequest::start(uv_loop_t *, std::unique_ptr<Response> response) {
     MBGL_VERIFY_THREAD(tid);
 
     // We're ignoring the existing response if any.
     (void(response));
 
     assert(!ptr);
-    ptr = new AssetRequestImpl(this, loop);
+    ptr = new AssetRequestImpl(this, source->getReaders());
     // Note: the AssetRequestImpl deletes itself.
 }
 
@@ -235,17 +208,13 @@ void AssetRequest::cancel() {
     MBGL_VERIFY_THREAD(tid);
 
     if (ptr) {
-        reinterpret_cast<AssetRequestImpl *>(ptr)->canceled = true;
-
-        // uv_cancel fails frequently when the request has already been started.
-        // In that case, we have to let it complete and check the canceled bool
-        // instead. The cancelation callback will delete the AssetRequest object.
-        uv_cancel((uv_req_t *)&reinterpret_cast<AssetRequestImpl *>(ptr)->req);
-    } else {
-        // This request is canceled before we called start. We're safe to delete
-        // ourselves now.
-        delete this;
+        // A read that already started completes, but nobody is notified. Either way,
+        // afterWork() cleans up the AssetRequestImpl.
+        auto impl = reinterpret_cast<AssetRequestImpl *>(ptr);
+        impl->readers.cancel(impl->item);
     }
+
+    delete this;
 }
 
 }
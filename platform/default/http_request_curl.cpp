@@ -1,5 +1,6 @@
 #include <mbgl/storage/default/http_request.hpp>
 #include <mbgl/storage/default/http_context.hpp>
+#include <mbgl/storage/default_file_source.hpp>
 #include <mbgl/storage/response.hpp>
 #include <mbgl/platform/log.hpp>
 
@@ -15,8 +16,10 @@
 
 #include <queue>
 #include <map>
+#include <mutex>
 #include <cassert>
 #include <cstring>
+#include <cstdlib>
 
 void handleError(CURLMcode code) {
     if (code != CURLM_OK) {
@@ -69,9 +72,13 @@ public:
     static void onTimeout(uv_timer_t *req);
 #endif
 
+    static void lockShare(CURL *handle, curl_lock_data data, curl_lock_access access, void *userp);
+    static void unlockShare(CURL *handle, curl_lock_data data, void *userp);
+
     CURL *getHandle();
     void returnHandle(CURL *handle);
     void checkMultiInfo();
+    void setMaximumConnectionsPerHost(unsigned int maximum);
 
 public:
     // Used as the CURL timer function to periodically check for socket updates.
@@ -81,9 +88,21 @@ public:
     // block and spawn threads.
     CURLM *multi = nullptr;
 
-    // CURL share handles are used for sharing session state (e.g.)
+    // CURL share handles are used for sharing session state (e.g. DNS lookups, TLS sessions and
+    // open connections) between all easy handles of this context.
     CURLSH *share = nullptr;
 
+    // Guards the data kinds in the share handle. Only the context's thread uses the share handle
+    // today, but libcurl requires the callbacks for sharing connections safely.
+    std::mutex shareMutexes[CURL_LOCK_DATA_LAST];
+
+    // Whether libcurl was built with HTTP/2 support. Requests to hosts that support it are
+    // multiplexed over a single connection.
+    bool http2 = false;
+
+    // The limit that is currently set on the multi handle; 0 means there is none.
+    unsigned int maximumConnectionsPerHost = 0;
+
     // A queue that we use for storing resuable CURL easy handles to avoid creating and destroying
     // them all the time.
     std::queue<CURL *> handles;
@@ -124,6 +143,12 @@ private:
     // In case of revalidation requests, this will store the old response.
     std::unique_ptr<Response> existingResponse;
 
+    // Accumulates the body. It is handed to the response without copying once the request is done.
+    std::string data;
+
+    // Tile bodies are kept compressed; see Response::encoding.
+    const bool keepEncoding;
+
     CURL *handle = nullptr;
     curl_slist *headers = nullptr;
 
@@ -187,12 +212,29 @@ HTTPCURLContext::HTTPCURLContext(uv_loop_t *loop_) : HTTPContext(loop_) {
     uv_timer_init(loop, timeout);
 
     share = curl_share_init();
+    curl_share_setopt(share, CURLSHOPT_LOCKFUNC, lockShare);
+    curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, unlockShare);
+    curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900 // 7.57.0
+    curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+
+#if LIBCURL_VERSION_NUM >= 0x072100 // 7.33.0
+    http2 = curl_version_info(CURLVERSION_NOW)->features & CURL_VERSION_HTTP2;
+#endif
 
     multi = curl_multi_init();
     handleError(curl_multi_setopt(multi, CURLMOPT_SOCKETFUNCTION, handleSocket));
     handleError(curl_multi_setopt(multi, CURLMOPT_SOCKETDATA, this));
     handleError(curl_multi_setopt(multi, CURLMOPT_TIMERFUNCTION, startTimeout));
     handleError(curl_multi_setopt(multi, CURLMOPT_TIMERDATA, this));
+#if LIBCURL_VERSION_NUM >= 0x072b00 // 7.43.0
+    if (http2) {
+        handleError(curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX));
+    }
+#endif
 }
 
 HTTPCURLContext::~HTTPCURLContext() {
@@ -206,6 +248,30 @@ HTTPCURLContext::~HTTPCURLContext() {
     uv::close(timeout);
 }
 
+void HTTPCURLContext::setMaximumConnectionsPerHost(unsigned int maximum) {
+    MBGL_VERIFY_THREAD(tid);
+
+    if (maximum == maximumConnectionsPerHost) {
+        return;
+    }
+    maximumConnectionsPerHost = maximum;
+#if LIBCURL_VERSION_NUM >= 0x071e00 // 7.30.0
+    // Opening dozens of TLS connections to the same tile host during fast zooms costs more than
+    // waiting for a free connection. DefaultFileSource limits the total number of requests.
+    handleError(curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, long(maximum)));
+#endif
+}
+
+void HTTPCURLContext::lockShare(CURL * /* handle */, curl_lock_data data, curl_lock_access /* access */, void *userp) {
+    assert(userp);
+    reinterpret_cast<HTTPCURLContext *>(userp)->shareMutexes[data].lock();
+}
+
+void HTTPCURLContext::unlockShare(CURL * /* handle */, curl_lock_data data, void *userp) {
+    assert(userp);
+    reinterpret_cast<HTTPCURLContext *>(userp)->shareMutexes[data].unlock();
+}
+
 CURL *HTTPCURLContext::getHandle() {
     if (!handles.empty()) {
         auto handle = handles.front();
@@ -428,9 +494,13 @@ HTTPRequestImpl::HTTPRequestImpl(HTTPRequest *request_, uv_loop_t *loop, std::un
     : context(HTTPCURLContext::Get(loop)),
       request(request_),
       existingResponse(std::move(response_)),
+      keepEncoding(request_->resource.kind == Resource::Tile),
       handle(context->getHandle()) {
     assert(request);
     context->addRequest(request);
+    context->setMaximumConnectionsPerHost(request->source
+        ? request->source->getMaximumConnectionsPerHost()
+        : DefaultFileSource::defaultMaximumConnectionsPerHost);
 
     // Zero out the error buffer.
     memset(error, 0, sizeof(error));
@@ -466,9 +536,26 @@ HTTPRequestImpl::HTTPRequestImpl(HTTPRequest *request_, uv_loop_t *loop, std::un
     handleError(curl_easy_setopt(handle, CURLOPT_WRITEDATA, this));
     handleError(curl_easy_setopt(handle, CURLOPT_HEADERFUNCTION, headerCallback));
     handleError(curl_easy_setopt(handle, CURLOPT_HEADERDATA, this));
-    handleError(curl_easy_setopt(handle, CURLOPT_ACCEPT_ENCODING, "gzip, deflate"));
+    if (keepEncoding) {
+        // Tiles are stored and handed to the tile workers compressed. They inflate the data in
+        // parallel, instead of curl doing it here and the cache compressing it again.
+        handleError(curl_easy_setopt(handle, CURLOPT_ACCEPT_ENCODING, "gzip"));
+        handleError(curl_easy_setopt(handle, CURLOPT_HTTP_CONTENT_DECODING, 0L));
+    } else {
+        handleError(curl_easy_setopt(handle, CURLOPT_ACCEPT_ENCODING, "gzip, deflate"));
+        handleError(curl_easy_setopt(handle, CURLOPT_HTTP_CONTENT_DECODING, 1L));
+    }
     handleError(curl_easy_setopt(handle, CURLOPT_USERAGENT, "MapboxGL/1.0"));
     handleError(curl_easy_setopt(handle, CURLOPT_SHARE, context->share));
+#if LIBCURL_VERSION_NUM >= 0x072f00 // 7.47.0
+    if (context->http2) {
+        // Negotiates HTTP/2 over TLS and keeps HTTP/1.1 for plain connections.
+        handleError(curl_easy_setopt(handle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS));
+        // Waits for an existing connection to the host to be confirmed as multiplexing-capable
+        // instead of opening a new one.
+        handleError(curl_easy_setopt(handle, CURLOPT_PIPEWAIT, 1L));
+    }
+#endif
 
     start();
 }
@@ -520,11 +607,7 @@ size_t HTTPRequestImpl::writeCallback(void *const contents, const size_t size, c
     auto impl = reinterpret_cast<HTTPRequestImpl *>(userp);
     MBGL_VERIFY_THREAD(impl->tid);
 
-    if (!impl->response) {
-        impl->response = util::make_unique<Response>();
-    }
-
-    impl->response->data.append((char *)contents, size * nmemb);
+    impl->data.append((char *)contents, size * nmemb);
     return size * nmemb;
 }
 
@@ -570,7 +653,12 @@ size_t HTTPRequestImpl::headerCallback(char *const buffer, const size_t size, co
 
     const size_t length = size * nmemb;
     size_t begin = std::string::npos;
-    if ((begin = headerMatches("last-modified: ", buffer, length)) != std::string::npos) {
+    if (headerMatches("http/", buffer, length) != std::string::npos) {
+        // The status line of another response, e.g. the one a redirect leads to. The headers of
+        // the previous response don't apply to it.
+        baton->response = util::make_unique<Response>();
+        baton->data.clear();
+    } else if ((begin = headerMatches("last-modified: ", buffer, length)) != std::string::npos) {
         // Always overwrite the modification date; We might already have a value here from the
         // Date header, but this one is more accurate.
         const std::string value { buffer + begin, length - begin - 2 }; // remove \r\n
@@ -583,6 +671,19 @@ size_t HTTPRequestImpl::headerCallback(char *const buffer, const size_t size, co
     } else if ((begin = headerMatches("expires: ", buffer, length)) != std::string::npos) {
         const std::string value { buffer + begin, length - begin - 2 }; // remove \r\n
         baton->response->expires = curl_getdate(value.c_str(), nullptr);
+    } else if ((begin = headerMatches("content-encoding: ", buffer, length)) != std::string::npos) {
+        // Only set when curl doesn't decode the body. Tiles only ask for gzip, and that's the only
+        // encoding that util::decompress() handles; others, like identity, are passed on as is.
+        if (baton->keepEncoding &&
+            headerMatches("gzip\r\n", buffer + begin, length - begin) != std::string::npos) {
+            baton->response->encoding = "gzip";
+        }
+    } else if ((begin = headerMatches("content-length: ", buffer, length)) != std::string::npos) {
+        // Allocate the body buffer up front to avoid reallocations while receiving it.
+        const unsigned long long contentLength = std::strtoull(buffer + begin, nullptr, 10);
+        if (contentLength < (64 << 20)) {
+            baton->data.reserve(contentLength);
+        }
     }
 
     return length;
@@ -593,6 +694,7 @@ void HTTPRequestImpl::retry(uint64_t timeout) {
     handleError(curl_multi_remove_handle(context->multi, handle));
 
     response.reset();
+    data.clear();
 
     assert(!timer);
     timer = new uv_timer_t;
@@ -641,6 +743,7 @@ void HTTPRequestImpl::finish(ResponseStatus status) {
     if (status == ResponseStatus::NotModified) {
         request->notify(std::move(response), FileCache::Hint::Refresh);
     } else {
+        response->data = std::make_shared<const std::string>(std::move(data));
         request->notify(std::move(response), FileCache::Hint::Full);
     }
 
@@ -693,6 +796,7 @@ void HTTPRequestImpl::handleResult(CURLcode code) {
                 if (existingResponse->expires) {
                     response->expires = existingResponse->expires;
                 }
+                response->notModified = true;
                 return finish(ResponseStatus::NotModified);
             } else {
                 // This is an unsolicited 304 response and should only happen on malfunctioning
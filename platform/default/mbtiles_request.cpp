@@ -0,0 +1,327 @@
+#include <mbgl/storage/default/mbtiles_request.hpp>
+#include <mbgl/storage/response.hpp>
+#include <mbgl/util/std.hpp>
+#include <mbgl/util/util.hpp>
+#include <mbgl/util/uv.hpp>
+#include <mbgl/util/uv_detail.hpp>
+
+#include "sqlite3.hpp"
+
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <uv.h>
+#include <pthread.h>
+
+#pragma GCC diagnostic push
+#ifndef __clang__
+#pragma GCC diagnostic ignored "-Wunused-local-typedefs"
+#pragma GCC diagnostic ignored "-Wshadow"
+#endif
+#include <boost/algorithm/string.hpp>
+#pragma GCC diagnostic pop
+
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace algo = boost::algorithm;
+
+namespace mbgl {
+
+namespace {
+
+using namespace mapbox::sqlite;
+
+// An open MBTiles file with its prepared tile query.
+class Connection {
+public:
+    Connection(const std::string &path)
+        : db(open(path)),
+          tileStatement(db.prepare(
+              "SELECT `tile_data` FROM `tiles` "
+              "WHERE `zoom_level` = ? AND `tile_column` = ? AND `tile_row` = ? LIMIT 1")) {}
+
+    // Every reader thread keeps its own connections, so lookups run in parallel without sharing
+    // statements. They're closed when the thread exits.
+    static Connection &Get(const std::string &path) {
+        static pthread_once_t store_once = PTHREAD_ONCE_INIT;
+        static pthread_key_t store_key;
+
+        // Create the key.
+        pthread_once(&store_once, []() {
+            pthread_key_create(&store_key, [](void *ptr) {
+                delete reinterpret_cast<Map *>(ptr);
+            });
+        });
+
+        Map *connections = reinterpret_cast<Map *>(pthread_getspecific(store_key));
+        if (connections == nullptr) {
+            connections = new Map();
+            pthread_setspecific(store_key, connections);
+        }
+
+        auto it = connections->find(path);
+        if (it == connections->end()) {
+            it = connections->emplace(path, util::make_unique<Connection>(path)).first;
+        }
+        return *it->second;
+    }
+
+    static Database open(const std::string &path) {
+        Database result { path, ReadOnly | NoMutex };
+        // Reads are served from a mapping of the file instead of being copied into SQLite's page
+        // cache first. SQLite caps this at the compiled-in maximum.
+        result.exec("PRAGMA mmap_size = 1073741824");
+        return result;
+    }
+
+    // The statement has to be finalized before the database is closed.
+    Database db;
+    Statement tileStatement;
+
+private:
+    using Map = std::map<std::string, std::unique_ptr<Connection>>;
+};
+
+void writeNumbers(rapidjson::Writer<rapidjson::StringBuffer> &writer, const char *name,
+                  const std::string &value, std::size_t count) {
+    std::vector<std::string> parts;
+    algo::split(parts, value, algo::is_any_of(","));
+    if (parts.size() != count) {
+        return;
+    }
+
+    writer.String(name);
+    writer.StartArray();
+    for (const auto &part : parts) {
+        writer.Double(std::strtod(part.c_str(), nullptr));
+    }
+    writer.EndArray();
+}
+
+// Converts the metadata table to TileJSON, so that sources can refer to MBTiles files like they
+// refer to any other TileJSON URL.
+std::string readTileJSON(Connection &connection, const std::string &url) {
+    Statement stmt = connection.db.prepare("SELECT `name`, `value` FROM `metadata`");
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    writer.StartObject();
+    writer.String("tilejson");
+    writer.String("2.1.0");
+    writer.String("scheme");
+    writer.String("xyz");
+
+    // The metadata may repeat a key in the "json" value; the rows take precedence.
+    rapidjson::Document json;
+    std::set<std::string> written;
+    while (stmt.run()) {
+        const std::string name = stmt.get<std::string>(0);
+        const std::string value = stmt.get<std::string>(1);
+        if (name == "json") {
+            json.Parse<0>(value.c_str());
+        } else if (name == "minzoom" || name == "maxzoom") {
+            writer.String(name.c_str());
+            writer.Uint(unsigned(std::strtoul(value.c_str(), nullptr, 10)));
+        } else if (name == "bounds") {
+            writeNumbers(writer, "bounds", value, 4);
+        } else if (name == "center") {
+            writeNumbers(writer, "center", value, 3);
+        } else if (name != "tiles" && name != "tilejson" && name != "scheme") {
+            writer.String(name.c_str());
+            writer.String(value.c_str(), rapidjson::SizeType(value.size()));
+        } else {
+            continue;
+        }
+        written.insert(name);
+    }
+
+    if (!json.HasParseError() && json.IsObject()) {
+        // Vector tilesets describe their layers in here.
+        for (auto it = json.MemberBegin(); it != json.MemberEnd(); ++it) {
+            const std::string name { it->name.GetString(), it->name.GetStringLength() };
+            if (name != "tiles" && !written.count(name)) {
+                writer.String(name.c_str());
+                it->value.Accept(writer);
+            }
+        }
+    }
+
+    writer.String("tiles");
+    writer.StartArray();
+    const std::string tiles = url + "/{z}/{x}/{y}";
+    writer.String(tiles.c_str(), rapidjson::SizeType(tiles.size()));
+    writer.EndArray();
+    writer.EndObject();
+
+    return buffer.GetString();
+}
+
+}
+
+class MBTilesRequestImpl {
+    MBGL_STORE_THREAD(tid)
+
+public:
+    MBTilesRequestImpl(MBTilesRequest *request, uv::worker &readers);
+    ~MBTilesRequestImpl();
+
+    static void work(void *data);
+    static void afterWork(void *data, int status);
+
+    MBTilesRequest *request = nullptr;
+    uv::worker &readers;
+    uv_worker_item_t *item = nullptr;
+
+    // Only touched by the reader thread until afterWork runs.
+    std::string path;
+    std::string url;
+    bool tile = false;
+    unsigned z = 0, x = 0, y = 0;
+    std::unique_ptr<Response> response;
+};
+
+MBTilesRequestImpl::MBTilesRequestImpl(MBTilesRequest *request_, uv::worker &readers_)
+    : request(request_), readers(readers_) {
+    const std::string &resourceURL = request->resource.url;
+    const auto extension = resourceURL.rfind(".mbtiles");
+    if (extension != std::string::npos && extension + 8 < resourceURL.size()) {
+        // This is a tile URL.
+        int end = 0;
+        const std::string suffix = resourceURL.substr(extension + 8);
+        tile = std::sscanf(suffix.c_str(), "/%u/%u/%u%n", &z, &x, &y, &end) == 3 &&
+               std::size_t(end) == suffix.size();
+        url = resourceURL.substr(0, extension + 8);
+    } else {
+        url = resourceURL;
+    }
+
+    if (url.size() <= 10 || url[10] == '/') {
+        // This is an empty or absolute path.
+        path = url.substr(10);
+    } else {
+        // This is a relative path. Prefix with the application root.
+        path = request->source->assetRoot + "/" + url.substr(10);
+    }
+
+    if (url != resourceURL && !tile) {
+        response = util::make_unique<Response>();
+        response->status = Response::Error;
+        response->message = "Invalid MBTiles URL";
+    }
+
+    item = readers.add(this, request->priority(), work, afterWork);
+}
+
+MBTilesRequestImpl::~MBTilesRequestImpl() {
+    MBGL_VERIFY_THREAD(tid);
+
+    if (request) {
+        request->ptr = nullptr;
+    }
+}
+
+void MBTilesRequestImpl::work(void *data) {
+    auto self = reinterpret_cast<MBTilesRequestImpl *>(data);
+    if (self->response) {
+        return;
+    }
+
+    auto response = util::make_unique<Response>();
+    try {
+        Connection &connection = Connection::Get(self->path);
+        if (!self->tile) {
+            response->data = std::make_shared<const std::string>(readTileJSON(connection, self->url));
+            response->status = Response::Successful;
+        } else if (self->z >= 32 || self->y >= (1u << self->z)) {
+            response->status = Response::Error;
+            response->message = "Tile coordinates are out of range";
+        } else {
+            Statement &stmt = connection.tileStatement;
+            stmt.reset();
+            stmt.bind(1, int(self->z));
+            stmt.bind(2, int64_t(self->x));
+            // MBTiles rows count from the bottom (TMS).
+            stmt.bind(3, int64_t((1u << self->z) - 1 - self->y));
+            if (stmt.run()) {
+                // The blob points into the mapped file. It's copied once, into the response.
+                std::size_t size = 0;
+                const char *blob = stmt.getBlob(0, size);
+                response->data = std::make_shared<const std::string>(blob, size);
+                response->status = Response::Successful;
+
+                // Vector tiles are usually stored gzipped. The tile worker inflates them.
+                if (size >= 2 && uint8_t(blob[0]) == 0x1F && uint8_t(blob[1]) == 0x8B) {
+                    response->encoding = "gzip";
+                }
+            } else {
+                response->status = Response::Error;
+                response->message = "Tile not found";
+            }
+            stmt.reset();
+        }
+    } catch (const std::exception &ex) {
+        response->status = Response::Error;
+        response->message = ex.what();
+    }
+    self->response = std::move(response);
+}
+
+void MBTilesRequestImpl::afterWork(void *data, int) {
+    auto self = reinterpret_cast<MBTilesRequestImpl *>(data);
+    MBGL_VERIFY_THREAD(self->tid);
+
+    // The request is gone if it was canceled.
+    if (self->request && self->response) {
+        self->request->notify(std::move(self->response), FileCache::Hint::No);
+        delete self->request;
+    }
+
+    delete self;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+MBTilesRequest::MBTilesRequest(DefaultFileSource *source_, const Resource &resource_)
+    : SharedRequestBase(source_, resource_) {
+    assert(algo::starts_with(resource.url, "mbtiles://"));
+}
+
+MBTilesRequest::~MBTilesRequest() {
+    MBGL_VERIFY_THREAD(tid);
+
+    if (ptr) {
+        reinterpret_cast<MBTilesRequestImpl *>(ptr)->request = nullptr;
+    }
+}
+
+void MBTilesRequest::start(uv_loop_t *, std::unique_ptr<Response> response) {
+    MBGL_VERIFY_THREAD(tid);
+
+    // MBTiles files are local and never cached.
+    (void(response));
+
+    assert(!ptr);
+    ptr = new MBTilesRequestImpl(this, source->getReaders());
+    // Note: the MBTilesRequestImpl deletes itself.
+}
+
+void MBTilesRequest::cancel() {
+    MBGL_VERIFY_THREAD(tid);
+
+    if (ptr) {
+        // The lookup may be running already. If not, this keeps it from starting; either way,
+        // afterWork() cleans up the MBTilesRequestImpl.
+        auto impl = reinterpret_cast<MBTilesRequestImpl *>(ptr);
+        impl->readers.cancel(impl->item);
+    }
+
+    delete this;
+}
+
+}
@@ -24,13 +24,16 @@ Database::Database(const std::string &filename, int flags) {
     const int err = sqlite3_open_v2(filename.c_str(), &db, flags, nullptr);
     if (err != SQLITE_OK) {
         Exception ex { err, sqlite3_errmsg(db) };
+        // A handle is allocated even when opening fails.
+        sqlite3_close(db);
         db = nullptr;
         throw ex;
     }
 }
 
-Database::Database(Database &&other)
-    : db(std::move(other.db)) {}
+Database::Database(Database &&other) {
+    std::swap(db, other.db);
+}
 
 Database &Database::operator=(Database &&other) {
     std::swap(db, other.db);
@@ -170,6 +173,13 @@ template <> std::string Statement::get(int offset) {
     };
 }
 
+const char *Statement::getBlob(int offset, std::size_t &size) {
+    assert(stmt);
+    const char *blob = reinterpret_cast<const char *>(sqlite3_column_blob(stmt, offset));
+    size = size_t(sqlite3_column_bytes(stmt, offset));
+    return blob;
+}
+
 void Statement::reset() {
     assert(stmt);
     sqlite3_reset(stmt);
@@ -63,6 +63,10 @@ public:
     void bind(int offset, const std::string &value, bool retain = true);
     template <typename T> T get(int offset);
 
+    // Returns a pointer to the blob in the current row without copying it. The pointer is only
+    // valid until the statement is stepped or reset.
+    const char *getBlob(int offset, std::size_t &size);
+
     bool run();
     void reset();
 
@@ -3,6 +3,7 @@
 #include <mbgl/storage/response.hpp>
 
 #include <mbgl/util/util.hpp>
+#include <mbgl/util/uv.hpp>
 #include <mbgl/util/async_queue.hpp>
 #include <mbgl/util/variant.hpp>
 #include <mbgl/util/compression.hpp>
@@ -12,7 +13,53 @@
 
 #include <uv.h>
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+
+#if UV_VERSION_MAJOR == 0 && UV_VERSION_MINOR <= 10
+#define UV_TIMER_PARAMS(timer) uv_timer_t *timer, int
+#else
+#define UV_TIMER_PARAMS(timer) uv_timer_t *timer
+#endif
+
+namespace {
+
+// Writes are committed at most this many milliseconds after the first write of a batch, or as
+// soon as this many writes have accumulated, whichever comes first.
+const uint64_t commitDelay = 50;
+const unsigned int maxPendingWrites = 256;
+
+// Access times are only rewritten when the stored one is older than this many seconds; LRU
+// eviction doesn't need finer resolution.
+const int64_t accessGranularity = 300;
+
+// Upper bounds for the work done by one eviction round, so that shrinking a large cache doesn't
+// stall gets and puts queued behind it.
+const int evictionBatchSize = 64;
+const int vacuumPages = 512;
+
+// Gets are looked up with `url IN (...)` queries of this many parameters; unused ones are bound to
+// NULL so that a single prepared statement serves every batch.
+const int getBatchSize = 32;
+
+// The encoding of blobs the cache compresses itself. Reads of LZ4 blobs fail without LZ4 support.
+const char *const lz4Encoding = "lz4";
+#ifdef MBGL_USE_LZ4
+const char *const ownEncoding = lz4Encoding;
+#else
+const char *const ownEncoding = "gzip";
+#endif
+
+// Stored as the database's user_version. Tables of other versions are dropped and recreated.
+const int schemaVersion = 2;
+
+int64_t now() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+}
 
 namespace mbgl {
 
@@ -70,6 +117,11 @@ struct SQLiteCache::GetAction {
     const std::function<void(std::unique_ptr<Response>)> callback;
 };
 
+struct SQLiteCache::BatchGetAction {
+    const std::vector<Resource> resources;
+    const BatchCallback callback;
+};
+
 struct SQLiteCache::PutAction {
     const Resource resource;
     const std::shared_ptr<const Response> response;
@@ -80,6 +132,10 @@ struct SQLiteCache::RefreshAction {
     const int64_t expires;
 };
 
+struct SQLiteCache::PinAction {
+    const Resource resource;
+};
+
 struct SQLiteCache::StopAction {
 };
 
@@ -88,11 +144,14 @@ struct SQLiteCache::ActionDispatcher {
     template <typename T> void operator()(T &t) { cache.process(t); }
 };
 
-SQLiteCache::SQLiteCache(const std::string &path_)
+SQLiteCache::SQLiteCache(const std::string &path_, uint64_t maximumSize_)
     : path(path_),
+      maximumSize(maximumSize_),
       loop(uv_loop_new()),
       queue(new Queue(loop, [this](Action &action) {
           mapbox::util::apply_visitor(ActionDispatcher{ *this }, action);
+      }, [this]() {
+          processPendingGets();
       })),
       thread([this]() {
 #ifdef __APPLE__
@@ -123,6 +182,12 @@ void SQLiteCache::get(const Resource &resource, std::function<void(std::unique_p
     queue->send(GetAction{ resource, callback });
 }
 
+void SQLiteCache::get(const std::vector<Resource> &resources, BatchCallback callback) {
+    // Can be called from any thread. The callback is invoked in the cache thread.
+    assert(queue);
+    queue->send(BatchGetAction{ resources, callback });
+}
+
 void SQLiteCache::put(const Resource &resource, std::shared_ptr<const Response> response, Hint hint) {
     // Can be called from any thread, but most likely from the file source thread. We are either
     // storing a new response or updating the currently stored response, potentially setting a new
@@ -137,9 +202,34 @@ void SQLiteCache::put(const Resource &resource, std::shared_ptr<const Response>
     }
 }
 
+void SQLiteCache::pin(const Resource &resource) {
+    // Can be called from any thread. Actions are processed in order, so a pin that follows a put
+    // of the same resource applies to the stored response.
+    assert(queue);
+    queue->send(PinAction{ resource });
+}
+
+void SQLiteCache::setMaximumSize(uint64_t size) {
+    maximumSize = size;
+}
+
 void SQLiteCache::createDatabase() {
     db = util::make_unique<Database>(path.c_str(), ReadWrite | Create);
 
+    try {
+        // Lets eviction hand pages back to the file system incrementally. This only applies to
+        // databases created from scratch; existing files keep their mode.
+        db->exec("PRAGMA auto_vacuum = INCREMENTAL");
+
+        // WAL lets readers proceed while a batch is being written and only syncs on checkpoints,
+        // which is sufficient for a cache. The mmap size is an upper bound; SQLite maps lazily.
+        db->exec("PRAGMA journal_mode = WAL");
+        db->exec("PRAGMA synchronous = NORMAL");
+        db->exec("PRAGMA mmap_size = 33554432");
+    } catch (mapbox::sqlite::Exception &ex) {
+        Log::Warning(Event::Database, "Failed to configure database: %s", ex.what());
+    }
+
     constexpr const char *const sql = ""
         "CREATE TABLE IF NOT EXISTS `http_cache` ("
         "    `url` TEXT PRIMARY KEY NOT NULL,"
@@ -149,12 +239,25 @@ void SQLiteCache::createDatabase() {
         "    `etag` TEXT,"
         "    `expires` INTEGER," // Timestamp when the server says the file expires.
         "    `data` BLOB,"
-        "    `compressed` INTEGER NOT NULL DEFAULT 0" // Whether the data is compressed.
+        "    `encoding` TEXT NOT NULL DEFAULT ''," // The content encoding of the data, if any.
+        "    `accessed` INTEGER NOT NULL DEFAULT 0," // Timestamp when the file was last used.
+        "    `size` INTEGER NOT NULL DEFAULT 0," // Size of the stored data in bytes.
+        "    `pinned` INTEGER NOT NULL DEFAULT 0" // Whether an offline region needs the file.
         ");"
-        "CREATE INDEX IF NOT EXISTS `http_cache_kind_idx` ON `http_cache` (`kind`);";
+        "CREATE INDEX IF NOT EXISTS `http_cache_kind_idx` ON `http_cache` (`kind`);"
+        "CREATE INDEX IF NOT EXISTS `http_cache_eviction_idx` ON `http_cache` (`pinned`, `accessed`);";
 
     try {
+        bool current = false;
+        {
+            Statement stmt = db->prepare("PRAGMA user_version");
+            current = stmt.run() && stmt.get<int>(0) == schemaVersion;
+        }
+        if (!current) {
+            db->exec("DROP TABLE IF EXISTS `http_cache`");
+        }
         db->exec(sql);
+        db->exec(("PRAGMA user_version = " + std::to_string(schemaVersion)).c_str());
     } catch(mapbox::sqlite::Exception &) {
         // Creating the database table + index failed. That means there may already be one, likely
         // with different columsn. Drop it and try to create a new one.
@@ -164,43 +267,314 @@ void SQLiteCache::createDatabase() {
         } catch (mapbox::sqlite::Exception &ex) {
             Log::Error(Event::Database, "Failed to create database: %s", ex.what());
             db.reset();
+            return;
+        }
+    }
+
+    computeSize();
+}
+
+void SQLiteCache::computeSize() {
+    Statement stmt = db->prepare("SELECT COALESCE(SUM(`size`), 0) FROM `http_cache` WHERE `pinned` = 0");
+    stmt.run();
+    currentSize = uint64_t(stmt.get<int64_t>(0));
+}
+
+void SQLiteCache::beginTransaction() {
+    // This is called in the SQLite event loop.
+    if (inTransaction) {
+        return;
+    }
+
+    db->exec("BEGIN");
+    inTransaction = true;
+
+    if (!commitTimer) {
+        commitTimer = new uv_timer_t;
+        commitTimer->data = this;
+        uv_timer_init(loop, commitTimer);
+    }
+    uv_timer_start(commitTimer, [](UV_TIMER_PARAMS(timer)) {
+        reinterpret_cast<SQLiteCache *>(timer->data)->commitTransaction();
+    }, commitDelay, 0);
+}
+
+void SQLiteCache::commitTransaction() {
+    if (!inTransaction) {
+        return;
+    }
+
+    uv_timer_stop(commitTimer);
+    inTransaction = false;
+    pendingWrites = 0;
+
+    try {
+        flushAccessTimes();
+        evict();
+        db->exec("COMMIT");
+    } catch (mapbox::sqlite::Exception &ex) {
+        Log::Error(Event::Database, "Failed to commit cache writes; dropped the puts, pins and access "
+                   "times of this batch: %s", ex.what());
+        // This runs in the timer and queue callbacks, so nothing may escape. SQLite may already
+        // have rolled back the transaction by itself.
+        try {
+            db->exec("ROLLBACK");
+        } catch (mapbox::sqlite::Exception &rollbackEx) {
+            Log::Warning(Event::Database, "Failed to roll back cache writes: %s", rollbackEx.what());
+        }
+        try {
+            computeSize();
+        } catch (mapbox::sqlite::Exception &sizeEx) {
+            Log::Warning(Event::Database, "Failed to compute cache size: %s", sizeEx.what());
+        }
+    }
+
+    if (queue && currentSize > maximumSize) {
+        // Continue evicting in the next batch rather than all at once.
+        beginTransaction();
+    }
+}
+
+void SQLiteCache::flushAccessTimes() {
+    if (accessedURLs.empty()) {
+        return;
+    }
+
+    if (!accessStmt) {
+        accessStmt = util::make_unique<Statement>( //        1               2
+            db->prepare("UPDATE `http_cache` SET `accessed` = ? WHERE `url` = ?"));
+    }
+
+    const int64_t accessed = now();
+    for (const auto &url : accessedURLs) {
+        accessStmt->reset();
+        accessStmt->bind(1, accessed);
+        accessStmt->bind(2, url.c_str());
+        accessStmt->run();
+    }
+    accessedURLs.clear();
+}
+
+void SQLiteCache::evict() {
+    // This is called in the SQLite event loop, within a write transaction.
+    if (currentSize <= maximumSize) {
+        return;
+    }
+
+    if (!evictSelectStmt) {
+        evictSelectStmt = util::make_unique<Statement>(db->prepare("SELECT `url`, `size` FROM "
+        //                                                                            1
+            "`http_cache` WHERE `pinned` = 0 ORDER BY `accessed` ASC, `rowid` ASC LIMIT ?"));
+        evictDeleteStmt = util::make_unique<Statement>( //                1
+            db->prepare("DELETE FROM `http_cache` WHERE `url` = ?"));
+    } else {
+        evictSelectStmt->reset();
+    }
+
+    // Collect the candidates first; the table must not change while we iterate over it.
+    std::vector<std::pair<std::string, uint64_t>> candidates;
+    evictSelectStmt->bind(1, evictionBatchSize);
+    while (evictSelectStmt->run()) {
+        candidates.emplace_back(evictSelectStmt->get<std::string>(0),
+                                uint64_t(evictSelectStmt->get<int64_t>(1)));
+    }
+
+    if (candidates.empty()) {
+        // The running total drifted from the table; resynchronize instead of retrying forever.
+        computeSize();
+        return;
+    }
+
+    int evicted = 0;
+    for (const auto &candidate : candidates) {
+        if (currentSize <= maximumSize) {
+            break;
         }
+        evictDeleteStmt->reset();
+        evictDeleteStmt->bind(1, candidate.first.c_str());
+        evictDeleteStmt->run();
+        currentSize -= std::min(currentSize, candidate.second);
+        evicted++;
+    }
+
+    if (evicted) {
+        // Returns a bounded number of freed pages to the file system instead of running a
+        // blocking VACUUM. This is a no-op for databases without incremental auto_vacuum.
+        db->exec("PRAGMA incremental_vacuum(" + std::to_string(vacuumPages) + ")");
     }
 }
 
 void SQLiteCache::process(GetAction &action) {
+    // Answered in processPendingGets() once all actions of this loop iteration have been
+    // dispatched, so that a burst of requests shares a few queries.
+    pendingGets.emplace_back(util::make_unique<GetAction>(std::move(action)));
+}
+
+void SQLiteCache::process(BatchGetAction &action) {
+    pendingBatchGets.emplace_back(util::make_unique<BatchGetAction>(std::move(action)));
+}
+
+void SQLiteCache::processPendingGets() {
     // This is called in the SQLite event loop.
+    if (pendingGets.empty() && pendingBatchGets.empty()) {
+        return;
+    }
+
+    std::vector<std::unique_ptr<GetAction>> gets;
+    gets.swap(pendingGets);
+    std::vector<std::unique_ptr<BatchGetAction>> batchGets;
+    batchGets.swap(pendingBatchGets);
+
+    std::vector<std::string> urls;
+    for (const auto &action : gets) {
+        urls.emplace_back(unifyMapboxURLs(action->resource.url));
+    }
+    for (const auto &action : batchGets) {
+        for (const auto &resource : action->resources) {
+            urls.emplace_back(unifyMapboxURLs(resource.url));
+        }
+    }
+
+    std::vector<std::unique_ptr<Response>> responses;
+    try {
+        responses = getAll(urls);
+    } catch (std::exception &ex) {
+        // This runs in the queue callback, so nothing may escape. Every requester still gets an
+        // answer; a miss makes it load the resource.
+        Log::Error(Event::Database, "Failed to read from the cache: %s", ex.what());
+        responses.clear();
+        responses.resize(urls.size());
+    }
+
+    auto response = std::make_move_iterator(responses.begin());
+    for (auto &action : gets) {
+        action->callback(*response++);
+    }
+    for (auto &action : batchGets) {
+        std::vector<std::unique_ptr<Response>> results(response, response + action->resources.size());
+        response += action->resources.size();
+        action->callback(std::move(results));
+    }
+
+    if (!accessedURLs.empty()) {
+        // Access times are written with the next write batch instead of once per get.
+        beginTransaction();
+    }
+}
+
+std::vector<std::unique_ptr<Response>> SQLiteCache::getAll(const std::vector<std::string> &urls) {
+    std::vector<std::unique_ptr<Response>> responses(urls.size());
+
     if (!db) {
         createDatabase();
+        if (!db) {
+            return responses;
+        }
     }
 
-    if (!getStmt) {
-        // Initialize the statement                                   0         1
-        getStmt = util::make_unique<Statement>(db->prepare("SELECT `status`, `modified`, "
-        //     2         3        4          5                                       1
-            "`etag`, `expires`, `data`, `compressed` FROM `http_cache` WHERE `url` = ?"));
-    } else {
-        getStmt->reset();
+    if (!getManyStmt) {
+        std::string sql = "SELECT `status`, `modified`, `etag`, `expires`, `data`, `encoding`, "
+                          "`accessed`, `url`, `kind` FROM `http_cache` WHERE `url` IN (?";
+        for (int i = 1; i < getBatchSize; i++) {
+            sql += ", ?";
+        }
+        sql += ")";
+        getManyStmt = util::make_unique<Statement>(db->prepare(sql.c_str()));
     }
 
-    const std::string unifiedURL = unifyMapboxURLs(action.resource.url);
-    getStmt->bind(1, unifiedURL.c_str());
-    if (getStmt->run()) {
-        // There is data.
-        auto response = util::make_unique<Response>();
-        response->status = Response::Status(getStmt->get<int>(0));
-        response->modified = getStmt->get<int64_t>(1);
-        response->etag = getStmt->get<std::string>(2);
-        response->expires = getStmt->get<int64_t>(3);
-        response->data = getStmt->get<std::string>(4);
-        if (getStmt->get<int>(5)) { // == compressed
-            response->data = util::decompress(response->data);
+    // Gets can run inside an open write batch; they see its uncommitted rows.
+    const bool ownTransaction = !inTransaction && urls.size() > std::size_t(getBatchSize);
+    if (ownTransaction) {
+        db->exec("BEGIN");
+    }
+
+    try {
+        for (std::size_t begin = 0; begin < urls.size(); begin += getBatchSize) {
+            const std::size_t end = std::min(urls.size(), begin + getBatchSize);
+
+            getManyStmt->reset();
+            for (std::size_t i = begin; i < begin + getBatchSize; i++) {
+                // The URLs outlive the query, so SQLite doesn't need to copy them.
+                getManyStmt->bind(int(i - begin + 1),
+                                  i < end ? urls[i].c_str() : static_cast<const char *>(nullptr));
+            }
+
+            while (getManyStmt->run()) {
+                const std::string url = getManyStmt->get<std::string>(7);
+
+                auto response = util::make_unique<Response>();
+                response->status = Response::Status(getManyStmt->get<int>(0));
+                response->modified = getManyStmt->get<int64_t>(1);
+                response->etag = getManyStmt->get<std::string>(2);
+                response->expires = getManyStmt->get<int64_t>(3);
+                const std::string encoding = getManyStmt->get<std::string>(5);
+                try {
+                    if (encoding == lz4Encoding) {
+#ifdef MBGL_USE_LZ4
+                        std::size_t size = 0;
+                        const char *blob = getManyStmt->getBlob(4, size);
+                        response->data =
+                            std::make_shared<const std::string>(util::decompressLZ4(blob, size));
+#else
+                        // Written by a build with LZ4 support. Treat it as missing; it will be
+                        // replaced.
+                        continue;
+#endif
+                    } else if (!encoding.empty() && getManyStmt->get<int>(8) != Resource::Tile) {
+                        // Inflate straight out of SQLite's buffer instead of copying the blob
+                        // first.
+                        std::size_t size = 0;
+                        const char *blob = getManyStmt->getBlob(4, size);
+                        response->data =
+                            std::make_shared<const std::string>(util::decompress(blob, size));
+                    } else {
+                        // Tiles are inflated by the worker that parses them.
+                        response->data =
+                            std::make_shared<const std::string>(getManyStmt->get<std::string>(4));
+                        response->encoding = encoding;
+                    }
+                } catch (std::runtime_error &ex) {
+                    // A corrupt row is a miss; the response that replaces it overwrites it.
+                    Log::Warning(Event::Database, "Failed to decode cached %s: %s", url.c_str(),
+                                 ex.what());
+                    continue;
+                }
+                if (now() - getManyStmt->get<int64_t>(6) >= accessGranularity) {
+                    accessedURLs.insert(url);
+                }
+
+                // The same URL may have been requested more than once; the copies share the data.
+                const Response *first = nullptr;
+                for (std::size_t i = begin; i < end; i++) {
+                    if (urls[i] != url || responses[i]) {
+                        continue;
+                    }
+                    if (first) {
+                        responses[i] = util::make_unique<Response>(*first);
+                    } else {
+                        first = response.get();
+                        responses[i] = std::move(response);
+                    }
+                }
+            }
         }
-        action.callback(std::move(response));
-    } else {
-        // There is no data.
-        action.callback(nullptr);
+    } catch (...) {
+        if (ownTransaction) {
+            // The read transaction must not stay open, or the next write batch can't begin.
+            try {
+                db->exec("ROLLBACK");
+            } catch (mapbox::sqlite::Exception &ex) {
+                Log::Warning(Event::Database, "Failed to end cache read: %s", ex.what());
+            }
+        }
+        throw;
     }
+
+    if (ownTransaction) {
+        db->exec("COMMIT");
+    }
+
+    return responses;
 }
 
 void SQLiteCache::process(PutAction &action) {
@@ -208,40 +582,82 @@ void SQLiteCache::process(PutAction &action) {
         createDatabase();
     }
 
+    beginTransaction();
+
+    const std::string unifiedURL = unifyMapboxURLs(action.resource.url);
+
+    // REPLACE doesn't tell us the size of the row it overwrites, and would drop its pin.
+    if (!sizeStmt) {
+        sizeStmt = util::make_unique<Statement>( //                                             1
+            db->prepare("SELECT `size`, `pinned` FROM `http_cache` WHERE `url` = ?"));
+    } else {
+        sizeStmt->reset();
+    }
+    sizeStmt->bind(1, unifiedURL.c_str());
+    bool pinned = false;
+    if (sizeStmt->run()) {
+        pinned = sizeStmt->get<int>(1);
+        if (!pinned) {
+            currentSize -= std::min(currentSize, uint64_t(sizeStmt->get<int64_t>(0)));
+        }
+    }
+
     if (!putStmt) {
         putStmt = util::make_unique<Statement>(db->prepare("REPLACE INTO `http_cache` ("
-        //     1       2       3         4         5         6        7          8
-            "`url`, `status`, `kind`, `modified`, `etag`, `expires`, `data`, `compressed`"
-            ") VALUES(?, ?, ?, ?, ?, ?, ?, ?)"));
+        //     1       2       3         4         5         6        7          8           9        10       11
+            "`url`, `status`, `kind`, `modified`, `etag`, `expires`, `data`, `encoding`, `accessed`, `size`, `pinned`"
+            ") VALUES(?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)"));
     } else {
         putStmt->reset();
     }
 
-    const std::string unifiedURL = unifyMapboxURLs(action.resource.url);
     putStmt->bind(1 /* url */, unifiedURL.c_str());
     putStmt->bind(2 /* status */, int(action.response->status));
     putStmt->bind(3 /* kind */, int(action.resource.kind));
     putStmt->bind(4 /* modified */, action.response->modified);
     putStmt->bind(5 /* etag */, action.response->etag.c_str());
     putStmt->bind(6 /* expires */, action.response->expires);
+    putStmt->bind(9 /* accessed */, now());
+    putStmt->bind(11 /* pinned */, pinned);
+
+    const std::string &raw = *action.response->data;
 
     std::string data;
-    if (action.resource.kind != Resource::Image) {
-        // Do not compress images, since they are typically compressed already.
-        data = util::compress(action.response->data);
+    if (action.response->encoding.empty() && action.resource.kind != Resource::Image &&
+        action.resource.kind != Resource::Tile) {
+        // Do not compress images, since they are typically compressed already. Tiles are stored
+        // as the server sent them, so that this thread doesn't compress them again.
+#ifdef MBGL_USE_LZ4
+        data = util::compressLZ4(raw);
+#else
+        // The gzip trailer lets reads allocate the inflated data up front.
+        data = util::compress(raw, true);
+#endif
     }
 
-    if (!data.empty() && data.size() < action.response->data.size()) {
+    if (!data.empty() && data.size() < raw.size()) {
         // Store the compressed data when it is smaller than the original
         // uncompressed data.
         putStmt->bind(7 /* data */, data, false); // do not retain the string internally.
-        putStmt->bind(8 /* compressed */, true);
+        putStmt->bind(8 /* encoding */, ownEncoding);
+        putStmt->bind(10 /* size */, int64_t(data.size()));
+        if (!pinned) {
+            currentSize += data.size();
+        }
     } else {
-        putStmt->bind(7 /* data */, action.response->data, false); // do not retain the string internally.
-        putStmt->bind(8 /* compressed */, false);
+        putStmt->bind(7 /* data */, raw, false); // do not retain the string internally.
+        putStmt->bind(8 /* encoding */, action.response->encoding.c_str());
+        putStmt->bind(10 /* size */, int64_t(raw.size()));
+        if (!pinned) {
+            currentSize += raw.size();
+        }
     }
 
     putStmt->run();
+
+    if (++pendingWrites >= maxPendingWrites) {
+        commitTransaction();
+    }
 }
 
 void SQLiteCache::process(RefreshAction &action) {
@@ -249,6 +665,8 @@ void SQLiteCache::process(RefreshAction &action) {
         createDatabase();
     }
 
+    beginTransaction();
+
     if (!refreshStmt) {
         refreshStmt = util::make_unique<Statement>( //       1               2
             db->prepare("UPDATE `http_cache` SET `expires` = ? WHERE `url` = ?"));
@@ -260,12 +678,60 @@ void SQLiteCache::process(RefreshAction &action) {
     refreshStmt->bind(1, int64_t(action.expires));
     refreshStmt->bind(2, unifiedURL.c_str());
     refreshStmt->run();
+
+    if (++pendingWrites >= maxPendingWrites) {
+        commitTransaction();
+    }
+}
+
+void SQLiteCache::process(PinAction &action) {
+    if (!db) {
+        createDatabase();
+    }
+
+    beginTransaction();
+
+    const std::string unifiedURL = unifyMapboxURLs(action.resource.url);
+
+    if (!sizeStmt) {
+        sizeStmt = util::make_unique<Statement>( //                                             1
+            db->prepare("SELECT `size`, `pinned` FROM `http_cache` WHERE `url` = ?"));
+    } else {
+        sizeStmt->reset();
+    }
+    sizeStmt->bind(1, unifiedURL.c_str());
+    if (!sizeStmt->run() || sizeStmt->get<int>(1)) {
+        // Not stored, or already pinned.
+        return;
+    }
+    currentSize -= std::min(currentSize, uint64_t(sizeStmt->get<int64_t>(0)));
+
+    if (!pinStmt) {
+        pinStmt = util::make_unique<Statement>( //                                      1
+            db->prepare("UPDATE `http_cache` SET `pinned` = 1 WHERE `url` = ?"));
+    } else {
+        pinStmt->reset();
+    }
+    pinStmt->bind(1, unifiedURL.c_str());
+    pinStmt->run();
+
+    if (++pendingWrites >= maxPendingWrites) {
+        commitTransaction();
+    }
 }
 
 void SQLiteCache::process(StopAction &) {
     assert(queue);
     queue->stop();
     queue = nullptr;
+
+    processPendingGets();
+    commitTransaction();
+
+    if (commitTimer) {
+        uv::close(commitTimer);
+        commitTimer = nullptr;
+    }
 }
 
 }
@@ -0,0 +1,299 @@
+#include "zip_archive.hpp"
+
+#include <zlib.h>
+
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <initializer_list>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace mbgl {
+
+namespace {
+
+const uint32_t localHeaderSignature = 0x04034B50;
+const uint32_t centralHeaderSignature = 0x02014B50;
+const uint32_t endSignature = 0x06054B50;
+const uint32_t zip64EndSignature = 0x06064B50;
+const uint32_t zip64LocatorSignature = 0x07064B50;
+
+const std::size_t localHeaderSize = 30;
+const std::size_t centralHeaderSize = 46;
+const std::size_t endSize = 22;
+const std::size_t zip64EndSize = 56;
+const std::size_t zip64LocatorSize = 20;
+
+const uint16_t methodStored = 0;
+const uint16_t methodDeflated = 8;
+
+uint16_t read16(const char *data) {
+    const auto bytes = reinterpret_cast<const uint8_t *>(data);
+    return uint16_t(bytes[0] | bytes[1] << 8);
+}
+
+uint32_t read32(const char *data) {
+    return uint32_t(read16(data)) | uint32_t(read16(data + 2)) << 16;
+}
+
+uint64_t read64(const char *data) {
+    return uint64_t(read32(data)) | uint64_t(read32(data + 4)) << 32;
+}
+
+// Zip files store local MS-DOS time.
+int64_t dosTime(uint16_t date, uint16_t time) {
+    std::tm tm;
+    std::memset(&tm, 0, sizeof(tm));
+    tm.tm_year = ((date >> 9) & 0x7F) + 80;
+    tm.tm_mon = ((date >> 5) & 0x0F) - 1;
+    tm.tm_mday = date & 0x1F;
+    tm.tm_hour = (time >> 11) & 0x1F;
+    tm.tm_min = (time >> 5) & 0x3F;
+    tm.tm_sec = (time & 0x1F) * 2;
+    tm.tm_isdst = -1;
+    return int64_t(std::mktime(&tm));
+}
+
+std::runtime_error systemError(int err) {
+    return std::runtime_error(std::strerror(err));
+}
+
+// Deflate doesn't compress better than about 1:1032.
+const uint64_t maxDeflateRatio = 1032;
+
+}
+
+std::shared_ptr<const ZipArchive> ZipArchive::Get(const std::string &path) {
+    static std::mutex mutex;
+    static std::map<std::string, std::shared_ptr<const ZipArchive>> archives;
+
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        throw systemError(errno);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = archives.find(path);
+    if (it != archives.end()) {
+        const ZipArchive &archive = *it->second;
+        if (archive.device == uint64_t(info.st_dev) && archive.inode == uint64_t(info.st_ino) &&
+            archive.modified == int64_t(info.st_mtime) &&
+            archive.fileSize == uint64_t(info.st_size)) {
+            return it->second;
+        }
+        // The file changed. Reads that are still running keep the old archive open until they
+        // finish.
+        archives.erase(it);
+    }
+
+    // Archives that fail to open aren't remembered, so that we retry the next time.
+    return archives.emplace(path, std::make_shared<const ZipArchive>(path)).first->second;
+}
+
+ZipArchive::ZipArchive(const std::string &path) {
+    fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw systemError(errno);
+    }
+
+    try {
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            throw systemError(errno);
+        }
+        device = uint64_t(info.st_dev);
+        inode = uint64_t(info.st_ino);
+        modified = int64_t(info.st_mtime);
+        fileSize = uint64_t(info.st_size);
+        readIndex();
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+}
+
+ZipArchive::~ZipArchive() {
+    close(fd);
+}
+
+void ZipArchive::readExactly(char *buffer, std::size_t length, uint64_t offset) const {
+    while (length) {
+        const ssize_t result = pread(fd, buffer, length, off_t(offset));
+        if (result < 0 && errno == EINTR) {
+            continue;
+        } else if (result < 0) {
+            throw systemError(errno);
+        } else if (result == 0) {
+            throw std::runtime_error("Unexpected end of zip file");
+        }
+        buffer += result;
+        length -= std::size_t(result);
+        offset += uint64_t(result);
+    }
+}
+
+void ZipArchive::readIndex() {
+    // The end of central directory record is followed by a comment of up to 64 KB.
+    const std::size_t tailSize = std::size_t(std::min<uint64_t>(fileSize, endSize + 0xFFFF));
+    std::vector<char> tail(tailSize);
+    readExactly(tail.data(), tailSize, fileSize - tailSize);
+
+    std::size_t end = std::string::npos;
+    for (std::size_t i = tailSize >= endSize ? tailSize - endSize + 1 : 0; i-- > 0;) {
+        if (read32(&tail[i]) == endSignature) {
+            end = i;
+            break;
+        }
+    }
+    if (end == std::string::npos) {
+        throw std::runtime_error("Not a zip archive");
+    }
+
+    uint64_t count = read16(&tail[end + 10]);
+    uint64_t directorySize = read32(&tail[end + 12]);
+    uint64_t directoryOffset = read32(&tail[end + 16]);
+
+    if (count == 0xFFFF || directorySize == 0xFFFFFFFF || directoryOffset == 0xFFFFFFFF) {
+        // Large archives store the real values in a ZIP64 record, which a locator in front of the
+        // end record points to.
+        const uint64_t endOffset = fileSize - tailSize + end;
+        if (endOffset < zip64LocatorSize) {
+            throw std::runtime_error("Invalid zip archive");
+        }
+        char locator[zip64LocatorSize];
+        readExactly(locator, zip64LocatorSize, endOffset - zip64LocatorSize);
+        if (read32(locator) != zip64LocatorSignature) {
+            throw std::runtime_error("Invalid zip archive");
+        }
+        char record[zip64EndSize];
+        readExactly(record, zip64EndSize, read64(locator + 8));
+        if (read32(record) != zip64EndSignature) {
+            throw std::runtime_error("Invalid zip archive");
+        }
+        count = read64(record + 32);
+        directorySize = read64(record + 40);
+        directoryOffset = read64(record + 48);
+    }
+
+    // The ZIP64 values are arbitrary 64 bit numbers, so the checks must not overflow. Every entry
+    // takes at least a header in the directory, which bounds the count before it's trusted.
+    if (directoryOffset > fileSize || directorySize > fileSize - directoryOffset ||
+        count > directorySize / centralHeaderSize) {
+        throw std::runtime_error("Invalid zip archive");
+    }
+
+    std::vector<char> directory(static_cast<std::size_t>(directorySize));
+    readExactly(directory.data(), directory.size(), directoryOffset);
+    entries.reserve(std::size_t(count));
+
+    std::size_t pos = 0;
+    for (uint64_t index = 0; index < count; index++) {
+        if (pos + centralHeaderSize > directory.size() ||
+            read32(&directory[pos]) != centralHeaderSignature) {
+            throw std::runtime_error("Invalid zip central directory");
+        }
+        const char *header = &directory[pos];
+        const uint16_t nameLength = read16(header + 28);
+        const uint16_t extraLength = read16(header + 30);
+        const uint16_t commentLength = read16(header + 32);
+        if (pos + centralHeaderSize + nameLength + extraLength + commentLength > directory.size()) {
+            throw std::runtime_error("Invalid zip central directory");
+        }
+
+        Entry entry;
+        entry.method = read16(header + 10);
+        entry.modified = dosTime(read16(header + 14), read16(header + 12));
+        entry.compressedSize = read32(header + 20);
+        entry.size = read32(header + 24);
+        entry.offset = read32(header + 42);
+        entry.index = index;
+
+        // The ZIP64 extra field has the values that didn't fit, in this order.
+        const char *extra = header + centralHeaderSize + nameLength;
+        for (std::size_t e = 0; e + 4 <= extraLength;) {
+            const uint16_t id = read16(extra + e);
+            const uint16_t length = read16(extra + e + 2);
+            if (id == 0x0001) {
+                std::size_t field = e + 4;
+                const std::size_t fieldEnd = std::min<std::size_t>(e + 4 + length, extraLength);
+                for (uint64_t *value : { &entry.size, &entry.compressedSize, &entry.offset }) {
+                    if (*value == 0xFFFFFFFF && field + 8 <= fieldEnd) {
+                        *value = read64(extra + field);
+                        field += 8;
+                    }
+                }
+            }
+            e += 4 + length;
+        }
+
+        entries.emplace(std::string(header + centralHeaderSize, nameLength), entry);
+        pos += centralHeaderSize + nameLength + extraLength + commentLength;
+    }
+}
+
+const ZipArchive::Entry *ZipArchive::find(const std::string &name) const {
+    const auto it = entries.find(name);
+    return it != entries.end() ? &it->second : nullptr;
+}
+
+std::string ZipArchive::read(const Entry &entry) const {
+    // The local header may have a different extra field than the central directory.
+    char header[localHeaderSize];
+    readExactly(header, localHeaderSize, entry.offset);
+    if (read32(header) != localHeaderSignature) {
+        throw std::runtime_error("Invalid zip file header");
+    }
+    const uint64_t dataOffset =
+        entry.offset + localHeaderSize + read16(header + 26) + read16(header + 28);
+
+    // The sizes come from the archive. Check them against the file before allocating anything.
+    if (dataOffset > fileSize || entry.compressedSize > fileSize - dataOffset ||
+        entry.size > entry.compressedSize * maxDeflateRatio + 1024) {
+        throw std::runtime_error("Invalid zip file size");
+    }
+
+    std::string result(std::size_t(entry.size), '\0');
+
+    if (entry.method == methodStored) {
+        if (entry.compressedSize != entry.size) {
+            throw std::runtime_error("Invalid zip file size");
+        }
+        if (entry.size) {
+            readExactly(&result[0], result.size(), dataOffset);
+        }
+    } else if (entry.method == methodDeflated) {
+        std::vector<char> compressed(std::size_t(entry.compressedSize));
+        readExactly(compressed.data(), compressed.size(), dataOffset);
+
+        z_stream stream;
+        std::memset(&stream, 0, sizeof(stream));
+        // Zip entries are raw deflate streams without a zlib header.
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+            throw std::runtime_error("Failed to initialize inflate");
+        }
+        stream.next_in = reinterpret_cast<Bytef *>(compressed.data());
+        stream.avail_in = uInt(compressed.size());
+        stream.next_out = reinterpret_cast<Bytef *>(&result[0]);
+        stream.avail_out = uInt(result.size());
+        const int code = inflate(&stream, Z_FINISH);
+        const uLong total = stream.total_out;
+        inflateEnd(&stream);
+        if (code != Z_STREAM_END || total != result.size()) {
+            throw std::runtime_error("Invalid compressed zip file");
+        }
+    } else {
+        throw std::runtime_error("Unsupported zip compression method");
+    }
+
+    return result;
+}
+
+}
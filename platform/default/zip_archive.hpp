@@ -0,0 +1,58 @@
+#ifndef MBGL_STORAGE_DEFAULT_ZIP_ARCHIVE
+#define MBGL_STORAGE_DEFAULT_ZIP_ARCHIVE
+
+#include <mbgl/util/noncopyable.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace mbgl {
+
+// A read-only zip archive. The central directory is parsed once into a hash index from entry name
+// to offset and size. Entries are read by offset with pread, so any number of threads can read from
+// the same archive at once. Failures throw std::runtime_error.
+class ZipArchive : private util::noncopyable {
+public:
+    struct Entry {
+        uint64_t offset = 0; // of the local file header
+        uint64_t compressedSize = 0;
+        uint64_t size = 0;
+        uint16_t method = 0;
+        uint32_t index = 0;
+        int64_t modified = 0;
+    };
+
+    // Returns the archive at this path, which is opened and indexed on first use. An archive that
+    // was replaced or modified since then is opened and indexed again.
+    static std::shared_ptr<const ZipArchive> Get(const std::string &path);
+
+    explicit ZipArchive(const std::string &path);
+    ~ZipArchive();
+
+    // Returns nullptr if there is no such entry.
+    const Entry *find(const std::string &name) const;
+
+    // Stored entries are read straight into the result; deflated entries are inflated.
+    std::string read(const Entry &entry) const;
+
+    std::size_t size() const { return entries.size(); }
+
+private:
+    void readExactly(char *buffer, std::size_t length, uint64_t offset) const;
+    void readIndex();
+
+    int fd = -1;
+    std::unordered_map<std::string, Entry> entries;
+
+    // Identifies the file that was indexed.
+    uint64_t device = 0;
+    uint64_t inode = 0;
+    int64_t modified = 0;
+    uint64_t fileSize = 0;
+};
+
+}
+
+#endif
@@ -4,8 +4,11 @@
 #include <mbgl/platform/gl.hpp>
 #include <mbgl/util/noncopyable.hpp>
 #include <mbgl/map/environment.hpp>
+#include <mbgl/geometry/buffer_pool.hpp>
 
+#include <algorithm>
 #include <cstdlib>
+#include <cstring>
 #include <cassert>
 #include <stdexcept>
 
@@ -37,6 +40,12 @@ public:
         return pos == 0;
     }
 
+    // Returns the number of bytes in this buffer. This stays valid after the
+    // buffer was uploaded to the GPU.
+    inline size_t bytes() const {
+        return pos;
+    }
+
     // Transfers this buffer to the GPU and binds the buffer to the GL context.
     void bind(bool force = false) {
         if (buffer == 0) {
@@ -50,16 +59,54 @@ public:
             }
 
             MBGL_CHECK_ERROR(glBufferData(bufferType, pos, array, GL_STATIC_DRAW));
-            if (!retainAfterUpload) {
+            if (!retainAfterUpload && !retained) {
                 cleanup();
             }
         }
     }
 
+    // Transfers this buffer to the GPU ahead of the first draw, and returns the number of bytes
+    // uploaded. Buffers without elements and buffers that are already on the GPU are skipped.
+    // Binds the buffer, so no vertex array object may be bound.
+    size_t upload() {
+        if (buffer != 0 || array == nullptr) {
+            return 0;
+        }
+        bind();
+        return pos;
+    }
+
+    // Whether upload() would transfer the buffer to the GPU.
+    inline bool pending() const {
+        return buffer == 0 && array != nullptr;
+    }
+
+    // Keeps the contents after they were uploaded, so that they can still be read with data().
+    void retain() {
+        retained = true;
+    }
+
+    // Returns the contents, or null once they were uploaded unless the buffer retains them.
+    inline const void *data() const {
+        return array;
+    }
+
+    // Returns the memory to the pool. Buffers keep their contents until they're uploaded.
     void cleanup() {
         if (array) {
-            free(array);
+            BufferPool::Get().release(array, length);
             array = nullptr;
+            length = 0;
+        }
+    }
+
+    // Makes room for at least /count/ more elements, so that adding them doesn't grow the buffer.
+    void reserve(size_t count) {
+        if (buffer != 0) {
+            throw std::runtime_error("Can't add elements after buffer was bound to GPU");
+        }
+        if (length < pos + count * itemSize) {
+            grow(pos + count * itemSize);
         }
     }
 
@@ -74,11 +121,7 @@ protected:
             throw std::runtime_error("Can't add elements after buffer was bound to GPU");
         }
         if (length < pos + itemSize) {
-            while (length < pos + itemSize) length += defaultLength;
-            array = realloc(array, length);
-            if (array == nullptr) {
-                throw std::runtime_error("Buffer reallocation failed");
-            }
+            grow(pos + itemSize);
         }
         pos += itemSize;
         return reinterpret_cast<char *>(array) + (pos - itemSize);
@@ -101,17 +144,33 @@ public:
     static const size_t itemSize = item_size;
 
 private:
+    // Moves the contents to a block of at least /required/ bytes. The size at least doubles, so
+    // that appending stays amortized constant time.
+    void grow(size_t required) {
+        size_t size = std::max(std::max(required, length * 2), defaultLength);
+        void *block = BufferPool::Get().acquire(size);
+        if (array) {
+            std::memcpy(block, array, pos);
+            BufferPool::Get().release(array, length);
+        }
+        array = block;
+        length = size;
+    }
+
     // CPU buffer
     void *array = nullptr;
 
     // Byte position where we are writing.
     size_t pos = 0;
 
-    // Number of bytes that are valid in this buffer.
+    // Number of bytes allocated for this buffer.
     size_t length = 0;
 
     // GL buffer ID
     GLuint buffer = 0;
+
+    // Whether the contents stay in memory after the upload.
+    bool retained = false;
 };
 
 }
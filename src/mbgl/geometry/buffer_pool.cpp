@@ -0,0 +1,80 @@
+#include <mbgl/geometry/buffer_pool.hpp>
+
+#include <cstdlib>
+#include <stdexcept>
+
+using namespace mbgl;
+
+namespace {
+
+size_t sizeClass(size_t size) {
+    size_t result = 0;
+    while ((size_t(1) << result) < size) {
+        result++;
+    }
+    return result;
+}
+
+}
+
+BufferPool &BufferPool::Get() {
+    // Buffers may still be released while static objects are destroyed at exit, so the pool is
+    // never deleted.
+    static BufferPool *pool = new BufferPool();
+    return *pool;
+}
+
+void *BufferPool::acquire(size_t &size) {
+    const size_t index = sizeClass(size);
+    size = size_t(1) << index;
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto &list = blocks[index];
+        if (!list.empty()) {
+            void *block = list.back();
+            list.pop_back();
+            retained -= size;
+            return block;
+        }
+    }
+
+    void *block = malloc(size);
+    if (block == nullptr) {
+        throw std::runtime_error("Buffer allocation failed");
+    }
+    return block;
+}
+
+void BufferPool::release(void *block, size_t size) {
+    if (block == nullptr) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (retained + size <= maxRetainedBytes) {
+            blocks[sizeClass(size)].push_back(block);
+            retained += size;
+            return;
+        }
+    }
+
+    free(block);
+}
+
+void BufferPool::clear() {
+    std::lock_guard<std::mutex> lock(mtx);
+    for (auto &list : blocks) {
+        for (void *block : list) {
+            free(block);
+        }
+        list.clear();
+    }
+    retained = 0;
+}
+
+size_t BufferPool::retainedBytes() const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return retained;
+}
@@ -0,0 +1,44 @@
+#ifndef MBGL_GEOMETRY_BUFFER_POOL
+#define MBGL_GEOMETRY_BUFFER_POOL
+
+#include <mbgl/util/noncopyable.hpp>
+
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+namespace mbgl {
+
+// Recycles the CPU-side memory of vertex and element buffers. Buffers are filled on the workers,
+// but they're usually released on the render thread once they have been uploaded, so all threads
+// share one pool. Blocks have power-of-two sizes. The pool keeps at most maxRetainedBytes and
+// frees what doesn't fit.
+class BufferPool : private util::noncopyable {
+public:
+    static const size_t maxRetainedBytes = 32 * 1024 * 1024;
+
+    static BufferPool &Get();
+
+    // Returns a block of at least `size` bytes, and sets `size` to the size of the block.
+    void *acquire(size_t &size);
+
+    // Takes back a block that acquire() returned, along with the size it reported.
+    void release(void *block, size_t size);
+
+    // Frees all blocks the pool holds.
+    void clear();
+
+    size_t retainedBytes() const;
+
+private:
+    BufferPool() = default;
+
+    mutable std::mutex mtx;
+    std::array<std::vector<void *>, 8 * sizeof(size_t)> blocks;
+    size_t retained = 0;
+};
+
+}
+
+#endif
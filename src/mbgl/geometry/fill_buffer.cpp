@@ -11,3 +11,11 @@ void FillVertexBuffer::add(vertex_type x, vertex_type y) {
     vertices[0] = x;
     vertices[1] = y;
 }
+
+void FillBatchVertexBuffer::add(vertex_type x, vertex_type y, vertex_type tile) {
+    vertex_type *vertices = static_cast<vertex_type *>(addElement());
+    vertices[0] = x;
+    vertices[1] = y;
+    vertices[2] = tile;
+    vertices[3] = 0;
+}
@@ -16,6 +16,16 @@ public:
     void add(vertex_type x, vertex_type y);
 };
 
+// Holds fill vertices of several tiles, along with the index of the tile's matrix.
+class FillBatchVertexBuffer : public Buffer<
+    8 // bytes per vertex (4 * short == 8 bytes; the last one pads to a multiple of four)
+> {
+public:
+    typedef int16_t vertex_type;
+
+    void add(vertex_type x, vertex_type y, vertex_type tile);
+};
+
 }
 
 #endif
@@ -126,7 +126,7 @@ std::pair<std::vector<Tile::ID>, AnnotationIDs> AnnotationManager::addPointAnnot
             // calculate tile coordinate
             const Coordinate coordinate(extent * (p.x * z2 - x), extent * (p.y * z2 - y));
 
-            const GeometryCollection geometries({ { { { coordinate } } } });
+            const std::vector<std::vector<Coordinate>> geometries({ { { { coordinate } } } });
 
             // at render time we style the annotation according to its {sprite} field
             const std::map<std::string, std::string> properties = {
@@ -136,6 +136,11 @@ void Environment::cancelRequest(Request* req) {
     fileSource.cancel(req);
 }
 
+void Environment::setRequestPriority(Request* req, double priority) {
+    assert(currentlyOn(ThreadType::Map));
+    fileSource.setPriority(req, priority);
+}
+
 // #############################################################################################
 
 #pragma mark - OpenGL cleanup
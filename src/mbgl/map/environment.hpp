@@ -42,6 +42,7 @@ public:
     void requestAsync(const Resource&, std::function<void(const Response&)>);
     Request* request(const Resource&, std::function<void(const Response&)>);
     void cancelRequest(Request*);
+    void setRequestPriority(Request*, double priority);
 
     // #############################################################################################
 
@@ -1,6 +1,7 @@
 #include <mbgl/map/geometry_tile.hpp>
 #include <mbgl/style/filter_expression.hpp>
 #include <mbgl/style/filter_expression_private.hpp>
+#include <mbgl/util/std.hpp>
 
 namespace mbgl {
 
@@ -14,4 +15,25 @@ mapbox::util::optional<Value> GeometryTileFeatureExtractor::getValue(const std::
 
 template bool evaluate(const FilterExpression&, const GeometryTileFeatureExtractor&);
 
+namespace {
+
+class ExpressionFilter : public GeometryTileFilter {
+public:
+    ExpressionFilter(const FilterExpression& expression_)
+        : expression(expression_) {}
+
+    bool operator()(const GeometryTileFeature& feature) const override {
+        return evaluate(expression, GeometryTileFeatureExtractor(feature));
+    }
+
+private:
+    const FilterExpression& expression;
+};
+
+}
+
+std::unique_ptr<GeometryTileFilter> GeometryTileLayer::compileFilter(const FilterExpression& expression) const {
+    return util::make_unique<ExpressionFilter>(expression);
+}
+
 }
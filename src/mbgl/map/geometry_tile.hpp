@@ -1,6 +1,7 @@
 #ifndef MBGL_MAP_GEOMETRY_TILE
 #define MBGL_MAP_GEOMETRY_TILE
 
+#include <mbgl/style/filter_expression.hpp>
 #include <mbgl/style/value.hpp>
 #include <mbgl/util/optional.hpp>
 #include <mbgl/util/ptr.hpp>
@@ -9,6 +10,7 @@
 #include <mbgl/util/noncopyable.hpp>
 
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -21,7 +23,66 @@ enum class FeatureType : uint8_t {
     Polygon = 3
 };
 
-typedef std::vector<std::vector<Coordinate>> GeometryCollection;
+// A view onto the coordinates of a single line, ring or set of points of a
+// feature. The coordinates are owned by the tile the feature belongs to.
+class GeometryLine {
+public:
+    typedef const Coordinate* const_iterator;
+
+    GeometryLine(const Coordinate* begin_, const Coordinate* end_)
+        : first(begin_), last(end_) {}
+
+    const_iterator begin() const { return first; }
+    const_iterator end() const { return last; }
+    std::size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+
+    const Coordinate& operator[](std::size_t i) const { return first[i]; }
+    const Coordinate& front() const { return *first; }
+    const Coordinate& back() const { return *(last - 1); }
+
+private:
+    const Coordinate* first;
+    const Coordinate* last;
+};
+
+// A view onto all geometries of a feature, stored as one contiguous coordinate
+// array plus an array of size() + 1 offsets marking where each line starts.
+class GeometryCollection {
+public:
+    class const_iterator {
+    public:
+        const_iterator(const GeometryCollection& collection_, std::size_t i_)
+            : collection(collection_), i(i_) {}
+
+        GeometryLine operator*() const { return collection[i]; }
+        const_iterator& operator++() { ++i; return *this; }
+        bool operator!=(const const_iterator& rhs) const { return i != rhs.i; }
+
+    private:
+        const GeometryCollection& collection;
+        std::size_t i;
+    };
+
+    GeometryCollection() = default;
+    GeometryCollection(const Coordinate* coordinates_, const uint32_t* offsets_, std::size_t count_)
+        : coordinates(coordinates_), offsets(offsets_), count(count_) {}
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    GeometryLine operator[](std::size_t i) const {
+        return { coordinates + offsets[i], coordinates + offsets[i + 1] };
+    }
+
+    const_iterator begin() const { return { *this, 0 }; }
+    const_iterator end() const { return { *this, count }; }
+
+private:
+    const Coordinate* coordinates = nullptr;
+    const uint32_t* offsets = nullptr;
+    std::size_t count = 0;
+};
 
 class GeometryTileFeature : private util::noncopyable {
 public:
@@ -30,10 +91,21 @@ public:
     virtual GeometryCollection getGeometries() const = 0;
 };
 
+// A filter prepared for evaluation against the features of one layer.
+class GeometryTileFilter : private util::noncopyable {
+public:
+    virtual ~GeometryTileFilter() = default;
+    virtual bool operator()(const GeometryTileFeature&) const = 0;
+};
+
 class GeometryTileLayer : private util::noncopyable {
 public:
     virtual std::size_t featureCount() const = 0;
     virtual util::ptr<const GeometryTileFeature> getFeature(std::size_t) const = 0;
+
+    // The returned filter may only be used with features of this layer. The
+    // default implementation evaluates the expression against getValue().
+    virtual std::unique_ptr<GeometryTileFilter> compileFilter(const FilterExpression&) const;
 };
 
 class GeometryTile : private util::noncopyable {
@@ -3,10 +3,20 @@
 
 namespace mbgl {
 
-LiveTileFeature::LiveTileFeature(FeatureType type_, GeometryCollection geometries_, std::map<std::string, std::string> properties_)
+LiveTileFeature::LiveTileFeature(FeatureType type_, const std::vector<std::vector<Coordinate>>& geometries_, std::map<std::string, std::string> properties_)
     : type(type_),
-      properties(properties_),
-      geometries(geometries_) {}
+      properties(properties_) {
+    offsets.reserve(geometries_.size() + 1);
+    offsets.push_back(0);
+    for (const auto& line : geometries_) {
+        coordinates.insert(coordinates.end(), line.begin(), line.end());
+        offsets.push_back(coordinates.size());
+    }
+}
+
+GeometryCollection LiveTileFeature::getGeometries() const {
+    return GeometryCollection(coordinates.data(), offsets.data(), offsets.size() - 1);
+}
 
 mapbox::util::optional<Value> LiveTileFeature::getValue(const std::string& key) const {
     auto it = properties.find(key);
@@ -9,16 +9,17 @@ namespace mbgl {
 
 class LiveTileFeature : public GeometryTileFeature {
 public:
-    LiveTileFeature(FeatureType, GeometryCollection, std::map<std::string, std::string> properties = {{}});
+    LiveTileFeature(FeatureType, const std::vector<std::vector<Coordinate>>&, std::map<std::string, std::string> properties = {{}});
 
     FeatureType getType() const override { return type; }
     mapbox::util::optional<Value> getValue(const std::string&) const override;
-    GeometryCollection getGeometries() const override { return geometries; }
+    GeometryCollection getGeometries() const override;
 
 private:
     FeatureType type = FeatureType::Unknown;
     std::map<std::string, std::string> properties;
-    GeometryCollection geometries;
+    std::vector<Coordinate> coordinates;
+    std::vector<uint32_t> offsets;
 };
 
 class LiveTileLayer : public GeometryTileLayer {
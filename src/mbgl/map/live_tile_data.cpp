@@ -27,41 +27,41 @@ LiveTileData::LiveTileData(Tile::ID const& id_,
 LiveTileData::~LiveTileData() {}
 
 void LiveTileData::parse() {
-    if (state != State::loaded) {
+    if (state != State::loaded && state != State::partial) {
         return;
     }
 
     try {
-        if (!style) {
-            throw std::runtime_error("style isn't present in LiveTileData object anymore");
-        }
+        if (state == State::loaded) {
+            if (!style) {
+                throw std::runtime_error("style isn't present in LiveTileData object anymore");
+            }
 
-        if (source.type == SourceType::Annotations) {
-            const LiveTile* tile = annotationManager.getTile(id);
+            if (source.type == SourceType::Annotations) {
+                const LiveTile* tile = annotationManager.getTile(id);
 
-            if (tile) {
-                // Parsing creates state that is encapsulated in TileParser. While parsing,
-                // the TileParser object writes results into this objects. All other state
-                // is going to be discarded afterwards.
-                TileParser parser(*tile, *this, style, glyphAtlas, glyphStore, spriteAtlas, sprite);
+                if (tile) {
+                    // Parsing creates state that is encapsulated in TileParser. While parsing,
+                    // the TileParser object writes results into this objects. All other state
+                    // is going to be discarded afterwards.
+                    TileParser parser(*tile, *this, style);
 
-                // Clear the style so that we don't have a cycle in the shared_ptr references.
-                style.reset();
+                    // Clear the style so that we don't have a cycle in the shared_ptr references.
+                    style.reset();
 
-                parser.parse();
+                    parser.parse();
+                } else {
+                    state = State::obsolete;
+                }
             } else {
-                state = State::obsolete;
+                throw std::runtime_error("unknown live tile source type");
             }
-        } else {
-            throw std::runtime_error("unknown live tile source type");
         }
+
+        parseSymbols();
     } catch (const std::exception& ex) {
         Log::Error(Event::ParseTile, "Live-parsing [%d/%d/%d] failed: %s", id.z, id.x, id.y, ex.what());
         state = State::obsolete;
         return;
     }
-
-    if (state != State::obsolete) {
-        state = State::parsed;
-    }
 }
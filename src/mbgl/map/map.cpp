@@ -32,9 +32,12 @@
 
 #include <algorithm>
 #include <iostream>
+#include <future>
+#include <thread>
 
 #define _USE_MATH_DEFINES
 #include <cmath>
+#include <limits>
 
 #include <uv.h>
 
@@ -95,7 +98,7 @@ Map::~Map() {
     sprite.reset();
     glyphStore.reset();
     style.reset();
-    workers.reset();
+    resetWorkers();
     painter.reset();
     annotationManager.reset();
     lineAtlas.reset();
@@ -137,7 +140,7 @@ void Map::start(bool startPaused) {
 
         // It's now safe to destroy/join the workers since there won't be any more callbacks that
         // could dispatch to the worker pool.
-        workers.reset();
+        resetWorkers();
 
         terminating = true;
 
@@ -273,7 +276,10 @@ void Map::run() {
 
     view.activate();
 
-    workers = util::make_unique<uv::worker>(env->loop, 4, "Tile Worker");
+    // Leave one core to the map thread. hardware_concurrency() may return 0 if
+    // the count isn't computable.
+    const unsigned int cores = std::thread::hardware_concurrency();
+    resetWorkers(util::make_unique<uv::worker>(env->loop, cores ? std::max(cores - 1, 1u) : 4, "Tile Worker"));
 
     setup();
     prepare();
@@ -427,7 +433,11 @@ util::ptr<Sprite> Map::getSprite() {
     const float pixelRatio = state.getPixelRatio();
     const std::string &sprite_url = style->getSpriteURL();
     if (!sprite || !sprite->hasPixelRatio(pixelRatio)) {
-        sprite = Sprite::Create(sprite_url, pixelRatio, *env);
+        sprite = Sprite::Create(sprite_url, pixelRatio, *env, [this]() {
+            assert(Environment::currentlyOn(ThreadType::Map));
+            // Resume parsing tiles that were waiting for icons.
+            triggerUpdate();
+        });
     }
 
     return sprite;
@@ -672,6 +682,65 @@ bool Map::getDebug() const {
     return data->getDebug();
 }
 
+void Map::setSourceTileCacheSize(size_t bytes) {
+    data->setSourceTileCacheSize(bytes);
+    triggerUpdate();
+}
+
+size_t Map::getSourceTileCacheSize() const {
+    return data->getSourceTileCacheSize();
+}
+
+void Map::setUploadBudget(size_t bytes) {
+    data->setUploadBudget(bytes);
+}
+
+size_t Map::getUploadBudget() const {
+    return data->getUploadBudget();
+}
+
+void Map::setFillBatching(bool value) {
+    data->setFillBatching(value);
+    triggerUpdate();
+}
+
+bool Map::getFillBatching() const {
+    return data->getFillBatching();
+}
+
+Map::UploadStats Map::getUploadStats() const {
+    std::lock_guard<std::mutex> lock(mutexUploadStats);
+    return uploadStats;
+}
+
+namespace {
+
+Map::WorkerStats convertWorkerStats(const uv_worker_stats_t &stats) {
+    Map::WorkerStats result;
+    result.queued = stats.queued;
+    result.maxQueued = stats.max_queued;
+    result.started = stats.started;
+    result.canceled = stats.canceled;
+    result.totalWaitNs = stats.total_wait_ns;
+    result.maxWaitNs = stats.max_wait_ns;
+    return result;
+}
+
+}
+
+Map::WorkerStats Map::getWorkerStats() const {
+    std::lock_guard<std::mutex> lock(mutexWorkerStats);
+    return workers ? convertWorkerStats(workers->stats()) : workerStats;
+}
+
+void Map::resetWorkers(std::unique_ptr<uv::worker> replacement) {
+    std::lock_guard<std::mutex> lock(mutexWorkerStats);
+    if (workers) {
+        workerStats = convertWorkerStats(workers->stats());
+    }
+    workers = std::move(replacement);
+}
+
 std::chrono::steady_clock::time_point Map::getTime() const {
     return data->getAnimationTime();
 }
@@ -769,6 +838,43 @@ void Map::updateTiles() {
     }
 }
 
+void Map::uploadTiles() {
+    assert(Environment::currentlyOn(ThreadType::Map));
+
+    // Static rendering draws a single frame, which needs all tiles.
+    size_t budget = data->getUploadBudget();
+    if (budget == 0 || mode == Mode::Static) {
+        budget = std::numeric_limits<size_t>::max();
+    }
+
+    // Uploading binds element buffers, which must not end up in a vertex array object.
+    if (gl::BindVertexArray) {
+        MBGL_CHECK_ERROR(gl::BindVertexArray(0));
+    }
+
+    size_t bytes = 0;
+    bool changed = false;
+    for (const auto& source : activeSources) {
+        if (source->source && source->source->upload(budget, bytes)) {
+            changed = true;
+        }
+    }
+
+    if (bytes) {
+        std::lock_guard<std::mutex> lock(mutexUploadStats);
+        uploadStats.lastFrameBytes = bytes;
+        uploadStats.maxFrameBytes = std::max(uploadStats.maxFrameBytes, bytes);
+        uploadStats.totalBytes += bytes;
+        uploadStats.frames++;
+    }
+
+    // Tiles that became ready replace the tiles standing in for them, and tiles that are still
+    // waiting need another frame.
+    if (changed && mode == Mode::Continuous) {
+        triggerUpdate();
+    }
+}
+
 void Map::update() {
     assert(Environment::currentlyOn(ThreadType::Map));
 
@@ -789,7 +895,7 @@ void Map::reloadStyle() {
         // We have a style URL
         env->request({ Resource::Kind::JSON, styleInfo.url }, [this, base](const Response &res) {
             if (res.status == Response::Successful) {
-                loadStyleJSON(res.data, base);
+                loadStyleJSON(*res.data, base);
             } else {
                 Log::Error(Event::Setup, "loading style failed: %s", res.message.c_str());
             }
@@ -870,8 +976,11 @@ void Map::render() {
     // Cleanup OpenGL objects that we abandoned since the last render call.
     env->performCleanup();
 
+    uploadTiles();
+
     assert(style);
     assert(painter);
+    painter->setFillBatching(data->getFillBatching());
     painter->render(*style, activeSources,
                     state, data->getAnimationTime());
     // Schedule another rerender when we definitely need a next frame.
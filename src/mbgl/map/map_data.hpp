@@ -70,6 +70,27 @@ public:
         debug = value;
     }
 
+    inline std::size_t getSourceTileCacheSize() const {
+        return sourceTileCacheSize;
+    }
+    inline void setSourceTileCacheSize(std::size_t bytes) {
+        sourceTileCacheSize = bytes;
+    }
+
+    inline std::size_t getUploadBudget() const {
+        return uploadBudget;
+    }
+    inline void setUploadBudget(std::size_t bytes) {
+        uploadBudget = bytes;
+    }
+
+    inline bool getFillBatching() const {
+        return fillBatching;
+    }
+    inline void setFillBatching(bool value) {
+        fillBatching = value;
+    }
+
     inline std::chrono::steady_clock::time_point getAnimationTime() const {
         // We're casting the time_point to and from a duration because libstdc++
         // has a bug that doesn't allow time_points to be atomic.
@@ -93,6 +114,9 @@ private:
     std::string accessToken;
     std::vector<std::string> classes;
     std::atomic<uint8_t> debug { false };
+    std::atomic<std::size_t> sourceTileCacheSize { 0 };
+    std::atomic<std::size_t> uploadBudget { 1024 * 1024 };
+    std::atomic<bool> fillBatching { false };
     std::atomic<std::chrono::steady_clock::time_point::duration> animationTime;
     std::atomic<std::chrono::steady_clock::duration> defaultTransitionDuration;
 };
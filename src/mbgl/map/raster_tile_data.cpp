@@ -17,17 +17,17 @@ void RasterTileData::parse() {
         return;
     }
 
-    if (bucket.setImage(data)) {
+    if (bucket.setImage(*data)) {
         state = State::parsed;
     } else {
         state = State::invalid;
     }
 }
 
-void RasterTileData::render(Painter &painter, const StyleLayer &layer_desc, const mat4 &matrix) {
-    bucket.render(painter, layer_desc, id, matrix);
+Bucket* RasterTileData::getBucket(StyleLayer const&) {
+    return &bucket;
 }
 
-bool RasterTileData::hasData(StyleLayer const& /*layer_desc*/) const {
-    return bucket.hasData();
+std::size_t RasterTileData::getByteSize() const {
+    return TileData::getByteSize() + bucket.raster.width * bucket.raster.height * 4;
 }
@@ -3,6 +3,7 @@
 #include <mbgl/map/environment.hpp>
 #include <mbgl/map/transform.hpp>
 #include <mbgl/renderer/painter.hpp>
+#include <mbgl/renderer/bucket.hpp>
 #include <mbgl/util/constants.hpp>
 #include <mbgl/util/raster.hpp>
 #include <mbgl/util/string.hpp>
@@ -51,7 +52,7 @@ void Source::load(Map &map, Environment &env) {
         }
 
         rapidjson::Document d;
-        d.Parse<0>(res.data.c_str());
+        d.Parse<0>(res.data->c_str());
 
         if (d.HasParseError()) {
             Log::Warning(Event::General, "Invalid source TileJSON; Parse Error at %d: %s", d.GetErrorOffset(), d.GetParseError());
@@ -97,20 +98,47 @@ void Source::drawClippingMasks(Painter &painter) {
     }
 }
 
+// Returns the bucket of a ready tile if it has something to draw for the layer. Raster tiles
+// are drawn without data too, so that they can fade.
+static Bucket* renderableBucket(const Tile& tile, const StyleLayer& layer_desc) {
+    if (!tile.data || !tile.data->ready()) {
+        return nullptr;
+    }
+    Bucket* bucket = tile.data->getBucket(layer_desc);
+    if (bucket && (bucket->hasData() || layer_desc.type == StyleLayerType::Raster)) {
+        return bucket;
+    }
+    return nullptr;
+}
+
 void Source::render(Painter &painter, const StyleLayer &layer_desc) {
-    gl::group group(std::string { "layer: " } + layer_desc.id);
+    layerTiles.clear();
     for (const auto& pair : tiles) {
-        Tile &tile = *pair.second;
-        if (tile.data && tile.data->state == TileData::State::parsed) {
-            painter.renderTileLayer(tile, layer_desc, tile.matrix);
+        const Tile &tile = *pair.second;
+        if (Bucket* bucket = renderableBucket(tile, layer_desc)) {
+            layerTiles.emplace_back(&tile, bucket);
         }
     }
+
+    if (layerTiles.empty()) {
+        return;
+    }
+
+    FillBatch* batch = nullptr;
+    if (painter.canBatch(layerTiles, layer_desc)) {
+        LayerBatch& layerBatch = fillBatches[&layer_desc];
+        layerBatch.drawn = true;
+        batch = &layerBatch.batch;
+    }
+    painter.renderTileLayers(layerTiles, layer_desc, batch);
 }
 
 void Source::render(Painter &painter, const StyleLayer &layer_desc, const Tile::ID &id, const mat4 &matrix) {
     auto it = tiles.find(id);
-    if (it != tiles.end() && it->second->data && it->second->data->state == TileData::State::parsed) {
-        painter.renderTileLayer(*it->second, layer_desc, matrix);
+    if (it != tiles.end()) {
+        if (Bucket* bucket = renderableBucket(*it->second, layer_desc)) {
+            painter.renderTileLayer(*it->second, *bucket, layer_desc, matrix);
+        }
     }
 }
 
@@ -119,6 +147,15 @@ void Source::finishRender(Painter &painter) {
         Tile &tile = *pair.second;
         painter.renderTileDebug(tile);
     }
+
+    for (auto it = fillBatches.begin(); it != fillBatches.end();) {
+        if (it->second.drawn) {
+            it->second.drawn = false;
+            ++it;
+        } else {
+            it = fillBatches.erase(it);
+        }
+    }
 }
 
 std::forward_list<Tile::ID> Source::getIDs() const {
@@ -143,6 +180,38 @@ std::forward_list<Tile *> Source::getLoadedTiles() const {
 }
 
 
+bool Source::upload(std::size_t budget, std::size_t& bytes) {
+    bool changed = false;
+
+    const auto uploadTile = [&](TileData& data) {
+        if (data.state != TileData::State::parsed || data.ready()) {
+            return;
+        }
+        if (bytes < budget) {
+            bytes += data.upload(budget - bytes);
+        }
+        // Either the tile can be drawn now, or it needs another frame.
+        changed = true;
+    };
+
+    // Overzoomed tiles share their data, which is uploaded only once.
+    for (const auto& pair : tiles) {
+        if (pair.second->data) {
+            uploadTile(*pair.second->data);
+        }
+    }
+    for (const auto& pair : refreshing) {
+        uploadTile(*pair.second);
+    }
+
+    return changed;
+}
+
+bool Source::isReady(const Tile::ID& id) const {
+    auto it = tiles.find(id);
+    return it != tiles.end() && it->second->data && it->second->data->ready();
+}
+
 TileData::State Source::hasTile(const Tile::ID& id) {
     auto it = tiles.find(id);
     if (it != tiles.end()) {
@@ -184,24 +253,22 @@ TileData::State Source::addTile(Map &map, uv::worker &worker,
         new_tile.data.reset();
     }
 
+    if (!new_tile.data && cache.getSize()) {
+        // Revive a recently evicted tile if we still have it.
+        new_tile.data = cache.get(normalized_id);
+        if (new_tile.data) {
+            tile_data.emplace(new_tile.data->id, new_tile.data);
+        }
+    }
+
     if (!new_tile.data) {
         // If we don't find working tile data, we're just going to load it.
-        if (info.type == SourceType::Vector) {
-            new_tile.data =
-                std::make_shared<VectorTileData>(normalized_id, map.getMaxZoom(), style, glyphAtlas,
-                                                 glyphStore, spriteAtlas, sprite, info);
-            new_tile.data->request(worker, map.getState().getPixelRatio(), callback);
-        } else if (info.type == SourceType::Raster) {
-            new_tile.data = std::make_shared<RasterTileData>(normalized_id, texturePool, info);
-            new_tile.data->request(worker, map.getState().getPixelRatio(), callback);
-        } else if (info.type == SourceType::Annotations) {
-            AnnotationManager& annotationManager = map.getAnnotationManager();
-            new_tile.data = std::make_shared<LiveTileData>(normalized_id, annotationManager,
-                                                           map.getMaxZoom(), style, glyphAtlas,
-                                                           glyphStore, spriteAtlas, sprite, info);
+        new_tile.data = createTileData(map, style, glyphAtlas, glyphStore, spriteAtlas, sprite,
+                                       texturePool, normalized_id);
+        if (info.type == SourceType::Annotations) {
             new_tile.data->reparse(worker, callback);
         } else {
-            throw std::runtime_error("source type not implemented");
+            new_tile.data->request(worker, map.getState().getPixelRatio(), callback);
         }
         tile_data.emplace(new_tile.data->id, new_tile.data);
     }
@@ -209,6 +276,68 @@ TileData::State Source::addTile(Map &map, uv::worker &worker,
     return new_tile.data->state;
 }
 
+util::ptr<TileData> Source::createTileData(Map &map, util::ptr<Style> style,
+                                           GlyphAtlas &glyphAtlas, GlyphStore &glyphStore,
+                                           SpriteAtlas &spriteAtlas, util::ptr<Sprite> sprite,
+                                           TexturePool &texturePool, const Tile::ID &normalized_id) {
+    if (info.type == SourceType::Vector) {
+        auto data = std::make_shared<VectorTileData>(normalized_id, map.getMaxZoom(), style,
+                                                     glyphAtlas, glyphStore, spriteAtlas, sprite,
+                                                     info);
+        if (map.getFillBatching()) {
+            data->retainFillBuffers();
+        }
+        return data;
+    } else if (info.type == SourceType::Raster) {
+        return std::make_shared<RasterTileData>(normalized_id, texturePool, info);
+    } else if (info.type == SourceType::Annotations) {
+        AnnotationManager& annotationManager = map.getAnnotationManager();
+        return std::make_shared<LiveTileData>(normalized_id, annotationManager, map.getMaxZoom(),
+                                              style, glyphAtlas, glyphStore, spriteAtlas, sprite,
+                                              info);
+    } else {
+        throw std::runtime_error("source type not implemented");
+    }
+}
+
+void Source::refreshTile(Map &map, uv::worker &worker, util::ptr<Style> style,
+                         GlyphAtlas &glyphAtlas, GlyphStore &glyphStore, SpriteAtlas &spriteAtlas,
+                         util::ptr<Sprite> sprite, TexturePool &texturePool, Tile &tile,
+                         std::function<void()> callback) {
+    const util::ptr<TileData> current = tile.data;
+
+    auto it = refreshing.find(current->id);
+    if (it == refreshing.end()) {
+        if (current->refreshed) {
+            // Keep rendering the stale tile while the replacement is parsed.
+            util::ptr<TileData> replacement = createTileData(map, style, glyphAtlas, glyphStore,
+                                                             spriteAtlas, sprite, texturePool,
+                                                             current->id);
+            replacement->load(*current->refreshed, worker, callback);
+            current->refreshed.reset();
+            refreshing.emplace(current->id, replacement);
+        }
+        return;
+    }
+
+    const util::ptr<TileData> replacement = it->second;
+    if (replacement->state == TileData::State::partial) {
+        replacement->resume(worker, callback);
+    } else if (replacement->ready()) {
+        // Overzoomed tiles share their data with the tile at the source's maximum zoom.
+        for (const auto &pair : tiles) {
+            if (pair.second->data == current) {
+                pair.second->data = replacement;
+            }
+        }
+        tile_data[current->id] = replacement;
+        current->cancel();
+        refreshing.erase(it);
+    } else if (replacement->state == TileData::State::obsolete) {
+        refreshing.erase(it);
+    }
+}
+
 double Source::getZoom(const TransformState& state) const {
     double offset = std::log(util::tileSize / info.tile_size) / std::log(2);
     return state.getZoom() + offset;
@@ -218,6 +347,16 @@ int32_t Source::coveringZoomLevel(const TransformState& state) const {
     return std::floor(getZoom(state));
 }
 
+// Manhattan distance between a tile and a point in tile units of the tile's zoom level.
+static double distanceToCenter(const Tile::ID& id, const vec2<double>& center) {
+    return std::fabs(id.x - center.x) + std::fabs(id.y - center.y);
+}
+
+vec2<double> Source::coveringCenter(const TransformState& state) const {
+    const int32_t z = std::min<int32_t>(coveringZoomLevel(state), info.max_zoom);
+    return state.cornersToBox(z).center;
+}
+
 std::forward_list<Tile::ID> Source::coveringTiles(const TransformState& state) const {
     int32_t z = coveringZoomLevel(state);
 
@@ -232,8 +371,7 @@ std::forward_list<Tile::ID> Source::coveringTiles(const TransformState& state) c
 
     covering_tiles.sort([&center](const Tile::ID& a, const Tile::ID& b) {
         // Sorts by distance from the box center
-        return std::fabs(a.x - center.x) + std::fabs(a.y - center.y) <
-               std::fabs(b.x - center.x) + std::fabs(b.y - center.y);
+        return distanceToCenter(a, center) < distanceToCenter(b, center);
     });
 
     return covering_tiles;
@@ -253,8 +391,7 @@ bool Source::findLoadedChildren(const Tile::ID& id, int32_t maxCoveringZoom, std
     int32_t z = id.z;
     auto ids = id.children(z + 1);
     for (const auto& child_id : ids) {
-        const TileData::State state = hasTile(child_id);
-        if (state == TileData::State::parsed) {
+        if (isReady(child_id)) {
             retain.emplace_front(child_id);
         } else {
             complete = false;
@@ -279,8 +416,7 @@ bool Source::findLoadedChildren(const Tile::ID& id, int32_t maxCoveringZoom, std
 bool Source::findLoadedParent(const Tile::ID& id, int32_t minCoveringZoom, std::forward_list<Tile::ID>& retain) {
     for (int32_t z = id.z - 1; z >= minCoveringZoom; --z) {
         const Tile::ID parent_id = id.parent(z);
-        const TileData::State state = hasTile(parent_id);
-        if (state == TileData::State::parsed) {
+        if (isReady(parent_id)) {
             retain.emplace_front(parent_id);
             return true;
         }
@@ -301,8 +437,11 @@ void Source::update(Map &map,
         return;
     }
 
+    cache.setSize(info.type == SourceType::Annotations ? 0 : map.getSourceTileCacheSize());
+
     int32_t zoom = std::floor(getZoom(map.getState()));
     std::forward_list<Tile::ID> required = coveringTiles(map.getState());
+    const vec2<double> center = coveringCenter(map.getState());
 
     // Determine the overzooming/underzooming amounts.
     int32_t minCoveringZoom = util::clamp<int32_t>(zoom - 10, info.min_zoom, info.max_zoom);
@@ -318,9 +457,26 @@ void Source::update(Map &map,
         const TileData::State state = addTile(map, worker, style, glyphAtlas, glyphStore,
                                               spriteAtlas, sprite, texturePool, id, callback);
 
-        if (state != TileData::State::parsed) {
-            // The tile we require is not yet loaded. Try to find a parent or
-            // child tile that we already have.
+        if (state == TileData::State::loading || state == TileData::State::loaded ||
+            state == TileData::State::partial) {
+            // Parse the tiles closest to the center of the viewport first.
+            tiles[id]->data->setPriority(distanceToCenter(id, center));
+        }
+
+        if (state == TileData::State::partial) {
+            // Finish parsing the tile if the glyphs and sprites it waits for have arrived.
+            tiles[id]->data->resume(worker, callback);
+        }
+
+        if (state == TileData::State::partial || state == TileData::State::parsed) {
+            // Pick up the data of a revalidated stale tile.
+            refreshTile(map, worker, style, glyphAtlas, glyphStore, spriteAtlas, sprite,
+                        texturePool, *tiles[id], callback);
+        }
+
+        if (!isReady(id)) {
+            // The tile we require is not yet loaded or uploaded. Try to find a
+            // parent or child tile that we can draw instead.
 
             // First, try to find existing child tiles that completely cover the
             // missing tile.
@@ -335,19 +491,24 @@ void Source::update(Map &map,
     }
 
     // Remove tiles that we definitely don't need, i.e. tiles that are not on
-    // the required list.
+    // the required list. Hold on to their data until we know whether it can
+    // go into the cache.
     std::set<Tile::ID> retain_data;
-    util::erase_if(tiles, [&retain, &retain_data](std::pair<const Tile::ID, std::unique_ptr<Tile>> &pair) {
+    std::vector<util::ptr<TileData>> evicted;
+    util::erase_if(tiles, [&retain, &retain_data, &evicted](std::pair<const Tile::ID, std::unique_ptr<Tile>> &pair) {
         Tile &tile = *pair.second;
         bool obsolete = std::find(retain.begin(), retain.end(), tile.id) == retain.end();
         if (!obsolete) {
             retain_data.insert(tile.data->id);
+        } else if (tile.data) {
+            evicted.push_back(tile.data);
         }
         return obsolete;
     });
 
-    // Remove all the expired pointers from the set.
-    util::erase_if(tile_data, [&retain_data](std::pair<const Tile::ID, std::weak_ptr<TileData>> &pair) {
+    // Remove all the expired pointers from the set. Parsed tiles move into the
+    // cache; all others are canceled.
+    util::erase_if(tile_data, [this, &retain_data](std::pair<const Tile::ID, std::weak_ptr<TileData>> &pair) {
         const util::ptr<TileData> tile = pair.second.lock();
         if (!tile) {
             return true;
@@ -355,13 +516,26 @@ void Source::update(Map &map,
 
         bool obsolete = retain_data.find(tile->id) == retain_data.end();
         if (obsolete) {
-            tile->cancel();
+            if (cache.getSize() && tile->state == TileData::State::parsed) {
+                cache.add(tile->id, tile);
+            } else {
+                tile->cancel();
+            }
             return true;
         } else {
             return false;
         }
     });
 
+    // Drop replacements of tiles that went away in the meantime.
+    util::erase_if(refreshing, [&retain_data](std::pair<const Tile::ID, util::ptr<TileData>> &pair) {
+        if (retain_data.find(pair.first) == retain_data.end()) {
+            pair.second->cancel();
+            return true;
+        }
+        return false;
+    });
+
     updated = map.getTime();
 }
 
@@ -369,6 +543,12 @@ void Source::invalidateTiles(Map& map, const std::vector<Tile::ID>& ids) {
     for (auto& id : ids) {
         tiles.erase(id);
         tile_data.erase(id);
+        cache.remove(id);
+        auto it = refreshing.find(id);
+        if (it != refreshing.end()) {
+            it->second->cancel();
+            refreshing.erase(it);
+        }
     }
     map.triggerUpdate();
 }
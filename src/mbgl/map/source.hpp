@@ -3,10 +3,13 @@
 
 #include <mbgl/map/tile.hpp>
 #include <mbgl/map/tile_data.hpp>
+#include <mbgl/map/tile_cache.hpp>
+#include <mbgl/renderer/fill_batch.hpp>
 #include <mbgl/style/style_source.hpp>
 
 #include <mbgl/util/noncopyable.hpp>
 #include <mbgl/util/mat4.hpp>
+#include <mbgl/util/vec.hpp>
 #include <mbgl/util/ptr.hpp>
 
 #include <cstdint>
@@ -14,10 +17,14 @@
 #include <iosfwd>
 #include <map>
 #include <chrono>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace mbgl {
 
 class Map;
+class Bucket;
 class Environment;
 class GlyphAtlas;
 class GlyphStore;
@@ -46,21 +53,39 @@ public:
     void render(Painter &painter, const StyleLayer &layer_desc, const Tile::ID &id, const mat4 &matrix);
     void finishRender(Painter &painter);
 
+    // Uploads the buffers of parsed tiles until /bytes/ reaches /budget/, and adds the bytes
+    // uploaded to it. Returns true if a tile became ready to draw or still waits for its upload.
+    bool upload(std::size_t budget, std::size_t& bytes);
+
     std::forward_list<Tile::ID> getIDs() const;
     std::forward_list<Tile *> getLoadedTiles() const;
     void updateClipIDs(const std::map<Tile::ID, ClipID> &mapping);
 
+    const TileCache::Stats& getCacheStats() const { return cache.getStats(); }
+
 private:
     bool findLoadedChildren(const Tile::ID& id, int32_t maxCoveringZoom, std::forward_list<Tile::ID>& retain);
     bool findLoadedParent(const Tile::ID& id, int32_t minCoveringZoom, std::forward_list<Tile::ID>& retain);
     int32_t coveringZoomLevel(const TransformState&) const;
     std::forward_list<Tile::ID> coveringTiles(const TransformState&) const;
+    vec2<double> coveringCenter(const TransformState&) const;
 
     TileData::State addTile(Map &, uv::worker &, util::ptr<Style>, GlyphAtlas &,
                             GlyphStore &, SpriteAtlas &, util::ptr<Sprite>, TexturePool &,
                             const Tile::ID &, std::function<void()> callback);
 
+    util::ptr<TileData> createTileData(Map &, util::ptr<Style>, GlyphAtlas &, GlyphStore &,
+                                       SpriteAtlas &, util::ptr<Sprite>, TexturePool &,
+                                       const Tile::ID &normalized_id);
+
+    // Replaces the data of a tile that was parsed from stale data once the revalidated data is
+    // parsed.
+    void refreshTile(Map &, uv::worker &, util::ptr<Style>, GlyphAtlas &, GlyphStore &,
+                     SpriteAtlas &, util::ptr<Sprite>, TexturePool &, Tile &,
+                     std::function<void()> callback);
+
     TileData::State hasTile(const Tile::ID& id);
+    bool isReady(const Tile::ID& id) const;
 
     double getZoom(const TransformState &state) const;
 
@@ -72,6 +97,21 @@ private:
 
     std::map<Tile::ID, std::unique_ptr<Tile>> tiles;
     std::map<Tile::ID, std::weak_ptr<TileData>> tile_data;
+
+    // The tiles with data for the layer that is being rendered, and their buckets.
+    std::vector<std::pair<const Tile*, Bucket*>> layerTiles;
+
+    // The fills of the layers that were drawn as batches. Batches of layers that weren't drawn
+    // in a frame are dropped by finishRender().
+    struct LayerBatch {
+        FillBatch batch;
+        bool drawn = false;
+    };
+    std::unordered_map<const StyleLayer*, LayerBatch> fillBatches;
+
+    // Replacements for tiles with refreshed data, by normalized ID, while they are parsed.
+    std::map<Tile::ID, util::ptr<TileData>> refreshing;
+    TileCache cache;
 };
 
 }
@@ -24,13 +24,14 @@ SpritePosition::SpritePosition(uint16_t x_, uint16_t y_, uint16_t width_, uint16
       sdf(sdf_) {
 }
 
-util::ptr<Sprite> Sprite::Create(const std::string &base_url, float pixelRatio, Environment &env) {
-    util::ptr<Sprite> sprite(std::make_shared<Sprite>(Key(), base_url, pixelRatio));
+util::ptr<Sprite> Sprite::Create(const std::string &base_url, float pixelRatio, Environment &env,
+                                 std::function<void()> callback) {
+    util::ptr<Sprite> sprite(std::make_shared<Sprite>(Key(), base_url, pixelRatio, callback));
     sprite->load(env);
     return sprite;
 }
 
-Sprite::Sprite(const Key &, const std::string& base_url, float pixelRatio_)
+Sprite::Sprite(const Key &, const std::string& base_url, float pixelRatio_, std::function<void()> callback_)
     : valid(base_url.length() > 0),
       pixelRatio(pixelRatio_ > 1 ? 2 : 1),
       spriteURL(base_url + (pixelRatio_ > 1 ? "@2x" : "") + ".png"),
@@ -38,7 +39,7 @@ Sprite::Sprite(const Key &, const std::string& base_url, float pixelRatio_)
       raster(),
       loadedImage(false),
       loadedJSON(false),
-      future(promise.get_future()) {
+      callback(callback_) {
 }
 
 bool Sprite::hasPixelRatio(float ratio) const {
@@ -46,10 +47,6 @@ bool Sprite::hasPixelRatio(float ratio) const {
 }
 
 
-void Sprite::waitUntilLoaded() const {
-    future.wait();
-}
-
 Sprite::operator bool() const {
     return valid && isLoaded() && !pos.empty();
 }
@@ -63,7 +60,6 @@ void Sprite::load(Environment &env) {
         // Treat a non-existent sprite as a successfully loaded empty sprite.
         loadedImage = true;
         loadedJSON = true;
-        promise.set_value();
         return;
     }
 
@@ -71,8 +67,7 @@ void Sprite::load(Environment &env) {
 
     env.request({ Resource::Kind::JSON, jsonURL }, [sprite](const Response &res) {
         if (res.status == Response::Successful) {
-            sprite->body = res.data;
-            sprite->parseJSON();
+            sprite->parseJSON(*res.data);
         } else {
             Log::Warning(Event::Sprite, "Failed to load sprite info: %s", res.message.c_str());
         }
@@ -82,8 +77,7 @@ void Sprite::load(Environment &env) {
 
     env.request({ Resource::Kind::Image, spriteURL }, [sprite](const Response &res) {
         if (res.status == Response::Successful) {
-            sprite->image = res.data;
-            sprite->parseImage();
+            sprite->parseImage(*res.data);
         } else {
             Log::Warning(Event::Sprite, "Failed to load sprite image: %s", res.message.c_str());
         }
@@ -93,8 +87,8 @@ void Sprite::load(Environment &env) {
 }
 
 void Sprite::complete() {
-    if (loadedImage && loadedJSON) {
-        promise.set_value();
+    if (loadedImage && loadedJSON && callback) {
+        callback();
     }
 }
 
@@ -102,18 +96,16 @@ bool Sprite::isLoaded() const {
     return loadedImage && loadedJSON;
 }
 
-void Sprite::parseImage() {
+void Sprite::parseImage(const std::string& image) {
     raster = util::make_unique<util::Image>(image);
     if (!*raster) {
         raster.reset();
     }
-    image.clear();
 }
 
-void Sprite::parseJSON() {
+void Sprite::parseJSON(const std::string& json) {
     rapidjson::Document d;
-    d.Parse<0>(body.c_str());
-    body.clear();
+    d.Parse<0>(json.c_str());
 
     if (d.HasParseError()) {
         Log::Warning(Event::Sprite, "sprite JSON is invalid");
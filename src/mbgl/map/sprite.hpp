@@ -10,7 +10,7 @@
 #include <iosfwd>
 #include <string>
 #include <unordered_map>
-#include <future>
+#include <functional>
 
 namespace mbgl {
 
@@ -37,15 +37,17 @@ private:
     void load(Environment &env);
 
 public:
-    Sprite(const Key &, const std::string& base_url, float pixelRatio);
+    Sprite(const Key &, const std::string& base_url, float pixelRatio, std::function<void()> callback);
+
+    // The callback is called on the map thread once both the image and the JSON have loaded.
     static util::ptr<Sprite>
-    Create(const std::string &base_url, float pixelRatio, Environment &env);
+    Create(const std::string &base_url, float pixelRatio, Environment &env,
+           std::function<void()> callback = nullptr);
 
     const SpritePosition &getSpritePosition(const std::string& name) const;
 
     bool hasPixelRatio(float ratio) const;
 
-    void waitUntilLoaded() const;
     bool isLoaded() const;
 
     operator bool() const;
@@ -60,21 +62,17 @@ public:
     std::unique_ptr<util::Image> raster;
 
 private:
-    void parseJSON();
-    void parseImage();
+    void parseJSON(const std::string& json);
+    void parseImage(const std::string& image);
     void complete();
 
 private:
-    std::string body;
-    std::string image;
     std::atomic<bool> loadedImage;
     std::atomic<bool> loadedJSON;
     std::unordered_map<std::string, SpritePosition> pos;
     const SpritePosition empty;
 
-    std::promise<void> promise;
-    std::future<void> future;
-
+    std::function<void()> callback;
 };
 
 }
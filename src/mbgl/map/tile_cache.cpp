@@ -0,0 +1,80 @@
+#include <mbgl/map/tile_cache.hpp>
+#include <mbgl/map/tile_data.hpp>
+
+#include <cassert>
+
+namespace mbgl {
+
+void TileCache::setSize(std::size_t bytes) {
+    maxBytes = bytes;
+    evict(maxBytes);
+}
+
+void TileCache::add(const Tile::ID& id, util::ptr<TileData> data) {
+    assert(data);
+
+    remove(id);
+
+    const std::size_t bytes = data->getByteSize();
+    if (bytes > maxBytes) {
+        // The tile would never fit; drop it right away.
+        stats.evictions++;
+        return;
+    }
+
+    evict(maxBytes - bytes);
+
+    order.push_front(id);
+    entries.emplace(id, Entry { std::move(data), bytes, order.begin() });
+    stats.bytes += bytes;
+    stats.tiles++;
+}
+
+util::ptr<TileData> TileCache::get(const Tile::ID& id) {
+    auto it = entries.find(id);
+    if (it == entries.end()) {
+        stats.misses++;
+        return nullptr;
+    }
+
+    stats.hits++;
+    util::ptr<TileData> data = std::move(it->second.data);
+    erase(it);
+    return data;
+}
+
+bool TileCache::has(const Tile::ID& id) const {
+    return entries.find(id) != entries.end();
+}
+
+void TileCache::remove(const Tile::ID& id) {
+    auto it = entries.find(id);
+    if (it != entries.end()) {
+        erase(it);
+    }
+}
+
+void TileCache::clear() {
+    order.clear();
+    entries.clear();
+    stats.bytes = 0;
+    stats.tiles = 0;
+}
+
+void TileCache::evict(std::size_t bytes) {
+    while (stats.bytes > bytes && !order.empty()) {
+        auto it = entries.find(order.back());
+        assert(it != entries.end());
+        erase(it);
+        stats.evictions++;
+    }
+}
+
+void TileCache::erase(std::map<Tile::ID, Entry>::iterator it) {
+    stats.bytes -= it->second.bytes;
+    stats.tiles--;
+    order.erase(it->second.order);
+    entries.erase(it);
+}
+
+}
@@ -0,0 +1,66 @@
+#ifndef MBGL_MAP_TILE_CACHE
+#define MBGL_MAP_TILE_CACHE
+
+#include <mbgl/map/tile.hpp>
+#include <mbgl/util/noncopyable.hpp>
+#include <mbgl/util/ptr.hpp>
+
+#include <cstdint>
+#include <list>
+#include <map>
+
+namespace mbgl {
+
+class TileData;
+
+// Keeps recently evicted, fully parsed tiles alive, including their GL
+// buffers, so that panning back to them doesn't require another request and
+// parse. Tiles are evicted in least-recently-used order once the sum of their
+// estimated sizes exceeds the byte budget. A budget of zero disables the cache.
+class TileCache : private util::noncopyable {
+public:
+    struct Stats {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        std::size_t bytes = 0;
+        std::size_t tiles = 0;
+    };
+
+    void setSize(std::size_t bytes);
+    std::size_t getSize() const { return maxBytes; }
+
+    void add(const Tile::ID&, util::ptr<TileData>);
+
+    // Removes the tile from the cache and returns it, or returns an empty
+    // pointer if the tile isn't cached.
+    util::ptr<TileData> get(const Tile::ID&);
+
+    bool has(const Tile::ID&) const;
+    void remove(const Tile::ID&);
+    void clear();
+
+    const Stats& getStats() const { return stats; }
+
+private:
+    struct Entry {
+        util::ptr<TileData> data;
+        std::size_t bytes;
+        std::list<Tile::ID>::iterator order;
+    };
+
+    void evict(std::size_t bytes);
+    void erase(std::map<Tile::ID, Entry>::iterator);
+
+    std::size_t maxBytes = 0;
+
+    // Most recently used tiles are at the front.
+    std::list<Tile::ID> order;
+    std::map<Tile::ID, Entry> entries;
+
+    Stats stats;
+};
+
+}
+
+#endif
@@ -3,10 +3,9 @@
 #include <mbgl/map/environment.hpp>
 #include <mbgl/style/style_source.hpp>
 
-#include <mbgl/util/token.hpp>
-#include <mbgl/util/string.hpp>
-#include <mbgl/util/mapbox.hpp>
 #include <mbgl/storage/file_source.hpp>
+#include <mbgl/storage/response.hpp>
+#include <mbgl/util/compression.hpp>
 #include <mbgl/util/uv_detail.hpp>
 #include <mbgl/platform/log.hpp>
 
@@ -29,6 +28,30 @@ TileData::~TileData() {
     }
 }
 
+std::size_t TileData::getByteSize() const {
+    return (data ? data->size() : 0) + debugFontBuffer.bytes();
+}
+
+std::size_t TileData::upload(std::size_t budget) {
+    std::size_t bytes = 0;
+    if (state != State::parsed || uploaded) {
+        return bytes;
+    }
+
+    while (bytes < budget) {
+        if (!uploadNext(bytes)) {
+            uploaded = true;
+            break;
+        }
+    }
+    return bytes;
+}
+
+bool TileData::uploadNext(std::size_t&) {
+    // Raster tiles upload their texture when they're first drawn.
+    return false;
+}
+
 const std::string TileData::toString() const {
     return std::string { "[tile " } + name + "]";
 }
@@ -37,26 +60,12 @@ void TileData::request(uv::worker &worker, float pixelRatio, std::function<void(
     if (source.tiles.empty())
         return;
 
-    std::string url = source.tiles[(id.x + id.y) % source.tiles.size()];
-    url = util::mapbox::normalizeTileURL(url, source.url, source.type);
-    url = util::replaceTokens(url, [&](const std::string &token) -> std::string {
-        if (token == "z") return util::toString(id.z);
-        if (token == "x") return util::toString(id.x);
-        if (token == "y") return util::toString(id.y);
-        if (token == "prefix") {
-            std::string prefix { 2 };
-            prefix[0] = "0123456789abcdef"[id.x % 16];
-            prefix[1] = "0123456789abcdef"[id.y % 16];
-            return prefix;
-        }
-        if (token == "ratio") return pixelRatio > 1.0 ? "@2x" : "";
-        return "";
-    });
+    const std::string url = source.tileURL(id, pixelRatio);
 
     state = State::loading;
 
     std::weak_ptr<TileData> weak_tile = shared_from_this();
-    req = env.request({ Resource::Kind::Tile, url }, [weak_tile, url, callback, &worker](const Response &res) {
+    req = env.request({ Resource::Kind::Tile, url, requestPriority(), true }, [weak_tile, url, callback, &worker](const Response &res) {
         util::ptr<TileData> tile = weak_tile.lock();
         if (!tile || tile->state == State::obsolete) {
             // noop. Tile is obsolete and we're now just waiting for the refcount
@@ -64,22 +73,41 @@ void TileData::request(uv::worker &worker, float pixelRatio, std::function<void(
             return;
         }
 
-        // Clear the request object.
-        tile->req = nullptr;
-
-        if (res.status == Response::Successful) {
-            tile->state = State::loaded;
+        // Clear the request object once it is done. After a stale response, the request stays
+        // alive until the revalidation finished, and delivers the new data only if it changed.
+        // Until then, the tile can still cancel it or change its priority.
+        if (!res.stale) {
+            tile->req = nullptr;
+        }
 
-            tile->data = res.data;
+        if (res.status == Response::Successful && tile->state != State::loading) {
+            if (res.notModified) {
+                // The revalidation confirmed the data the tile was parsed from. Keep the buckets.
+                return;
+            }
 
-            // Schedule tile parsing in another thread
-            tile->reparse(worker, callback);
+            // The tile already parsed the stale data. Its source builds a replacement from the
+            // refreshed data and swaps it in once it is parsed.
+            tile->refreshed = std::make_shared<Response>(res);
+            callback();
+        } else if (res.status == Response::Successful) {
+            tile->load(res, worker, callback);
         } else {
             Log::Error(Event::HttpRequest, "[%s] tile loading failed: %s", url.c_str(), res.message.c_str());
         }
     });
 }
 
+void TileData::load(const Response &res, uv::worker &worker, std::function<void()> callback) {
+    state = State::loaded;
+
+    data = res.data;
+    encoding = res.encoding;
+
+    // Schedule tile parsing in another thread
+    reparse(worker, callback);
+}
+
 void TileData::cancel() {
     if (state != State::obsolete) {
         state = State::obsolete;
@@ -88,19 +116,72 @@ void TileData::cancel() {
         env.cancelRequest(req);
         req = nullptr;
     }
+    if (parsing) {
+        // Drop the parse job if no worker picked it up yet.
+        parsing->cancel();
+        parsing = nullptr;
+    }
+}
+
+void TileData::setPriority(double priority_) {
+    if (priority == priority_) {
+        return;
+    }
+    priority = priority_;
+    if (parsing) {
+        parsing->setPriority(priority);
+    }
+    if (req) {
+        env.setRequestPriority(req, requestPriority());
+    }
+}
+
+double TileData::requestPriority() const {
+    // Style, sprite, glyph and TileJSON requests use 0 and go before all tiles.
+    return 1 + priority;
+}
+
+void TileData::resume(uv::worker& worker, std::function<void()> callback) {
+    if (state == State::partial && !parsing && requestDependencies(callback)) {
+        reparse(worker, callback);
+    }
+}
+
+bool TileData::decode() {
+    if (encoding.empty()) {
+        return true;
+    }
+
+    try {
+        data = std::make_shared<const std::string>(util::decompress(*data));
+        encoding.clear();
+        return true;
+    } catch (const std::exception& ex) {
+        Log::Error(Event::ParseTile, "Inflating [%d/%d/%d] failed: %s", id.z, id.x, id.y, ex.what());
+        state = State::obsolete;
+        return false;
+    }
+}
+
+bool TileData::requestDependencies(std::function<void()>) {
+    return true;
 }
 
 void TileData::reparse(uv::worker& worker, std::function<void()> callback)
 {
     // We're creating a new work request. The work request deletes itself after it executed
-    // the after work handler
-    new uv::work<util::ptr<TileData>>(
+    // the after work handler, or when it is canceled before it started.
+    parsing = new uv::work<util::ptr<TileData>>(
         worker,
+        priority,
         [this](util::ptr<TileData>& tile) {
             EnvironmentScope scope(env, ThreadType::TileWorker, "TileWorker_" + tile->name);
-            tile->parse();
+            if (tile->decode()) {
+                tile->parse();
+            }
         },
-        [callback](util::ptr<TileData>&) {
+        [callback](util::ptr<TileData>& tile) {
+            tile->parsing = nullptr;
             callback();
         },
         shared_from_this());
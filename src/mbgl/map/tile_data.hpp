@@ -9,22 +9,26 @@
 #include <mbgl/util/ptr.hpp>
 
 #include <atomic>
+#include <memory>
 #include <string>
 #include <functional>
 
 namespace uv {
 class worker;
+template <typename T> class work;
 }
 
 typedef struct uv_loop_s uv_loop_t;
 
 namespace mbgl {
 
+class Bucket;
 class Environment;
 class Painter;
 class SourceInfo;
 class StyleLayer;
 class Request;
+class Response;
 
 class TileData : public std::enable_shared_from_this<TileData>,
              private util::noncopyable {
@@ -34,6 +38,7 @@ public:
         initial,
         loading,
         loaded,
+        partial, // Parsed, except for symbols that wait for glyphs or sprites.
         parsed,
         obsolete
     };
@@ -43,28 +48,77 @@ public:
 
     void request(uv::worker&, float pixelRatio, std::function<void ()> callback);
     void reparse(uv::worker&, std::function<void ()> callback);
+
+    // Parses a tile response that was obtained elsewhere, e.g. the refreshed data of another tile.
+    void load(const Response &, uv::worker&, std::function<void ()> callback);
+
+    // Finishes parsing a partial tile once the resources it waits for are
+    // available. Must be called on the map thread.
+    void resume(uv::worker&, std::function<void ()> callback);
     void cancel();
     const std::string toString() const;
 
+    // Sets the priority of this tile's download and parse job. Lower values
+    // go first; sources use the distance to the viewport center.
+    void setPriority(double priority);
+
+    // Whether the tile is parsed and its buffers are on the GPU, so that it can be drawn.
     inline bool ready() const {
-        return state == State::parsed;
+        return state == State::parsed && uploaded;
     }
 
+    // Uploads the buffers of a parsed tile to the GPU, stopping once /budget/ bytes have been
+    // uploaded. Returns the number of bytes uploaded, which exceeds the budget when a single
+    // buffer is larger than the budget. Must be called on the map thread.
+    std::size_t upload(std::size_t budget);
+
     // Override this in the child class.
     virtual void parse() = 0;
-    virtual void render(Painter &painter, const StyleLayer &layer_desc, const mat4 &matrix) = 0;
-    virtual bool hasData(StyleLayer const &layer_desc) const = 0;
+
+    // Returns the bucket that holds the tile's data for the layer, if there is one.
+    virtual Bucket* getBucket(StyleLayer const &layer_desc) = 0;
+
+    // Returns an estimate of the memory held by this tile, in bytes.
+    virtual std::size_t getByteSize() const;
 
     const Tile::ID id;
     const std::string name;
     std::atomic<State> state;
 
+    // Set when a revalidation of the stale data this tile was parsed from returned different
+    // data. The source parses it into a replacement tile.
+    std::shared_ptr<const Response> refreshed;
+
 protected:
+    // Requests the resources a partial tile waits for, and returns true if all
+    // of them are available. The callback is called when one of them arrives.
+    virtual bool requestDependencies(std::function<void ()> callback);
+
+    // Uploads the next of the tile's buffers. Returns false once all of them are on the GPU,
+    // including right after the last one went up, so that the tile is ready without another call.
+    virtual bool uploadNext(std::size_t& bytes);
+
+    // Inflates data that is still compressed as the server sent it. Runs in the worker before
+    // parse(), so that decompression is spread across the workers. Returns false if it failed.
+    bool decode();
+
+    double requestPriority() const;
+
     const SourceInfo& source;
     Environment& env;
 
     Request *req = nullptr;
-    std::string data;
+
+    // The raw tile, shared with the response it came from until it is decoded.
+    std::shared_ptr<const std::string> data;
+    std::string encoding;
+
+    // Set once upload() transferred all buffers of the parsed tile.
+    bool uploaded = false;
+
+    // The queued or running parse job, if any.
+    uv::work<util::ptr<TileData>> *parsing = nullptr;
+    double priority = 0;
 
     // Contains the tile ID string for painting debug information.
     DebugFontBuffer debugFontBuffer;
@@ -30,22 +30,14 @@ TileParser::~TileParser() = default;
 
 TileParser::TileParser(const GeometryTile& geometryTile_,
                        VectorTileData& tile_,
-                       const util::ptr<const Style>& style_,
-                       GlyphAtlas& glyphAtlas_,
-                       GlyphStore& glyphStore_,
-                       SpriteAtlas& spriteAtlas_,
-                       const util::ptr<Sprite>& sprite_)
+                       const util::ptr<const Style>& style_)
     : geometryTile(geometryTile_),
       tile(tile_),
-      style(style_),
-      glyphAtlas(glyphAtlas_),
-      glyphStore(glyphStore_),
-      spriteAtlas(spriteAtlas_),
-      sprite(sprite_),
-      collision(util::make_unique<Collision>(tile.id.z, 4096, tile.source.tile_size, tile.depth)) {
+      style(style_) {
     assert(style);
-    assert(sprite);
-    assert(collision);
+
+    // The collision state outlives the parser when symbols have to wait for glyphs or sprites.
+    tile.collision = util::make_unique<Collision>(tile.id.z, 4096, tile.source.tile_size, tile.depth);
 }
 
 bool TileParser::obsolete() const { return tile.state == TileData::State::obsolete; }
@@ -151,16 +143,33 @@ std::unique_ptr<Bucket> TileParser::createBucket(const StyleBucket &bucketDesc)
 
 template <class Bucket>
 void TileParser::addBucketGeometries(Bucket& bucket, const GeometryTileLayer& layer, const FilterExpression &filter) {
+    const auto compiledFilter = layer.compileFilter(filter);
+
+    // Count the vertices first, so that the bucket can size the tile's buffers up front.
+    std::vector<util::ptr<const GeometryTileFeature>> features;
+    std::size_t vertexCount = 0;
+
     for (std::size_t i = 0; i < layer.featureCount(); i++) {
         auto feature = layer.getFeature(i);
 
         if (obsolete())
             return;
 
-        GeometryTileFeatureExtractor extractor(*feature);
-        if (!evaluate(filter, extractor))
+        if (!(*compiledFilter)(*feature))
             continue;
 
+        for (const auto& line : feature->getGeometries()) {
+            vertexCount += line.size();
+        }
+        features.push_back(std::move(feature));
+    }
+
+    bucket->reserve(vertexCount);
+
+    for (const auto& feature : features) {
+        if (obsolete())
+            return;
+
         bucket->addGeometry(feature->getGeometries());
     }
 }
@@ -170,6 +179,10 @@ std::unique_ptr<Bucket> TileParser::createFillBucket(const GeometryTileLayer& la
     auto bucket = util::make_unique<FillBucket>(tile.fillVertexBuffer,
                                                 tile.triangleElementsBuffer,
                                                 tile.lineElementsBuffer);
+
+    const float z = tile.id.z;
+    applyLayoutProperty(PropertyKey::FillTriangulation, bucket_desc.layout, bucket->layout.triangulation, z);
+
     addBucketGeometries(bucket, layer, bucket_desc.filter);
     return std::move(bucket);
 }
@@ -194,7 +207,7 @@ std::unique_ptr<Bucket> TileParser::createLineBucket(const GeometryTileLayer& la
 
 std::unique_ptr<Bucket> TileParser::createSymbolBucket(const GeometryTileLayer& layer,
                                                        const StyleBucket& bucket_desc) {
-    auto bucket = util::make_unique<SymbolBucket>(*collision);
+    auto bucket = util::make_unique<SymbolBucket>(*tile.collision);
 
     const float z = tile.id.z;
     auto& layout = bucket->layout;
@@ -237,8 +250,10 @@ std::unique_ptr<Bucket> TileParser::createSymbolBucket(const GeometryTileLayer&
     applyLayoutProperty(PropertyKey::TextOffset, bucket_desc.layout, layout.text.offset, z);
     applyLayoutProperty(PropertyKey::TextAllowOverlap, bucket_desc.layout, layout.text.allow_overlap, z);
 
-    bucket->addFeatures(
-        layer, bucket_desc.filter, reinterpret_cast<uintptr_t>(&tile), spriteAtlas, *sprite, glyphAtlas, glyphStore);
+    // Glyphs and sprites may not have loaded yet, so we only extract the features
+    // here. The tile adds them once their dependencies are available.
+    bucket->prepareFeatures(layer, bucket_desc.filter);
+    tile.pendingSymbolBuckets.push_back(bucket.get());
     return std::move(bucket);
 }
 }
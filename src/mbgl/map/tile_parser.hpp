@@ -18,10 +18,6 @@ namespace mbgl {
 
 class Bucket;
 class FontStack;
-class GlyphAtlas;
-class GlyphStore;
-class SpriteAtlas;
-class Sprite;
 class Style;
 class StyleBucket;
 class StyleLayoutFill;
@@ -30,17 +26,12 @@ class StyleLayoutLine;
 class StyleLayoutSymbol;
 class StyleLayerGroup;
 class VectorTileData;
-class Collision;
 
 class TileParser : private util::noncopyable {
 public:
     TileParser(const GeometryTile& geometryTile,
                VectorTileData& tile,
-               const util::ptr<const Style>& style,
-               GlyphAtlas& glyphAtlas,
-               GlyphStore& glyphStore,
-               SpriteAtlas& spriteAtlas,
-               const util::ptr<Sprite>& sprite);
+               const util::ptr<const Style>& style);
     ~TileParser();
 
 public:
@@ -62,12 +53,6 @@ private:
 
     // Cross-thread shared data.
     util::ptr<const Style> style;
-    GlyphAtlas& glyphAtlas;
-    GlyphStore& glyphStore;
-    SpriteAtlas& spriteAtlas;
-    util::ptr<Sprite> sprite;
-
-    std::unique_ptr<Collision> collision;
 };
 
 }
@@ -1,4 +1,6 @@
 #include <mbgl/map/vector_tile.hpp>
+#include <mbgl/style/filter_program.hpp>
+#include <mbgl/util/std.hpp>
 
 namespace mbgl {
 
@@ -35,7 +37,30 @@ VectorTileFeature::VectorTileFeature(pbf feature_pbf, const VectorTileLayer& lay
         if (feature_pbf.tag == 1) { // id
             id = feature_pbf.varint<uint64_t>();
         } else if (feature_pbf.tag == 2) { // tags
-            tags_pbf = feature_pbf.message();
+            // Resolve the tags once into the layer's tag arena so that
+            // repeated value lookups don't have to decode varints again.
+            pbf tags_pbf = feature_pbf.message();
+            tags_begin = layer.tags.size();
+            while (tags_pbf) {
+                uint32_t tag_key = tags_pbf.varint();
+
+                if (layer.keys.size() <= tag_key) {
+                    throw std::runtime_error("feature referenced out of range key");
+                }
+
+                if (!tags_pbf) {
+                    throw std::runtime_error("uneven number of feature tag ids");
+                }
+
+                uint32_t tag_val = tags_pbf.varint();
+                if (layer.values.size() <= tag_val) {
+                    throw std::runtime_error("feature referenced out of range value");
+                }
+
+                layer.tags.push_back(tag_key);
+                layer.tags.push_back(tag_val);
+            }
+            tags_end = layer.tags.size();
         } else if (feature_pbf.tag == 3) { // type
             type = (FeatureType)feature_pbf.varint();
         } else if (feature_pbf.tag == 4) { // geometry
@@ -52,42 +77,30 @@ mapbox::util::optional<Value> VectorTileFeature::getValue(const std::string& key
         return mapbox::util::optional<Value>();
     }
 
-    pbf tags = tags_pbf;
-    while (tags) {
-        uint32_t tag_key = tags.varint();
-
-        if (layer.keys.size() <= tag_key) {
-            throw std::runtime_error("feature referenced out of range key");
-        }
-
-        if (!tags) {
-            throw std::runtime_error("uneven number of feature tag ids");
-        }
-
-        uint32_t tag_val = tags.varint();
-        if (layer.values.size() <= tag_val) {
-            throw std::runtime_error("feature referenced out of range value");
-        }
-
-        if (tag_key == keyIter->second) {
-            return layer.values[tag_val];
+    for (std::size_t i = tags_begin; i < tags_end; i += 2) {
+        if (layer.tags[i] == keyIter->second) {
+            return layer.values[layer.tags[i + 1]];
         }
     }
 
     return mapbox::util::optional<Value>();
 }
 
-GeometryCollection VectorTileFeature::getGeometries() const {
+void VectorTileFeature::decodeGeometries() const {
     pbf data(geometry_pbf);
     uint8_t cmd = 1;
     uint32_t length = 0;
     int32_t x = 0;
     int32_t y = 0;
 
-    GeometryCollection lines;
+    auto& coordinates = layer.arena->coordinates;
+    auto& offsets = layer.arena->offsets;
 
-    lines.emplace_back();
-    std::vector<Coordinate>* line = &lines.back();
+    // Drop leftovers of a decode that failed halfway.
+    coordinates.discard();
+    offsets.discard();
+
+    offsets.push(0);
 
     while (data.data < data.end) {
         if (length == 0) {
@@ -102,16 +115,17 @@ GeometryCollection VectorTileFeature::getGeometries() const {
             x += data.svarint();
             y += data.svarint();
 
-            if (cmd == 1 && !line->empty()) { // moveTo
-                lines.emplace_back();
-                line = &lines.back();
+            if (cmd == 1 && coordinates.pending() > offsets[offsets.pending() - 1]) { // moveTo
+                offsets.push(coordinates.pending());
             }
 
-            line->emplace_back(x, y);
+            coordinates.push(Coordinate(x, y));
 
         } else if (cmd == 7) { // closePolygon
-            if (!line->empty()) {
-                line->push_back((*line)[0]);
+            const uint32_t start = offsets[offsets.pending() - 1];
+            if (coordinates.pending() > start) {
+                const Coordinate first = coordinates[start];
+                coordinates.push(first);
             }
 
         } else {
@@ -119,13 +133,26 @@ GeometryCollection VectorTileFeature::getGeometries() const {
         }
     }
 
-    return lines;
+    // The last offset marks the end of the last line.
+    offsets.push(coordinates.pending());
+
+    const std::size_t count = offsets.pending() - 1;
+    geometries = GeometryCollection(coordinates.commit(), offsets.commit(), count);
+    decoded = true;
 }
 
-VectorTile::VectorTile(pbf tile_pbf) {
+GeometryCollection VectorTileFeature::getGeometries() const {
+    if (!decoded) {
+        decodeGeometries();
+    }
+    return geometries;
+}
+
+VectorTile::VectorTile(pbf tile_pbf)
+    : arena(std::make_shared<VectorTileArena>()) {
     while (tile_pbf.next()) {
         if (tile_pbf.tag == 3) { // layer
-            util::ptr<VectorTileLayer> layer = std::make_shared<VectorTileLayer>(tile_pbf.message());
+            util::ptr<VectorTileLayer> layer = std::make_shared<VectorTileLayer>(tile_pbf.message(), arena);
             layers.emplace(layer->name, layer);
         } else {
             tile_pbf.skip();
@@ -141,7 +168,8 @@ util::ptr<GeometryTileLayer> VectorTile::getLayer(const std::string& name) const
     return nullptr;
 }
 
-VectorTileLayer::VectorTileLayer(pbf layer_pbf) {
+VectorTileLayer::VectorTileLayer(pbf layer_pbf, const util::ptr<VectorTileArena>& arena_)
+    : arena(arena_) {
     while (layer_pbf.next()) {
         if (layer_pbf.tag == 1) { // name
             name = layer_pbf.string();
@@ -160,7 +188,37 @@ VectorTileLayer::VectorTileLayer(pbf layer_pbf) {
 }
 
 util::ptr<const GeometryTileFeature> VectorTileLayer::getFeature(std::size_t i) const {
-    return std::make_shared<VectorTileFeature>(features.at(i), *this);
+    if (decodedFeatures.empty()) {
+        decodedFeatures.resize(features.size());
+    }
+
+    auto& feature = decodedFeatures.at(i);
+    if (!feature) {
+        feature = std::make_shared<VectorTileFeature>(features[i], *this);
+    }
+    return feature;
+}
+
+class VectorTileFilter : public GeometryTileFilter {
+public:
+    VectorTileFilter(const FilterExpression& expression, const VectorTileLayer& layer_)
+        : layer(layer_), program(expression, layer.keys, layer.values) {}
+
+    bool operator()(const GeometryTileFeature& feature_) const override {
+        const auto& feature = static_cast<const VectorTileFeature&>(feature_);
+        assert(&feature.layer == &layer);
+        return program.evaluate(feature.type,
+                                layer.tags.data() + feature.tags_begin,
+                                feature.tags_end - feature.tags_begin);
+    }
+
+private:
+    const VectorTileLayer& layer;
+    const FilterProgram program;
+};
+
+std::unique_ptr<GeometryTileFilter> VectorTileLayer::compileFilter(const FilterExpression& expression) const {
+    return util::make_unique<VectorTileFilter>(expression, *this);
 }
 
 }
@@ -2,6 +2,7 @@
 #define MBGL_MAP_VECTOR_TILE
 
 #include <mbgl/map/geometry_tile.hpp>
+#include <mbgl/util/arena.hpp>
 #include <mbgl/util/pbf.hpp>
 
 #include <unordered_map>
@@ -9,6 +10,14 @@
 namespace mbgl {
 
 class VectorTileLayer;
+class VectorTileFilter;
+
+// Backing storage for the decoded geometries of all features in a tile.
+class VectorTileArena {
+public:
+    util::Arena<Coordinate> coordinates;
+    util::Arena<uint32_t> offsets;
+};
 
 class VectorTileFeature : public GeometryTileFeature {
 public:
@@ -19,29 +28,53 @@ public:
     GeometryCollection getGeometries() const override;
 
 private:
+    friend class VectorTileFilter;
+
+    void decodeGeometries() const;
+
     const VectorTileLayer& layer;
     uint64_t id = 0;
     FeatureType type = FeatureType::Unknown;
-    pbf tags_pbf;
     pbf geometry_pbf;
+
+    // Range of resolved key/value index pairs in the layer's tag arena.
+    std::size_t tags_begin = 0;
+    std::size_t tags_end = 0;
+
+    // Points into the tile's geometry arena. The geometry is decoded lazily,
+    // at most once per feature.
+    mutable bool decoded = false;
+    mutable GeometryCollection geometries;
 };
 
 class VectorTileLayer : public GeometryTileLayer {
 public:
-    VectorTileLayer(pbf);
+    VectorTileLayer(pbf, const util::ptr<VectorTileArena>&);
 
     std::size_t featureCount() const override { return features.size(); }
     util::ptr<const GeometryTileFeature> getFeature(std::size_t) const override;
+    std::unique_ptr<GeometryTileFilter> compileFilter(const FilterExpression&) const override;
 
 private:
     friend class VectorTile;
     friend class VectorTileFeature;
+    friend class VectorTileFilter;
 
     std::string name;
     uint32_t extent = 4096;
     std::unordered_map<std::string, uint32_t> keys;
     std::vector<Value> values;
     std::vector<pbf> features;
+
+    // Features are decoded on first access and then shared by every bucket
+    // that reads this layer, so that parse time doesn't grow with the number
+    // of style layers referencing the same source layer.
+    mutable std::vector<util::ptr<const VectorTileFeature>> decodedFeatures;
+
+    // Resolved key/value index pairs of all features. Features refer to them by index.
+    mutable std::vector<uint32_t> tags;
+
+    util::ptr<VectorTileArena> arena;
 };
 
 class VectorTile : public GeometryTile {
@@ -52,6 +85,7 @@ public:
 
 private:
     std::unordered_map<std::string, util::ptr<GeometryTileLayer>> layers;
+    util::ptr<VectorTileArena> arena;
 };
 
 }
@@ -1,5 +1,7 @@
 #include <mbgl/map/vector_tile_data.hpp>
 #include <mbgl/map/tile_parser.hpp>
+#include <mbgl/renderer/symbol_bucket.hpp>
+#include <mbgl/text/collision.hpp>
 #include <mbgl/util/std.hpp>
 #include <mbgl/style/style_layer.hpp>
 #include <mbgl/style/style_bucket.hpp>
@@ -32,54 +34,140 @@ VectorTileData::~VectorTileData() {
 }
 
 void VectorTileData::parse() {
-    if (state != State::loaded) {
+    if (state != State::loaded && state != State::partial) {
         return;
     }
 
     try {
-        if (!style) {
-            throw std::runtime_error("style isn't present in VectorTileData object anymore");
-        }
+        if (state == State::loaded) {
+            if (!style) {
+                throw std::runtime_error("style isn't present in VectorTileData object anymore");
+            }
+
+            // Parsing creates state that is encapsulated in TileParser. While parsing,
+            // the TileParser object writes results into this objects. All other state
+            // is going to be discarded afterwards.
+            VectorTile vectorTile(pbf((const uint8_t *)data->data(), data->size()));
+            const VectorTile* vt = &vectorTile;
+            TileParser parser(*vt, *this, style);
 
-        // Parsing creates state that is encapsulated in TileParser. While parsing,
-        // the TileParser object writes results into this objects. All other state
-        // is going to be discarded afterwards.
-        VectorTile vectorTile(pbf((const uint8_t *)data.data(), data.size()));
-        const VectorTile* vt = &vectorTile;
-        TileParser parser(*vt, *this, style, glyphAtlas, glyphStore, spriteAtlas, sprite);
+            // Clear the style so that we don't have a cycle in the shared_ptr references.
+            style.reset();
 
-        // Clear the style so that we don't have a cycle in the shared_ptr references.
-        style.reset();
+            parser.parse();
+        }
 
-        parser.parse();
+        parseSymbols();
     } catch (const std::exception& ex) {
         Log::Error(Event::ParseTile, "Parsing [%d/%d/%d] failed: %s", id.z, id.x, id.y, ex.what());
         state = State::obsolete;
         return;
     }
+}
+
+void VectorTileData::parseSymbols() {
+    if (state == State::obsolete) {
+        return;
+    }
+
+    for (const auto bucket : pendingSymbolBuckets) {
+        if (!bucket->hasDependencies(glyphStore, *sprite)) {
+            // Don't hold up the worker. We're going to be resumed once the
+            // missing glyphs or sprites have arrived.
+            state = State::partial;
+            return;
+        }
+    }
+
+    // Symbols are placed in style order since they share the collision state.
+    for (const auto bucket : pendingSymbolBuckets) {
+        if (state == State::obsolete) {
+            return;
+        }
+        bucket->addFeatures(reinterpret_cast<uintptr_t>(this), spriteAtlas, *sprite, glyphAtlas, glyphStore);
+    }
+
+    pendingSymbolBuckets.clear();
+    collision.reset();
 
     if (state != State::obsolete) {
         state = State::parsed;
     }
 }
 
-void VectorTileData::render(Painter &painter, const StyleLayer &layer_desc, const mat4 &matrix) {
-    if (state == State::parsed && layer_desc.bucket) {
-        auto databucket_it = buckets.find(layer_desc.bucket->name);
-        if (databucket_it != buckets.end()) {
-            assert(databucket_it->second);
-            databucket_it->second->render(painter, layer_desc, id, matrix);
+bool VectorTileData::requestDependencies(std::function<void()> callback) {
+    bool ready = true;
+    for (const auto bucket : pendingSymbolBuckets) {
+        bucket->requestDependencies(glyphStore, callback);
+        ready = ready && bucket->hasDependencies(glyphStore, *sprite);
+    }
+    return ready;
+}
+
+std::size_t VectorTileData::getByteSize() const {
+    return TileData::getByteSize() +
+           fillVertexBuffer.bytes() +
+           lineVertexBuffer.bytes() +
+           iconVertexBuffer.bytes() +
+           textVertexBuffer.bytes() +
+           triangleElementsBuffer.bytes() +
+           lineElementsBuffer.bytes() +
+           pointElementsBuffer.bytes();
+}
+
+void VectorTileData::retainFillBuffers() {
+    fillVertexBuffer.retain();
+    triangleElementsBuffer.retain();
+}
+
+bool VectorTileData::uploadNext(std::size_t& bytes) {
+    const std::size_t before = bytes;
+    if ((bytes += fillVertexBuffer.upload()) > before ||
+        (bytes += lineVertexBuffer.upload()) > before ||
+        (bytes += iconVertexBuffer.upload()) > before ||
+        (bytes += textVertexBuffer.upload()) > before ||
+        (bytes += triangleElementsBuffer.upload()) > before ||
+        (bytes += lineElementsBuffer.upload()) > before ||
+        (bytes += pointElementsBuffer.upload()) > before) {
+        return needsUpload();
+    }
+
+    for (const auto& pair : buckets) {
+        if ((bytes += pair.second->upload()) > before) {
+            return needsUpload();
         }
     }
+
+    return false;
 }
 
-bool VectorTileData::hasData(const StyleLayer &layer_desc) const {
+bool VectorTileData::needsUpload() const {
+    if (fillVertexBuffer.pending() ||
+        lineVertexBuffer.pending() ||
+        iconVertexBuffer.pending() ||
+        textVertexBuffer.pending() ||
+        triangleElementsBuffer.pending() ||
+        lineElementsBuffer.pending() ||
+        pointElementsBuffer.pending()) {
+        return true;
+    }
+
+    for (const auto& pair : buckets) {
+        if (pair.second->needsUpload()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+Bucket* VectorTileData::getBucket(StyleLayer const& layer_desc) {
     if (state == State::parsed && layer_desc.bucket) {
         auto databucket_it = buckets.find(layer_desc.bucket->name);
         if (databucket_it != buckets.end()) {
             assert(databucket_it->second);
-            return databucket_it->second->hasData();
+            return databucket_it->second.get();
         }
     }
-    return false;
+    return nullptr;
 }
@@ -12,6 +12,7 @@
 #include <iosfwd>
 #include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace mbgl {
 
@@ -25,6 +26,8 @@ class GlyphStore;
 class SpriteAtlas;
 class Sprite;
 class Style;
+class SymbolBucket;
+class Collision;
 
 class VectorTileData : public TileData {
     friend class TileParser;
@@ -41,10 +44,24 @@ public:
     ~VectorTileData();
 
     void parse() override;
-    void render(Painter &painter, const StyleLayer &layer_desc, const mat4 &matrix) override;
-    bool hasData(StyleLayer const& layer_desc) const override;
+    Bucket* getBucket(StyleLayer const& layer_desc) override;
+    std::size_t getByteSize() const override;
+
+    // Keeps the fill vertices and triangles in memory after the upload, so that the painter can
+    // copy them into batches. Must be called before the tile is parsed.
+    void retainFillBuffers();
 
 protected:
+    bool requestDependencies(std::function<void ()> callback) override;
+    bool uploadNext(std::size_t& bytes) override;
+
+    // Whether any of the tile's buffers still have to go to the GPU.
+    bool needsUpload() const;
+
+    // Adds the features of all pending symbol buckets once their glyphs and
+    // sprites are available, and updates the state accordingly.
+    void parseSymbols();
+
     // Holds the actual geometries in this tile.
     FillVertexBuffer fillVertexBuffer;
     LineVertexBuffer lineVertexBuffer;
@@ -59,6 +76,11 @@ protected:
     // They contain the location offsets in the buffers stored above
     std::unordered_map<std::string, std::unique_ptr<Bucket>> buckets;
 
+    // Symbol buckets that still need to add their features, in style order.
+    // They share the collision state, and are owned by buckets.
+    std::vector<SymbolBucket*> pendingSymbolBuckets;
+    std::unique_ptr<Collision> collision;
+
     GlyphAtlas& glyphAtlas;
     GlyphStore& glyphStore;
     SpriteAtlas& spriteAtlas;
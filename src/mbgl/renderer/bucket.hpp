@@ -4,6 +4,7 @@
 #include <mbgl/map/tile.hpp>
 #include <mbgl/util/noncopyable.hpp>
 
+#include <cstddef>
 #include <string>
 
 namespace mbgl {
@@ -16,6 +17,14 @@ public:
     virtual void render(Painter &painter, const StyleLayer &layer_desc, const Tile::ID &id,
                         const mat4 &matrix) = 0;
     virtual bool hasData() const = 0;
+
+    // Uploads the buffers that belong to this bucket alone, and returns the number of bytes
+    // uploaded. Buffers shared by the buckets of a tile are uploaded by the tile.
+    virtual std::size_t upload() { return 0; }
+
+    // Whether upload() still has buffers to transfer.
+    virtual bool needsUpload() const { return false; }
+
     virtual ~Bucket() {}
 
 };
@@ -0,0 +1,89 @@
+#include <mbgl/renderer/fill_batch.hpp>
+#include <mbgl/renderer/fill_bucket.hpp>
+#include <mbgl/shader/plain_batch_shader.hpp>
+#include <mbgl/platform/gl.hpp>
+#include <mbgl/util/std.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+using namespace mbgl;
+
+bool FillBatch::update(const std::vector<const FillBucket*>& buckets) {
+    if (buckets.size() == serials.size() &&
+        std::equal(buckets.begin(), buckets.end(), serials.begin(),
+                   [](const FillBucket* bucket, uint64_t serial) { return bucket->serial == serial; })) {
+        return complete;
+    }
+
+    serials.clear();
+    groups.clear();
+    vertexBuffer = util::make_unique<FillBatchVertexBuffer>();
+    triangleElementsBuffer = util::make_unique<TriangleElementsBuffer>();
+
+    complete = true;
+    for (std::size_t i = 0; i < buckets.size(); i++) {
+        serials.push_back(buckets[i]->serial);
+        if (complete && !buckets[i]->addToBatch(*this, i)) {
+            // Remember the buckets anyway, so that the next frame doesn't try again.
+            complete = false;
+            groups.clear();
+            vertexBuffer.reset();
+            triangleElementsBuffer.reset();
+        }
+    }
+    return complete;
+}
+
+void FillBatch::add(std::size_t tile, const FillVertexBuffer::vertex_type* vertices,
+                    uint32_t vertexCount, const TriangleElementsBuffer::element_type* triangles,
+                    uint32_t triangleCount) {
+    const std::size_t chunk = tile / maxTiles;
+    if (groups.empty() || groups.back()->chunk != chunk ||
+        groups.back()->vertex_length + vertexCount > 65535) {
+        // Move to a new group because the old one can't hold the geometry, or uses other
+        // matrices.
+        groups.emplace_back(util::make_unique<Group>(chunk));
+    }
+
+    Group& group = *groups.back();
+    const uint32_t offset = group.vertex_length;
+    const auto index = static_cast<FillBatchVertexBuffer::vertex_type>(tile % maxTiles);
+
+    vertexBuffer->reserve(vertexCount);
+    for (uint32_t i = 0; i < vertexCount; i++) {
+        vertexBuffer->add(vertices[i * 2], vertices[i * 2 + 1], index);
+    }
+
+    triangleElementsBuffer->reserve(triangleCount);
+    for (uint32_t i = 0; i < triangleCount; i++) {
+        triangleElementsBuffer->add(offset + triangles[i * 3],
+                                    offset + triangles[i * 3 + 1],
+                                    offset + triangles[i * 3 + 2]);
+    }
+
+    group.vertex_length += vertexCount;
+    group.elements_length += triangleCount;
+}
+
+void FillBatch::draw(PlainBatchShader& shader, const std::vector<mat4>& matrices) {
+    assert(complete);
+    assert(matrices.size() == serials.size());
+
+    char *vertex_index = BUFFER_OFFSET(0);
+    char *elements_index = BUFFER_OFFSET(0);
+    std::size_t chunk = std::numeric_limits<std::size_t>::max();
+    for (auto& group : groups) {
+        assert(group);
+        if (group->chunk != chunk) {
+            chunk = group->chunk;
+            const std::size_t first = chunk * maxTiles;
+            shader.u_matrices.set(&matrices[first], std::min(maxTiles, matrices.size() - first));
+        }
+        group->array[0].bind(shader, *vertexBuffer, *triangleElementsBuffer, vertex_index);
+        MBGL_CHECK_ERROR(glDrawElements(GL_TRIANGLES, group->elements_length * 3, GL_UNSIGNED_SHORT, elements_index));
+        vertex_index += group->vertex_length * vertexBuffer->itemSize;
+        elements_index += group->elements_length * triangleElementsBuffer->itemSize;
+    }
+}
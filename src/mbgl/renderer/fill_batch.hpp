@@ -0,0 +1,74 @@
+#ifndef MBGL_RENDERER_FILL_BATCH
+#define MBGL_RENDERER_FILL_BATCH
+
+#include <mbgl/geometry/elements_buffer.hpp>
+#include <mbgl/geometry/fill_buffer.hpp>
+#include <mbgl/util/mat4.hpp>
+#include <mbgl/util/noncopyable.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace mbgl {
+
+class FillBucket;
+class PlainBatchShader;
+
+// Holds the fill triangles of one layer from many tiles in a single vertex and element buffer,
+// so that the layer is drawn with one call per group of 65535 vertices instead of one per tile.
+// Each vertex carries the index of its tile, which selects the tile's matrix in the shader.
+class FillBatch : private util::noncopyable {
+public:
+    // The number of matrices the shader holds. GLES2 guarantees 128 uniform vectors in vertex
+    // shaders, and each matrix takes four. Larger batches set the matrices for every chunk of
+    // this many tiles.
+    static const std::size_t maxTiles = 16;
+
+    // Copies the triangles of the buckets, unless the batch already holds these buckets in this
+    // order. Returns false if a bucket doesn't retain its buffers, so that it can't be batched.
+    bool update(const std::vector<const FillBucket*>& buckets);
+
+    // Adds a group of triangles of the tile with the given index. The elements index into the
+    // vertices passed along.
+    void add(std::size_t tile, const FillVertexBuffer::vertex_type* vertices, uint32_t vertexCount,
+             const TriangleElementsBuffer::element_type* triangles, uint32_t triangleCount);
+
+    // Draws the triangles with the matrices of the tiles, in the order of the buckets passed
+    // to update(). The shader must be in use.
+    void draw(PlainBatchShader& shader, const std::vector<mat4>& matrices);
+
+    // Returns the number of draw calls the batch takes.
+    std::size_t groupCount() const {
+        return groups.size();
+    }
+
+    std::size_t vertexCount() const {
+        return vertexBuffer ? vertexBuffer->index() : 0;
+    }
+
+    std::size_t triangleCount() const {
+        return triangleElementsBuffer ? triangleElementsBuffer->index() : 0;
+    }
+
+private:
+    struct Group : public ElementGroup<1> {
+        explicit Group(std::size_t chunk_) : chunk(chunk_) {}
+
+        // The chunk of tiles whose matrices the group uses.
+        const std::size_t chunk;
+    };
+
+    // Identifies the buckets of the last update().
+    std::vector<uint64_t> serials;
+    bool complete = false;
+
+    // The buffers are replaced on every update, since they can't grow once they're uploaded.
+    std::unique_ptr<FillBatchVertexBuffer> vertexBuffer;
+    std::unique_ptr<TriangleElementsBuffer> triangleElementsBuffer;
+    std::vector<std::unique_ptr<Group>> groups;
+};
+
+}
+
+#endif
@@ -1,91 +1,385 @@
 #include <mbgl/renderer/fill_bucket.hpp>
+#include <mbgl/renderer/fill_batch.hpp>
 #include <mbgl/geometry/fill_buffer.hpp>
 #include <mbgl/geometry/elements_buffer.hpp>
 #include <mbgl/renderer/painter.hpp>
 #include <mbgl/style/style.hpp>
 #include <mbgl/style/style_layout.hpp>
+#include <mbgl/util/earcut.hpp>
+#include <mbgl/util/noncopyable.hpp>
 #include <mbgl/util/std.hpp>
 #include <mbgl/platform/gl.hpp>
 #include <mbgl/platform/log.hpp>
 
+#include <clipper/clipper.hpp>
+#include <libtess2/tesselator.h>
+
+#include <pthread.h>
+
+#include <array>
+#include <atomic>
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
 
 struct geometry_too_long_exception : std::exception {};
 
 using namespace mbgl;
 
+namespace {
+
+const int vertexSize = 2;
+const int stride = sizeof(TESSreal) * vertexSize;
+const int vertices_per_group = 3;
+
+// libtess2 sets up a mesh with fresh bucket pools for every tessellation and frees it again
+// afterwards. Freed blocks are kept on free lists by power-of-two size, and the next tessellation
+// takes them from there.
+class BlockPool : private util::noncopyable {
+public:
+    ~BlockPool() {
+        for (auto& list : lists) {
+            for (char *block : list) {
+                ::free(block);
+            }
+        }
+    }
+
+    static void *alloc(void *userData, unsigned int size) {
+        return reinterpret_cast<BlockPool *>(userData)->allocate(size);
+    }
+
+    static void *realloc(void *userData, void *ptr, unsigned int size) {
+        return reinterpret_cast<BlockPool *>(userData)->reallocate(ptr, size);
+    }
+
+    static void free(void *userData, void *ptr) {
+        reinterpret_cast<BlockPool *>(userData)->release(ptr);
+    }
+
+private:
+    // Blocks start with their size class, padded so that the memory we hand out stays aligned.
+    static const size_t headerSize = 16;
+    static const size_t minSizeClass = 4;
+
+    static size_t &sizeClassOf(char *block) {
+        return *reinterpret_cast<size_t *>(block);
+    }
+
+    void *allocate(size_t size) {
+        size_t sizeClass = minSizeClass;
+        while ((size_t(1) << sizeClass) < size) {
+            sizeClass++;
+        }
+
+        auto& list = lists[sizeClass];
+        char *block;
+        if (!list.empty()) {
+            block = list.back();
+            list.pop_back();
+        } else {
+            block = reinterpret_cast<char *>(::malloc(headerSize + (size_t(1) << sizeClass)));
+            if (!block) {
+                return nullptr;
+            }
+            sizeClassOf(block) = sizeClass;
+        }
+        return block + headerSize;
+    }
+
+    void *reallocate(void *ptr, size_t size) {
+        if (!ptr) {
+            return allocate(size);
+        }
+        const size_t capacity = size_t(1) << sizeClassOf(reinterpret_cast<char *>(ptr) - headerSize);
+        if (size <= capacity) {
+            return ptr;
+        }
+        void *result = allocate(size);
+        if (result) {
+            std::memcpy(result, ptr, capacity);
+            release(ptr);
+        }
+        return result;
+    }
 
+    void release(void *ptr) {
+        if (ptr) {
+            char *block = reinterpret_cast<char *>(ptr) - headerSize;
+            lists[sizeClassOf(block)].push_back(block);
+        }
+    }
+
+    std::array<std::vector<char *>, 8 * sizeof(unsigned int) + 1> lists;
+};
+
+// Triangulation state of a worker thread. Buckets reset it between uses, and it keeps its memory,
+// so building fill buckets stops allocating here once the thread has warmed up. It's deleted when
+// the thread exits.
+class Tessellator : private util::noncopyable {
+public:
+    static Tessellator &Get() {
+        static pthread_once_t store_once = PTHREAD_ONCE_INIT;
+        static pthread_key_t store_key;
+
+        // Create the key.
+        pthread_once(&store_once, []() {
+            pthread_key_create(&store_key, [](void *ptr) {
+                delete reinterpret_cast<Tessellator *>(ptr);
+            });
+        });
+
+        Tessellator *ptr = reinterpret_cast<Tessellator *>(pthread_getspecific(store_key));
+        if (ptr == nullptr) {
+            ptr = new Tessellator();
+            pthread_setspecific(store_key, ptr);
+        }
+
+        return *ptr;
+    }
+
+    Tessellator()
+        : allocator{
+              &BlockPool::alloc,
+              &BlockPool::realloc,
+              &BlockPool::free,
+              &pool,   // userData
+              64,      // meshEdgeBucketSize
+              64,      // meshVertexBucketSize
+              32,      // meshFaceBucketSize
+              64,      // dictNodeBucketSize
+              8,       // regionBucketSize
+              128,     // extraVertices allocated for the priority queue.
+          },
+          tesselator(tessNewTess(&allocator)) {
+        assert(tesselator);
+    }
+
+    ~Tessellator() {
+        if (tesselator) {
+            tessDeleteTess(tesselator);
+        }
+    }
+
+private:
+    // The pool has to outlive the tesselator.
+    BlockPool pool;
+    TESSalloc allocator;
+
+public:
+    TESStesselator *tesselator;
+    ClipperLib::Clipper clipper;
+    util::Earcut earcut;
+
+    // Scratch space.
+    std::vector<GeometryLine> rings;
+    std::vector<uint32_t> triangles;
+    std::vector<ClipperLib::IntPoint> line;
+    std::vector<std::vector<ClipperLib::IntPoint>> polygons;
+    std::vector<TESSreal> contour;
+};
 
-void *FillBucket::alloc(void *, unsigned int size) {
-    return ::malloc(size);
 }
 
-void *FillBucket::realloc(void *, void *ptr, unsigned int size) {
-    return ::realloc(ptr, size);
+namespace {
+
+std::atomic<uint64_t> nextSerial(0);
+
+// Whether the ring spans at least three different points. Rings with less can't cover anything.
+bool hasThreeDistinctPoints(const GeometryLine& ring) {
+    const Coordinate& first = ring.front();
+    const Coordinate *second = nullptr;
+    for (const auto& point : ring) {
+        if (point == first || (second && point == *second)) {
+            continue;
+        }
+        if (second) {
+            return true;
+        }
+        second = &point;
+    }
+    return false;
 }
 
-void FillBucket::free(void *, void *ptr) {
-    ::free(ptr);
 }
 
 FillBucket::FillBucket(FillVertexBuffer &vertexBuffer_,
                        TriangleElementsBuffer &triangleElementsBuffer_,
                        LineElementsBuffer &lineElementsBuffer_)
-    : allocator(new TESSalloc{
-          &alloc,
-          &realloc,
-          &free,
-          nullptr, // userData
-          64,      // meshEdgeBucketSize
-          64,      // meshVertexBucketSize
-          32,      // meshFaceBucketSize
-          64,      // dictNodeBucketSize
-          8,       // regionBucketSize
-          128,     // extraVertices allocated for the priority queue.
-      }),
-      tesselator(tessNewTess(allocator)),
+    : serial(nextSerial++),
       vertexBuffer(vertexBuffer_),
       triangleElementsBuffer(triangleElementsBuffer_),
       lineElementsBuffer(lineElementsBuffer_),
       vertex_start(vertexBuffer_.index()),
       triangle_elements_start(triangleElementsBuffer_.index()),
       line_elements_start(lineElementsBuffer.index()) {
-    assert(tesselator);
 }
 
 FillBucket::~FillBucket() {
-    if (tesselator) {
-        tessDeleteTess(tesselator);
-    }
-    if (allocator) {
-        delete allocator;
-    }
+}
+
+void FillBucket::reserve(size_t vertexCount) {
+    // Outlines have one segment per vertex, and there are about as many triangles as vertices.
+    // Earcut shares the outline vertices, but the tessellator adds its own set, plus one for each
+    // intersection the clipper finds. The earcut path sends self-intersecting polygons there too,
+    // so it gets some headroom. Either way the buffers still grow if the estimate falls short.
+    const size_t extra = layout.triangulation == TriangulationType::Tessellator
+        ? vertexCount + vertexCount / 8
+        : vertexCount / 8;
+    vertexBuffer.reserve(vertexCount + extra);
+    triangleElementsBuffer.reserve(vertexCount + vertexCount / 8);
+    lineElementsBuffer.reserve(vertexCount);
 }
 
 void FillBucket::addGeometry(const GeometryCollection& geometryCollection) {
-    for (auto& line_ : geometryCollection) {
-        for (auto& v : line_) {
-            line.emplace_back(v.x, v.y);
+    if (layout.triangulation == TriangulationType::Tessellator) {
+        for (const auto& ring : geometryCollection) {
+            addToTessellator(ring);
+        }
+        tessellate();
+        return;
+    }
+
+    // Rings with the winding order of the first ring start a new polygon. The others are holes
+    // of the polygon before them.
+    Tessellator& tess = Tessellator::Get();
+    std::vector<GeometryLine>& rings = tess.rings;
+    rings.clear();
+    bool outerClockwise = false;
+    bool tessellateRest = false;
+    for (const auto& line_ : geometryCollection) {
+        if (tessellateRest) {
+            addToTessellator(line_);
+            continue;
+        }
+
+        // Rings are closed by repeating the first point, which earcut doesn't want.
+        const GeometryLine ring = line_.size() > 1 && line_.front() == line_.back()
+            ? GeometryLine(line_.begin(), line_.end() - 1)
+            : line_;
+        if (ring.size() < 3) {
+            continue;
         }
-        if (line.size()) {
-            clipper.AddPath(line, ClipperLib::ptSubject, true);
-            line.clear();
-            hasVertices = true;
+        const int64_t area = util::Earcut::signedArea(ring);
+        if (area == 0) {
+            if (!hasThreeDistinctPoints(ring)) {
+                continue;
+            }
+
+            // A self-intersecting ring whose lobes cancel out, like a bow tie. Its winding doesn't
+            // tell whether it starts a polygon or is a hole, so it goes to the tessellator along
+            // with the polygon so far and the remaining rings. The fill rule sorts them out.
+            for (const auto& previous : rings) {
+                addToTessellator(previous);
+            }
+            rings.clear();
+            addToTessellator(ring);
+            tessellateRest = true;
+            continue;
+        }
+        if (rings.empty()) {
+            outerClockwise = area > 0;
+        } else if ((area > 0) == outerClockwise) {
+            addPolygon(rings);
+            rings.clear();
         }
+        rings.push_back(ring);
     }
+    addPolygon(rings);
 
+    // Polygons that earcut couldn't handle are waiting in the clipper.
     tessellate();
 }
 
+void FillBucket::addPolygon(const std::vector<GeometryLine>& rings) {
+    size_t total_vertex_count = 0;
+    for (const auto& ring : rings) {
+        total_vertex_count += ring.size();
+    }
+
+    if (total_vertex_count == 0) {
+        return;
+    }
+
+    Tessellator& tess = Tessellator::Get();
+    std::vector<uint32_t>& triangles = tess.triangles;
+    if (total_vertex_count > 65535 || !tess.earcut(rings, triangles)) {
+        // Self-intersecting polygons need to be unioned before they can be triangulated, and
+        // polygons that don't fit into a group need to be rejected the same way.
+        for (const auto& ring : rings) {
+            addToTessellator(ring);
+        }
+        return;
+    }
+
+    if (!lineGroups.size() || (lineGroups.back()->vertex_length + total_vertex_count > 65535)) {
+        // Move to a new group because the old one can't hold the geometry.
+        lineGroups.emplace_back(util::make_unique<line_group_type>());
+    }
+
+    assert(lineGroups.back());
+    line_group_type& lineGroup = *lineGroups.back();
+    uint32_t lineIndex = lineGroup.vertex_length;
+
+    // Outlines and triangles share the vertices; earcut doesn't add any.
+    for (const auto& ring : rings) {
+        const size_t group_count = ring.size();
+        for (const auto& pt : ring) {
+            vertexBuffer.add(pt.x, pt.y);
+        }
+        for (size_t i = 0; i < group_count; i++) {
+            const size_t prev_i = (i == 0 ? group_count : i) - 1;
+            lineElementsBuffer.add(lineIndex + prev_i, lineIndex + i);
+        }
+        lineIndex += group_count;
+    }
+
+    lineGroup.vertex_length += total_vertex_count;
+    lineGroup.elements_length += total_vertex_count;
+
+    if (!triangleGroups.size() || (triangleGroups.back()->vertex_length + total_vertex_count > 65535)) {
+        // Move to a new group because the old one can't hold the geometry.
+        triangleGroups.emplace_back(util::make_unique<triangle_group_type>());
+    }
+
+    assert(triangleGroups.back());
+    triangle_group_type& triangleGroup = *triangleGroups.back();
+    const uint32_t triangleIndex = triangleGroup.vertex_length;
+
+    for (size_t i = 0; i < triangles.size(); i += 3) {
+        triangleElementsBuffer.add(triangleIndex + triangles[i],
+                                   triangleIndex + triangles[i + 1],
+                                   triangleIndex + triangles[i + 2]);
+    }
+
+    triangleGroup.vertex_length += total_vertex_count;
+    triangleGroup.elements_length += triangles.size() / 3;
+}
+
+void FillBucket::addToTessellator(const GeometryLine& ring) {
+    Tessellator& tess = Tessellator::Get();
+    std::vector<ClipperLib::IntPoint>& line = tess.line;
+    line.clear();
+    for (const auto& v : ring) {
+        line.emplace_back(v.x, v.y);
+    }
+    if (line.size()) {
+        tess.clipper.AddPath(line, ClipperLib::ptSubject, true);
+        hasVertices = true;
+    }
+}
+
 void FillBucket::tessellate() {
     if (!hasVertices) {
         return;
     }
     hasVertices = false;
 
-    std::vector<std::vector<ClipperLib::IntPoint>> polygons;
-    clipper.Execute(ClipperLib::ctUnion, polygons, ClipperLib::pftPositive);
-    clipper.Clear();
+    Tessellator& tess = Tessellator::Get();
+    TESStesselator *tesselator = tess.tesselator;
+    std::vector<std::vector<ClipperLib::IntPoint>>& polygons = tess.polygons;
+    tess.clipper.Execute(ClipperLib::ctUnion, polygons, ClipperLib::pftPositive);
+    tess.clipper.Clear();
 
     if (polygons.size() == 0) {
         return;
@@ -113,7 +407,8 @@ void FillBucket::tessellate() {
         const size_t group_count = polygon.size();
         assert(group_count >= 3);
 
-        std::vector<TESSreal> clipped_line;
+        std::vector<TESSreal>& clipped_line = tess.contour;
+        clipped_line.clear();
         for (const auto& pt : polygon) {
             clipped_line.push_back(pt.X);
             clipped_line.push_back(pt.Y);
@@ -228,6 +523,28 @@ void FillBucket::drawElements(PatternShader& shader) {
     }
 }
 
+bool FillBucket::addToBatch(FillBatch& batch, std::size_t tile) const {
+    if (triangleGroups.empty()) {
+        return true;
+    }
+
+    auto vertices = static_cast<const FillVertexBuffer::vertex_type *>(vertexBuffer.data());
+    auto triangles = static_cast<const TriangleElementsBuffer::element_type *>(triangleElementsBuffer.data());
+    if (!vertices || !triangles) {
+        return false;
+    }
+
+    vertices += vertex_start * 2;
+    triangles += triangle_elements_start * 3;
+    for (const auto& group : triangleGroups) {
+        assert(group);
+        batch.add(tile, vertices, group->vertex_length, triangles, group->elements_length);
+        vertices += group->vertex_length * 2;
+        triangles += group->elements_length * 3;
+    }
+    return true;
+}
+
 void FillBucket::drawVertices(OutlineShader& shader) {
     char *vertex_index = BUFFER_OFFSET(vertex_start * vertexBuffer.itemSize);
     char *elements_index = BUFFER_OFFSET(line_elements_start * lineElementsBuffer.itemSize);
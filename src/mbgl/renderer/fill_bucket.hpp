@@ -8,9 +8,7 @@
 #include <mbgl/style/style_bucket.hpp>
 #include <mbgl/style/style_layout.hpp>
 
-#include <clipper/clipper.hpp>
-#include <libtess2/tesselator.h>
-
+#include <cstdint>
 #include <vector>
 #include <memory>
 
@@ -26,16 +24,12 @@ class FillVertexBuffer;
 class TriangleElementsBuffer;
 class LineElementsBuffer;
 class BucketDescription;
+class FillBatch;
 class OutlineShader;
 class PlainShader;
 class PatternShader;
 
 class FillBucket : public Bucket {
-
-    static void *alloc(void *data, unsigned int size);
-    static void *realloc(void *data, void *ptr, unsigned int size);
-    static void free(void *userData, void *ptr);
-
     typedef ElementGroup<2> triangle_group_type;
     typedef ElementGroup<1> line_group_type;
 
@@ -49,6 +43,9 @@ public:
                 const mat4 &matrix) override;
     bool hasData() const override;
 
+    // Sizes the buffers for polygons with the given number of vertices. Call it after setting the
+    // layout's triangulation.
+    void reserve(size_t vertexCount);
     void addGeometry(const GeometryCollection&);
     void tessellate();
 
@@ -56,13 +53,19 @@ public:
     void drawElements(PatternShader& shader);
     void drawVertices(OutlineShader& shader);
 
+    // Adds the triangles to the batch, with the matrix of the given tile. Returns false if the
+    // buffers were uploaded without retaining their contents.
+    bool addToBatch(FillBatch& batch, std::size_t tile) const;
+
 public:
     StyleLayoutFill layout;
 
+    // Unique among all fill buckets, so that batches can tell whether they hold this bucket.
+    const uint64_t serial;
+
 private:
-    TESSalloc *allocator;
-    TESStesselator *tesselator;
-    ClipperLib::Clipper clipper;
+    void addPolygon(const std::vector<GeometryLine>& rings);
+    void addToTessellator(const GeometryLine& ring);
 
     FillVertexBuffer& vertexBuffer;
     TriangleElementsBuffer& triangleElementsBuffer;
@@ -77,12 +80,8 @@ private:
     std::vector<std::unique_ptr<triangle_group_type>> triangleGroups;
     std::vector<std::unique_ptr<line_group_type>> lineGroups;
 
-    std::vector<ClipperLib::IntPoint> line;
+    // Whether the clipper of this thread holds rings for the tessellator.
     bool hasVertices = false;
-
-    static const int vertexSize = 2;
-    static const int stride = sizeof(TESSreal) * vertexSize;
-    static const int vertices_per_group = 3;
 };
 
 }
@@ -36,13 +36,20 @@ struct TriangleElement {
 
 typedef uint16_t PointElement;
 
+void LineBucket::reserve(size_t vertexCount) {
+    // Every vertex is extruded to both sides, which makes two triangles per segment. Joins add
+    // more, and the buffers grow for those.
+    vertexBuffer.reserve(vertexCount * 2);
+    triangleElementsBuffer.reserve(vertexCount * 2);
+}
+
 void LineBucket::addGeometry(const GeometryCollection& geometryCollection) {
-    for (auto& line : geometryCollection) {
+    for (const auto& line : geometryCollection) {
         addGeometry(line);
     }
 }
 
-void LineBucket::addGeometry(const std::vector<Coordinate>& vertices) {
+void LineBucket::addGeometry(const GeometryLine& vertices) {
     // TODO: use roundLimit
     // const float roundLimit = geometry.round_limit;
 
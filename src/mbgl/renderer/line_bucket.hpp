@@ -36,8 +36,10 @@ public:
                 const mat4 &matrix) override;
     bool hasData() const override;
 
+    // Sizes the buffers for lines with the given number of vertices.
+    void reserve(size_t vertexCount);
     void addGeometry(const GeometryCollection&);
-    void addGeometry(const std::vector<Coordinate>& line);
+    void addGeometry(const GeometryLine& line);
 
     bool hasPoints() const;
 
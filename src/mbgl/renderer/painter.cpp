@@ -11,6 +11,9 @@
 #include <mbgl/util/mat3.hpp>
 #include <mbgl/geometry/sprite_atlas.hpp>
 #include <mbgl/map/source.hpp>
+#include <mbgl/renderer/bucket.hpp>
+#include <mbgl/renderer/fill_batch.hpp>
+#include <mbgl/renderer/fill_bucket.hpp>
 
 #if defined(DEBUG)
 #include <mbgl/util/stopwatch.hpp>
@@ -94,6 +97,7 @@ void Painter::setup() {
 
 void Painter::setupShaders() {
     if (!plainShader) plainShader = util::make_unique<PlainShader>();
+    if (!plainBatchShader) plainBatchShader = util::make_unique<PlainBatchShader>();
     if (!outlineShader) outlineShader = util::make_unique<OutlineShader>();
     if (!lineShader) lineShader = util::make_unique<LineShader>();
     if (!linejoinShader) linejoinShader = util::make_unique<LinejoinShader>();
@@ -110,6 +114,7 @@ void Painter::setupShaders() {
 
 void Painter::deleteShaders() {
     plainShader = nullptr;
+    plainBatchShader = nullptr;
     outlineShader = nullptr;
     lineShader = nullptr;
     linejoinShader = nullptr;
@@ -139,6 +144,10 @@ void Painter::setDebug(bool enabled) {
     debug = enabled;
 }
 
+void Painter::setFillBatching(bool enabled) {
+    fillBatching = enabled;
+}
+
 void Painter::useProgram(uint32_t program) {
     if (gl_program != program) {
         MBGL_CHECK_ERROR(glUseProgram(program));
@@ -362,13 +371,55 @@ void Painter::renderLayer(const StyleLayer &layer_desc, const Tile::ID* id, cons
     }
 }
 
-void Painter::renderTileLayer(const Tile& tile, const StyleLayer &layer_desc, const mat4 &matrix) {
-    assert(tile.data);
-    if (tile.data->hasData(layer_desc) || layer_desc.type == StyleLayerType::Raster) {
-        gl::group group(std::string { "render " } + tile.data->name);
-        prepareTile(tile);
-        tile.data->render(*this, layer_desc, matrix);
+bool Painter::canBatch(const std::vector<std::pair<const Tile*, Bucket*>>& tiles,
+                       const StyleLayer &layer_desc) const {
+    if (!fillBatching || pass != RenderPass::Opaque || layer_desc.type != StyleLayerType::Fill ||
+        tiles.size() < 2) {
+        return false;
     }
+
+    const FillProperties &properties = layer_desc.getProperties<FillProperties>();
+    if (properties.image.from.size() || properties.translate[0] != 0 ||
+        properties.translate[1] != 0 || properties.fill_color[3] * properties.opacity < 1.0f) {
+        return false;
+    }
+
+    const int8_t z = tiles.front().first->id.z;
+    return std::all_of(tiles.begin(), tiles.end(), [z](const std::pair<const Tile*, Bucket*>& pair) {
+        return pair.first->id.z == z;
+    });
+}
+
+void Painter::renderTileLayers(const std::vector<std::pair<const Tile*, Bucket*>>& tiles,
+                               const StyleLayer &layer_desc, FillBatch* batch) {
+#if defined(DEBUG)
+    gl::group group(std::string { "layer: " } + layer_desc.id);
+#endif
+    if (batch) {
+        assert(canBatch(tiles, layer_desc));
+        batchBuckets.clear();
+        batchMatrices.clear();
+        for (const auto& pair : tiles) {
+            batchBuckets.push_back(static_cast<const FillBucket*>(pair.second));
+            batchMatrices.push_back(pair.first->matrix);
+        }
+        if (batch->update(batchBuckets)) {
+            renderFill(*batch, layer_desc, batchMatrices);
+            return;
+        }
+    }
+
+    for (const auto& pair : tiles) {
+        renderTileLayer(*pair.first, *pair.second, layer_desc, pair.first->matrix);
+    }
+}
+
+void Painter::renderTileLayer(const Tile& tile, Bucket& bucket, const StyleLayer &layer_desc, const mat4 &matrix) {
+#if defined(DEBUG)
+    gl::group group(std::string { "render " } + tile.data->name);
+#endif
+    prepareTile(tile);
+    bucket.render(*this, layer_desc, tile.id, matrix);
 }
 
 void Painter::renderBackground(const StyleLayer &layer_desc) {
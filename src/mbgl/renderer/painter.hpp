@@ -10,6 +10,7 @@
 #include <mbgl/style/types.hpp>
 
 #include <mbgl/shader/plain_shader.hpp>
+#include <mbgl/shader/plain_batch_shader.hpp>
 #include <mbgl/shader/outline_shader.hpp>
 #include <mbgl/shader/pattern_shader.hpp>
 #include <mbgl/shader/line_shader.hpp>
@@ -29,6 +30,8 @@
 #include <unordered_map>
 #include <set>
 #include <chrono>
+#include <utility>
+#include <vector>
 
 namespace mbgl {
 
@@ -45,6 +48,8 @@ class Source;
 class StyleSource;
 class StyleLayerGroup;
 
+class Bucket;
+class FillBatch;
 class FillBucket;
 class LineBucket;
 class SymbolBucket;
@@ -84,8 +89,20 @@ public:
     void renderLayers(const StyleLayerGroup &group);
     void renderLayer(const StyleLayer &layer_desc, const Tile::ID* id = nullptr, const mat4* matrix = nullptr);
 
+    // Returns whether the layer can be drawn from a batch of the tiles in the current pass. This
+    // requires fill batching, an opaque fill without a pattern or translation, and tiles of the
+    // same zoom level, which don't overlap, so the shader can clip them instead of the stencil.
+    bool canBatch(const std::vector<std::pair<const Tile*, Bucket*>>& tiles,
+                  const StyleLayer &layer_desc) const;
+
+    // Renders a layer from the tiles that have data for it. Sources collect the tiles first,
+    // so that layers without data in any tile cost nothing. Layers for which canBatch() holds
+    // are drawn from the batch if it is given and all buckets retain their data.
+    void renderTileLayers(const std::vector<std::pair<const Tile*, Bucket*>>& tiles,
+                          const StyleLayer &layer_desc, FillBatch* batch = nullptr);
+
     // Renders a particular layer from a tile.
-    void renderTileLayer(const Tile& tile, const StyleLayer &layer_desc, const mat4 &matrix);
+    void renderTileLayer(const Tile& tile, Bucket& bucket, const StyleLayer &layer_desc, const mat4 &matrix);
 
     // Renders debug information for a tile.
     void renderTileDebug(const Tile& tile);
@@ -96,6 +113,7 @@ public:
     void renderDebugText(DebugBucket& bucket, const mat4 &matrix);
     void renderDebugText(const std::vector<std::string> &strings);
     void renderFill(FillBucket& bucket, const StyleLayer &layer_desc, const Tile::ID& id, const mat4 &matrix);
+    void renderFill(FillBatch& batch, const StyleLayer &layer_desc, const std::vector<mat4> &matrices);
     void renderLine(LineBucket& bucket, const StyleLayer &layer_desc, const Tile::ID& id, const mat4 &matrix);
     void renderSymbol(SymbolBucket& bucket, const StyleLayer &layer_desc, const Tile::ID& id, const mat4 &matrix);
     void renderRaster(RasterBucket& bucket, const StyleLayer &layer_desc, const Tile::ID& id, const mat4 &matrix);
@@ -116,6 +134,9 @@ public:
     // Changes whether debug information is drawn onto the map
     void setDebug(bool enabled);
 
+    // Changes whether sources may draw fill layers from batches
+    void setFillBatching(bool enabled);
+
     // Opaque/Translucent pass setting
     void setOpaque();
     void setTranslucent();
@@ -181,8 +202,13 @@ private:
     TransformState state;
 
     bool debug = false;
+    bool fillBatching = false;
     int indent = 0;
 
+    // The buckets and matrices of the batched layer that is being rendered.
+    std::vector<const FillBucket*> batchBuckets;
+    std::vector<mat4> batchMatrices;
+
     uint32_t gl_program = 0;
     float gl_lineWidth = 0;
     bool gl_depthMask = true;
@@ -200,6 +226,7 @@ public:
     LineAtlas& lineAtlas;
 
     std::unique_ptr<PlainShader> plainShader;
+    std::unique_ptr<PlainBatchShader> plainBatchShader;
     std::unique_ptr<OutlineShader> outlineShader;
     std::unique_ptr<LineShader> lineShader;
     std::unique_ptr<LinejoinShader> linejoinShader;
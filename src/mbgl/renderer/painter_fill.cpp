@@ -1,5 +1,6 @@
 #include <mbgl/renderer/painter.hpp>
 #include <mbgl/renderer/fill_bucket.hpp>
+#include <mbgl/renderer/fill_batch.hpp>
 #include <mbgl/style/style.hpp>
 #include <mbgl/style/style_layer.hpp>
 #include <mbgl/style/style_layout.hpp>
@@ -134,3 +135,24 @@ void Painter::renderFill(FillBucket& bucket, const StyleLayer &layer_desc, const
         bucket.drawVertices(*outlineShader);
     }
 }
+
+void Painter::renderFill(FillBatch& batch, const StyleLayer &layer_desc, const std::vector<mat4> &matrices) {
+    const FillProperties &properties = layer_desc.getProperties<FillProperties>();
+
+    Color fill_color = properties.fill_color;
+    fill_color[0] *= properties.opacity;
+    fill_color[1] *= properties.opacity;
+    fill_color[2] *= properties.opacity;
+    fill_color[3] *= properties.opacity;
+
+    useProgram(plainBatchShader->program);
+    plainBatchShader->u_color = fill_color;
+
+    // The shader clips the triangles to their tiles instead of the stencil mask, which can't
+    // differ between the tiles of a draw call.
+    MBGL_CHECK_ERROR(glDisable(GL_STENCIL_TEST));
+    depthMask(true);
+    depthRange(strata + strata_epsilon, 1.0f);
+    batch.draw(*plainBatchShader, matrices);
+    MBGL_CHECK_ERROR(glEnable(GL_STENCIL_TEST));
+}
@@ -37,31 +37,35 @@ void SymbolBucket::render(Painter &painter, const StyleLayer &layer_desc, const
 
 bool SymbolBucket::hasData() const { return hasTextData() || hasIconData(); }
 
+std::size_t SymbolBucket::upload() {
+    return text.vertices.upload() + text.triangles.upload() +
+           icon.vertices.upload() + icon.triangles.upload();
+}
+
+bool SymbolBucket::needsUpload() const {
+    return text.vertices.pending() || text.triangles.pending() ||
+           icon.vertices.pending() || icon.triangles.pending();
+}
+
 bool SymbolBucket::hasTextData() const { return !text.groups.empty(); }
 
 bool SymbolBucket::hasIconData() const { return !icon.groups.empty(); }
 
-std::vector<SymbolFeature> SymbolBucket::processFeatures(const GeometryTileLayer& layer,
-                                                         const FilterExpression& filter,
-                                                         GlyphStore &glyphStore,
-                                                         const Sprite &sprite) {
+void SymbolBucket::prepareFeatures(const GeometryTileLayer& layer, const FilterExpression& filter) {
     const bool has_text = layout.text.field.size();
     const bool has_icon = layout.icon.image.size();
 
-    std::vector<SymbolFeature> features;
-
     if (!has_text && !has_icon) {
-        return features;
+        return;
     }
 
-    // Determine and load glyph ranges
-    std::set<GlyphRange> ranges;
+    // Determine the glyph ranges we need to load.
+    const auto compiledFilter = layer.compileFilter(filter);
 
     for (std::size_t i = 0; i < layer.featureCount(); i++) {
         auto feature = layer.getFeature(i);
 
-        GeometryTileFeatureExtractor extractor(*feature);
-        if (!evaluate(filter, extractor))
+        if (!(*compiledFilter)(*feature))
             continue;
 
         SymbolFeature ft;
@@ -92,18 +96,19 @@ std::vector<SymbolFeature> SymbolBucket::processFeatures(const GeometryTileLayer
 
         if (has_icon) {
             ft.sprite = util::replaceTokens(layout.icon.image, getValue);
+            if (ft.sprite.length()) {
+                needsSprite = true;
+            }
         }
 
         if (ft.label.length() || ft.sprite.length()) {
 
             auto &multiline = ft.geometry;
 
-            GeometryCollection geometryCollection = feature->getGeometries();
-            for (auto& line : geometryCollection) {
-                multiline.emplace_back();
-                for (auto& point : line) {
-                    multiline.back().emplace_back(point.x, point.y);
-                }
+            const GeometryCollection geometryCollection = feature->getGeometries();
+            multiline.reserve(geometryCollection.size());
+            for (const auto& line : geometryCollection) {
+                multiline.emplace_back(line.begin(), line.end());
             }
 
             features.push_back(std::move(ft));
@@ -113,21 +118,22 @@ std::vector<SymbolFeature> SymbolBucket::processFeatures(const GeometryTileLayer
     if (layout.placement == PlacementType::Line) {
         util::mergeLines(features);
     }
+}
 
-    glyphStore.waitForGlyphRanges(layout.text.font, ranges);
-    sprite.waitUntilLoaded();
+bool SymbolBucket::hasDependencies(GlyphStore& glyphStore, const Sprite& sprite) const {
+    return glyphStore.hasGlyphRanges(layout.text.font, ranges) && (!needsSprite || sprite.isLoaded());
+}
 
-    return features;
+void SymbolBucket::requestDependencies(GlyphStore& glyphStore, std::function<void()> callback) const {
+    glyphStore.requestGlyphRanges(layout.text.font, ranges, callback);
 }
 
-void SymbolBucket::addFeatures(const GeometryTileLayer& layer,
-                               const FilterExpression& filter,
-                               uintptr_t tileUID,
+void SymbolBucket::addFeatures(uintptr_t tileUID,
                                SpriteAtlas& spriteAtlas,
                                Sprite& sprite,
                                GlyphAtlas& glyphAtlas,
                                GlyphStore& glyphStore) {
-    const std::vector<SymbolFeature> features = processFeatures(layer, filter, glyphStore, sprite);
+    glyphStore.parseGlyphRanges(layout.text.font, ranges);
 
     float horizontalAlign = 0.5;
     float verticalAlign = 0.5;
@@ -199,7 +205,6 @@ void SymbolBucket::addFeatures(const GeometryTileLayer& layer,
 
         // if feature has icon, get sprite atlas position
         if (feature.sprite.length()) {
-            sprite.waitUntilLoaded();
             image = spriteAtlas.getImage(feature.sprite, false);
 
             if (sprite.getSpritePosition(feature.sprite).sdf) {
@@ -216,6 +221,9 @@ void SymbolBucket::addFeatures(const GeometryTileLayer& layer,
             }
         }
     }
+
+    // The features aren't needed anymore once they have been placed.
+    std::vector<SymbolFeature>().swap(features);
 }
 
 bool byScale(const Anchor &a, const Anchor &b) { return a.scale < b.scale; }
@@ -12,8 +12,10 @@
 #include <mbgl/style/style_bucket.hpp>
 #include <mbgl/style/style_layout.hpp>
 
+#include <functional>
 #include <memory>
 #include <map>
+#include <set>
 #include <vector>
 
 namespace mbgl {
@@ -62,12 +64,19 @@ public:
     void render(Painter &painter, const StyleLayer &layer_desc, const Tile::ID &id,
                 const mat4 &matrix) override;
     bool hasData() const override;
+    std::size_t upload() override;
+    bool needsUpload() const override;
     bool hasTextData() const;
     bool hasIconData() const;
 
-    void addFeatures(const GeometryTileLayer&,
-                     const FilterExpression&,
-                     uintptr_t tileUID,
+    // Symbols are parsed in two phases so that workers never wait for glyphs or
+    // sprites: prepareFeatures() extracts labels, icons and geometries and collects
+    // the glyph ranges they need. addFeatures() shapes and places them once
+    // hasDependencies() returns true.
+    void prepareFeatures(const GeometryTileLayer&, const FilterExpression&);
+    bool hasDependencies(GlyphStore&, const Sprite&) const;
+    void requestDependencies(GlyphStore&, std::function<void()> callback) const;
+    void addFeatures(uintptr_t tileUID,
                      SpriteAtlas&,
                      Sprite&,
                      GlyphAtlas&,
@@ -78,11 +87,6 @@ public:
     void drawIcons(IconShader& shader);
 
 private:
-    std::vector<SymbolFeature> processFeatures(const GeometryTileLayer&,
-                                               const FilterExpression&,
-                                               GlyphStore&,
-                                               const Sprite&);
-
     void addFeature(const std::vector<Coordinate> &line, const Shaping &shaping, const GlyphPositions &face, const Rect<uint16_t> &image);
 
     // Adds placed items to the buffer.
@@ -96,6 +100,11 @@ public:
 private:
     Collision &collision;
 
+    // Features extracted by prepareFeatures(), and the glyph ranges and sprite they need.
+    std::vector<SymbolFeature> features;
+    std::set<GlyphRange> ranges;
+    bool needsSprite = false;
+
     struct TextBuffer {
         TextVertexBuffer vertices;
         TriangleElementsBuffer triangles;
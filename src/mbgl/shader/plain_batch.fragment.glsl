@@ -0,0 +1,11 @@
+uniform vec4 u_color;
+
+varying vec2 v_pos;
+
+void main() {
+    // Clips to the tile, like the stencil mask does when tiles are drawn on their own.
+    if (v_pos.x < 0.0 || v_pos.y < 0.0 || v_pos.x > 4096.0 || v_pos.y > 4096.0) {
+        discard;
+    }
+    gl_FragColor = u_color;
+}
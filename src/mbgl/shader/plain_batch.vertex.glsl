@@ -0,0 +1,12 @@
+attribute vec2 a_pos;
+attribute float a_tile;
+
+// Keep the size in sync with FillBatch::maxTiles.
+uniform mat4 u_matrices[16];
+
+varying vec2 v_pos;
+
+void main() {
+    gl_Position = u_matrices[int(a_tile)] * vec4(a_pos, 0, 1);
+    v_pos = a_pos;
+}
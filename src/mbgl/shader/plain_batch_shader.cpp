@@ -0,0 +1,23 @@
+#include <mbgl/shader/plain_batch_shader.hpp>
+#include <mbgl/shader/shaders.hpp>
+#include <mbgl/platform/gl.hpp>
+
+using namespace mbgl;
+
+PlainBatchShader::PlainBatchShader()
+    : Shader(
+        "plain_batch",
+        shaders[PLAIN_BATCH_SHADER].vertex,
+        shaders[PLAIN_BATCH_SHADER].fragment
+    ) {
+    a_pos = MBGL_CHECK_ERROR(glGetAttribLocation(program, "a_pos"));
+    a_tile = MBGL_CHECK_ERROR(glGetAttribLocation(program, "a_tile"));
+}
+
+void PlainBatchShader::bind(char *offset) {
+    MBGL_CHECK_ERROR(glEnableVertexAttribArray(a_pos));
+    MBGL_CHECK_ERROR(glVertexAttribPointer(a_pos, 2, GL_SHORT, false, 8, offset + 0));
+
+    MBGL_CHECK_ERROR(glEnableVertexAttribArray(a_tile));
+    MBGL_CHECK_ERROR(glVertexAttribPointer(a_tile, 1, GL_SHORT, false, 8, offset + 4));
+}
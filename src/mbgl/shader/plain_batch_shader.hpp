@@ -0,0 +1,26 @@
+#ifndef MBGL_SHADER_SHADER_PLAIN_BATCH
+#define MBGL_SHADER_SHADER_PLAIN_BATCH
+
+#include <mbgl/shader/shader.hpp>
+#include <mbgl/shader/uniform.hpp>
+
+namespace mbgl {
+
+// Draws the triangles of several tiles at once. Every vertex selects its tile's matrix.
+class PlainBatchShader : public Shader {
+public:
+    PlainBatchShader();
+
+    void bind(char *offset);
+
+    UniformMatrixArray<4>         u_matrices = {"u_matrices", *this};
+    Uniform<std::array<float, 4>> u_color    = {"u_color",    *this};
+
+private:
+    int32_t a_pos = -1;
+    int32_t a_tile = -1;
+};
+
+}
+
+#endif
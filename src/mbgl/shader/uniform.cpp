@@ -42,6 +42,11 @@ void UniformMatrix<4>::bind(const std::array<float, 16>& t) {
     MBGL_CHECK_ERROR(glUniformMatrix4fv(location, 1, GL_FALSE, t.data()));
 }
 
+template <>
+void UniformMatrixArray<4>::set(const std::array<float, 16>* t, size_t count) {
+    MBGL_CHECK_ERROR(glUniformMatrix4fv(location, GLsizei(count), GL_FALSE, t->data()));
+}
+
 // Add more as needed.
 
 }
@@ -50,6 +50,23 @@ private:
     GLint location;
 };
 
+// Sets the first elements of an array of matrices. The values aren't compared with the previous
+// ones, because each call usually sets other matrices.
+template <size_t C, size_t R = C>
+class UniformMatrixArray {
+public:
+    typedef std::array<float, C*R> T;
+
+    UniformMatrixArray(const GLchar* name, const Shader& shader) {
+        location = MBGL_CHECK_ERROR(glGetUniformLocation(shader.program, name));
+    }
+
+    void set(const T* t, size_t count);
+
+private:
+    GLint location;
+};
+
 }
 
 #endif
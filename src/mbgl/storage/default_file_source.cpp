@@ -2,12 +2,14 @@
 #include <mbgl/storage/default/request.hpp>
 #include <mbgl/storage/default/asset_request.hpp>
 #include <mbgl/storage/default/http_request.hpp>
+#include <mbgl/storage/default/mbtiles_request.hpp>
 
 #include <mbgl/storage/response.hpp>
 #include <mbgl/platform/platform.hpp>
 
 #include <mbgl/util/async_queue.hpp>
 #include <mbgl/util/util.hpp>
+#include <mbgl/util/uv_detail.hpp>
 
 #include <mbgl/util/variant.hpp>
 #include <mbgl/platform/log.hpp>
@@ -42,9 +44,17 @@ struct DefaultFileSource::RemoveRequestAction {
     Request *const request;
 };
 
-struct DefaultFileSource::ResultAction {
+struct DefaultFileSource::SetPriorityAction {
+    // The request may have completed and been deleted by the time this action is processed, so
+    // it is only dereferenced once it was found among the observers of a pending request.
+    Request *const request;
     const Resource resource;
-    std::unique_ptr<Response> response;
+    const double priority;
+};
+
+struct DefaultFileSource::ResultsAction {
+    const std::vector<Resource> resources;
+    std::vector<std::unique_ptr<Response>> responses;
 };
 
 struct DefaultFileSource::StopAction {
@@ -61,6 +71,8 @@ DefaultFileSource::DefaultFileSource(FileCache *cache_, const std::string &root)
       cache(cache_),
       queue(new Queue(loop, [this](Action &action) {
           mapbox::util::apply_visitor(ActionDispatcher{*this}, action);
+      }, [this] {
+          lookupPendingResources();
       })),
       thread([this]() {
 #ifdef __APPLE__
@@ -76,6 +88,8 @@ DefaultFileSource::DefaultFileSource(FileCache *cache_, uv_loop_t *loop_, const
       cache(cache_),
       queue(new Queue(loop, [this](Action &action) {
           mapbox::util::apply_visitor(ActionDispatcher{*this}, action);
+      }, [this] {
+          lookupPendingResources();
       })) {
     // Make sure that the queue doesn't block the loop from exiting.
     queue->unref();
@@ -92,8 +106,7 @@ DefaultFileSource::~DefaultFileSource() {
         uv_loop_delete(loop);
     } else {
         // Assume that the loop we received is running in the current thread.
-        StopAction action {};
-        process(action);
+        stop();
     }
 }
 
@@ -136,10 +149,43 @@ void DefaultFileSource::cancel(Request *req) {
     queue->send(RemoveRequestAction{ req });
 }
 
+void DefaultFileSource::setPriority(Request *req, double priority) {
+    // This function can be called from any thread. Make sure we're executing the actual call in the
+    // file source loop by sending it over the queue. It will be processed in processAction().
+    queue->send(SetPriorityAction{ req, req->resource, priority });
+}
+
 void DefaultFileSource::abort(const Environment &env) {
     queue->send(AbortAction{ env });
 }
 
+void DefaultFileSource::setMaximumConcurrentRequests(unsigned int maximum) {
+    // Takes effect when the next request is added or completes.
+    maximumConcurrentRequests = std::max(1u, maximum);
+}
+
+void DefaultFileSource::setMaximumConnectionsPerHost(unsigned int maximum) {
+    maximumConnectionsPerHost = std::max(1u, maximum);
+}
+
+unsigned int DefaultFileSource::getMaximumConnectionsPerHost() const {
+    return maximumConnectionsPerHost;
+}
+
+void DefaultFileSource::setStaleWhileRevalidate(bool enabled) {
+    // Takes effect for the next cache lookup.
+    staleWhileRevalidate = enabled;
+}
+
+std::unique_ptr<OfflineDownload> DefaultFileSource::downloadRegion(const OfflineRegion &region,
+                                                                   OfflineDownload::ProgressCallback progress,
+                                                                   OfflineDownload::CompletionCallback completion) {
+    if (!cache) {
+        return nullptr;
+    }
+    return util::make_unique<OfflineDownload>(*this, *cache, region, std::move(progress), std::move(completion));
+}
+
 
 void DefaultFileSource::process(AddRequestAction &action) {
     const Resource &resource = action.request->resource;
@@ -150,6 +196,8 @@ void DefaultFileSource::process(AddRequestAction &action) {
         // There is no request for this URL yet. Create a new one and start it.
         if (algo::starts_with(resource.url, "asset://")) {
             sharedRequest = new AssetRequest(this, resource);
+        } else if (algo::starts_with(resource.url, "mbtiles://")) {
+            sharedRequest = new MBTilesRequest(this, resource);
         } else {
             sharedRequest = new HTTPRequest(this, resource);
         }
@@ -163,18 +211,19 @@ void DefaultFileSource::process(AddRequestAction &action) {
         assert(inserted);
         (void (inserted)); // silence unused variable warning on Release builds.
 
-        // But first, we're going to start querying the database if it exists.
-        if (!cache) {
-            sharedRequest->start(loop);
+        // But first, we're going to start querying the database if it exists. MBTiles files are
+        // databases themselves and bypass the cache.
+        if (!cache || algo::starts_with(resource.url, "mbtiles://")) {
+            startRequest(sharedRequest, nullptr);
         } else {
             // Otherwise, first check the cache for existing data so that we can potentially
-            // revalidate the information without having to redownload everything.
-            cache->get(resource, [this, resource](std::unique_ptr<Response> response) {
-                queue->send(ResultAction { resource, std::move(response) });
-            });
+            // revalidate the information without having to redownload everything. The lookup is
+            // sent along with the others of this loop iteration.
+            pendingLookups.push_back(resource);
         }
     }
     sharedRequest->subscribe(action.request);
+    updatePriority(sharedRequest);
 }
 
 void DefaultFileSource::process(RemoveRequestAction &action) {
@@ -184,6 +233,12 @@ void DefaultFileSource::process(RemoveRequestAction &action) {
         // unsubscribe callback triggers the removal of the SharedRequestBase pointer from the list
         // of pending requests and initiates cancelation.
         sharedRequest->unsubscribe(action.request);
+
+        // The remaining observers may be less urgent. Abandoned requests are gone by now.
+        sharedRequest = find(action.request->resource);
+        if (sharedRequest) {
+            updatePriority(sharedRequest);
+        }
     } else {
         // There is no request for this URL anymore. Likely, the request already completed
         // before we got around to process the cancelation request.
@@ -194,25 +249,69 @@ void DefaultFileSource::process(RemoveRequestAction &action) {
     action.request->destruct();
 }
 
-void DefaultFileSource::process(ResultAction &action) {
+void DefaultFileSource::process(SetPriorityAction &action) {
     SharedRequestBase *sharedRequest = find(action.resource);
+    if (sharedRequest && sharedRequest->observes(action.request)) {
+        action.request->priority = action.priority;
+        updatePriority(sharedRequest);
+    }
+}
+
+void DefaultFileSource::lookupPendingResources() {
+    if (pendingLookups.empty()) {
+        return;
+    }
+
+    assert(cache);
+    std::vector<Resource> resources;
+    resources.swap(pendingLookups);
+
+    // The results of the whole batch come back in a single action.
+    activeLookups++;
+    cache->get(resources, [this, resources](std::vector<std::unique_ptr<Response>> responses) {
+        queue->send(ResultsAction { resources, std::move(responses) });
+    });
+}
+
+void DefaultFileSource::process(ResultsAction &action) {
+    assert(action.resources.size() == action.responses.size());
+    assert(activeLookups > 0);
+    activeLookups--;
+    for (std::size_t i = 0; i < action.resources.size(); i++) {
+        processResult(action.resources[i], std::move(action.responses[i]));
+    }
+
+    if (stopping && activeLookups == 0) {
+        stop();
+    }
+}
+
+void DefaultFileSource::processResult(const Resource &resource, std::unique_ptr<Response> response) {
+    SharedRequestBase *sharedRequest = find(resource);
     if (sharedRequest) {
-        if (action.response) {
+        if (response) {
             // This entry was stored in the cache. Now determine if we need to revalidate.
             const int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
                                     std::chrono::system_clock::now().time_since_epoch()).count();
-            if (action.response->expires > now) {
+            if (response->expires > now) {
                 // The response is fresh. We're good to notify the caller.
-                sharedRequest->notify(std::move(action.response), FileCache::Hint::No);
+                sharedRequest->notify(std::move(response), FileCache::Hint::No);
                 sharedRequest->cancel();
                 return;
             } else {
+                if (staleWhileRevalidate) {
+                    // Hand out the expired data while we're revalidating it.
+                    auto stale = std::make_shared<Response>(*response);
+                    stale->stale = true;
+                    sharedRequest->notifyStale(std::move(stale));
+                }
+
                 // The cached response is stale. Now run the real request.
-                sharedRequest->start(loop, std::move(action.response));
+                startRequest(sharedRequest, std::move(response));
             }
         } else {
             // There is no response. Now run the real request.
-            sharedRequest->start(loop);
+            startRequest(sharedRequest, nullptr);
         }
     } else {
         // There is no request for this URL anymore. Likely, the request was canceled
@@ -220,15 +319,90 @@ void DefaultFileSource::process(ResultAction &action) {
     }
 }
 
+void DefaultFileSource::startRequest(SharedRequestBase *sharedRequest, std::unique_ptr<Response> response) {
+    // Assets and MBTiles are read from disk and don't count against the network concurrency limit.
+    const std::string &url = sharedRequest->resource.url;
+    if (algo::starts_with(url, "asset://") || algo::starts_with(url, "mbtiles://")) {
+        sharedRequest->start(loop, std::move(response));
+        return;
+    }
+
+    const QueueKey key { sharedRequest->priority(), queuedSequence++ };
+    queuedRequests.emplace(key, std::make_pair(sharedRequest, std::move(response)));
+    queuedKeys.emplace(sharedRequest, key);
+    startQueuedRequests();
+}
+
+void DefaultFileSource::startQueuedRequests() {
+    while (!queuedRequests.empty() && activeRequests.size() < maximumConcurrentRequests) {
+        auto next = std::move(queuedRequests.begin()->second);
+        queuedRequests.erase(queuedRequests.begin());
+        queuedKeys.erase(next.first);
+        activeRequests.insert(next.first);
+        next.first->start(loop, std::move(next.second));
+    }
+}
+
+// Moves a queued request to the position of its observers' most urgent priority. Requests that
+// already started, or still wait for the cache, pick up the priority when they are queued.
+void DefaultFileSource::updatePriority(SharedRequestBase *sharedRequest) {
+    const auto it = queuedKeys.find(sharedRequest);
+    if (it == queuedKeys.end()) {
+        return;
+    }
+
+    const double priority = sharedRequest->priority();
+    if (priority == it->second.first) {
+        return;
+    }
+
+    const QueueKey key { priority, it->second.second };
+    auto queued = queuedRequests.find(it->second);
+    assert(queued != queuedRequests.end());
+    auto value = std::move(queued->second);
+    queuedRequests.erase(queued);
+    queuedRequests.emplace(key, std::move(value));
+    it->second = key;
+}
+
+// Forgets a request that completed or is about to be canceled. Doesn't start queued requests.
+void DefaultFileSource::removeRequest(SharedRequestBase *sharedRequest) {
+    if (!activeRequests.erase(sharedRequest)) {
+        const auto it = queuedKeys.find(sharedRequest);
+        if (it != queuedKeys.end()) {
+            queuedRequests.erase(it->second);
+            queuedKeys.erase(it);
+        }
+    }
+}
+
+uv::worker &DefaultFileSource::getReaders() {
+    if (!readers) {
+        readers = util::make_unique<uv::worker>(loop, readerThreads, "File Reader");
+    }
+    return *readers;
+}
+
 // A stop action means the file source is about to be destructed. We need to cancel all requests
 // for all environments.
 void DefaultFileSource::process(StopAction &) {
+    // Requests that were canceled right before may still be looked up in the cache.
+    stopping = true;
+    if (activeLookups == 0) {
+        stop();
+    }
+}
+
+void DefaultFileSource::stop() {
     // There may not be any pending requests in this file source anymore. You must terminate all
     // Map objects before deleting the FileSource.
     assert(pending.empty());
     assert(queue);
     queue->stop();
     queue = nullptr;
+
+    // The reader threads finish and join in later iterations of the loop.
+    readers.reset();
 }
 
 // Aborts all requests that are part of the current environment.
@@ -251,12 +425,15 @@ void DefaultFileSource::process(AbortAction &action) {
 
         // Finally, remove all requests that are now abandoned.
         if (it.second->abandoned()) {
+            removeRequest(it.second);
             it.second->cancel();
             return true;
         } else {
             return false;
         }
     });
+
+    startQueuedRequests();
 }
 
 void DefaultFileSource::notify(SharedRequestBase *sharedRequest,
@@ -265,16 +442,37 @@ void DefaultFileSource::notify(SharedRequestBase *sharedRequest,
     // First, remove the request, since it might be destructed at any point now.
     assert(find(sharedRequest->resource) == sharedRequest);
     pending.erase(sharedRequest->resource);
+    removeRequest(sharedRequest);
 
     if (response) {
-        if (cache) {
-            // Store response in database
+        const auto &stale = sharedRequest->staleResponse;
+
+        if (cache && !(stale && response->status != Response::Successful)) {
+            // Store response in database. A failed revalidation keeps the stale data.
             cache->put(sharedRequest->resource, response, hint);
         }
 
+        // Observers that got the stale data are told to keep it if the data didn't change. A failed
+        // revalidation keeps the stale data too.
+        std::shared_ptr<const Response> unchanged;
+        if (stale && (response->notModified || response->status != Response::Successful ||
+                      *response->data == *stale->data)) {
+            auto confirmed = std::make_shared<Response>(*stale);
+            confirmed->stale = false;
+            confirmed->notModified = true;
+            if (response->status == Response::Successful) {
+                confirmed->expires = response->expires;
+            }
+            unchanged = std::move(confirmed);
+        }
+
         // Notify all observers.
         for (auto req : observers) {
-            req->notify(response);
+            if (unchanged && req->resource.acceptsStale) {
+                req->notify(unchanged);
+            } else {
+                req->notify(response);
+            }
         }
     }
 
@@ -282,6 +480,10 @@ void DefaultFileSource::notify(SharedRequestBase *sharedRequest,
         // When there are no pending requests, we're going to allow the queue to stop.
         queue->unref();
     }
+
+    // The request freed a slot. It stays alive until this function returns, so the next one is
+    // started while both exist.
+    startQueuedRequests();
 }
 
 }
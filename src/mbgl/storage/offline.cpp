@@ -0,0 +1,400 @@
+#include <mbgl/storage/offline.hpp>
+#include <mbgl/storage/file_cache.hpp>
+#include <mbgl/storage/response.hpp>
+
+#include <mbgl/map/environment.hpp>
+#include <mbgl/map/tile.hpp>
+#include <mbgl/style/style.hpp>
+#include <mbgl/style/style_bucket.hpp>
+#include <mbgl/style/style_layer.hpp>
+#include <mbgl/style/style_layer_group.hpp>
+#include <mbgl/style/style_source.hpp>
+#include <mbgl/platform/log.hpp>
+#include <mbgl/util/box.hpp>
+#include <mbgl/util/constants.hpp>
+#include <mbgl/util/mapbox.hpp>
+#include <mbgl/util/math.hpp>
+#include <mbgl/util/std.hpp>
+#include <mbgl/util/string.hpp>
+#include <mbgl/util/token.hpp>
+#include <mbgl/util/url.hpp>
+#include <mbgl/util/uv_detail.hpp>
+
+#include <rapidjson/document.h>
+
+#include <cmath>
+#include <limits>
+#include <set>
+
+namespace mbgl {
+
+namespace {
+
+// The stored progress is rewritten after this many resources completed.
+const std::size_t progressInterval = 64;
+
+// Sets point to the fractional tile coordinates of a location at zoom z.
+void project(vec2<double> &point, const LatLng &latLng, int32_t z) {
+    const double scale = std::pow(2, z);
+    const double lat = util::clamp(latLng.latitude, -util::LATITUDE_MAX, util::LATITUDE_MAX);
+    const double y = std::log(std::tan(M_PI / 4 + lat * M_PI / 360));
+    point.x = (latLng.longitude + 180) / 360 * scale;
+    point.y = (1 - y / M_PI) / 2 * scale;
+}
+
+// Identifies the ordered list of resources, so that a later run only resumes from the stored
+// progress when it downloads the same resources in the same order. This is 64-bit FNV-1a, which
+// unlike std::hash gives the same result in every build.
+uint64_t hashResources(const std::vector<Resource> &resources) {
+    const uint64_t prime = 1099511628211ull;
+    uint64_t hash = 14695981039346656037ull;
+    for (const auto &resource : resources) {
+        for (const char c : resource.url) {
+            hash = (hash ^ uint8_t(c)) * prime;
+        }
+        // Separates the URLs.
+        hash *= prime;
+    }
+    return hash;
+}
+
+std::forward_list<Tile::ID> coverRegion(const LatLngBounds &bounds, int32_t z) {
+    box b;
+    project(b.tl, { bounds.ne.latitude, bounds.sw.longitude }, z);
+    project(b.tr, { bounds.ne.latitude, bounds.ne.longitude }, z);
+    project(b.br, { bounds.sw.latitude, bounds.ne.longitude }, z);
+    project(b.bl, { bounds.sw.latitude, bounds.sw.longitude }, z);
+    b.center.x = (b.tl.x + b.br.x) / 2;
+    b.center.y = (b.tl.y + b.br.y) / 2;
+
+    std::forward_list<Tile::ID> ids = Tile::cover(z, b);
+
+    // The cover may touch the row and column just outside the world, and it lists tiles on the
+    // diagonal shared by its two triangles twice.
+    const int32_t tiles = 1 << z;
+    ids.remove_if([tiles](const Tile::ID &id) {
+        return id.x < 0 || id.x >= tiles || id.y < 0 || id.y >= tiles;
+    });
+    ids.sort();
+    ids.unique();
+    return ids;
+}
+
+}
+
+OfflineDownload::OfflineDownload(FileSource &fileSource, FileCache &cache_, const OfflineRegion &region_,
+                                 ProgressCallback progress_, CompletionCallback completion_,
+                                 unsigned int maximumConcurrentRequests_)
+    : cache(cache_),
+      region(region_),
+      progressResource({ Resource::Unknown, "offline://" + util::percentEncode(region_.name) }),
+      progressCallback(progress_),
+      completionCallback(completion_),
+      maximumConcurrentRequests(std::max(1u, maximumConcurrentRequests_)),
+      env(util::make_unique<Environment>(fileSource)) {
+    asyncStart = util::make_unique<uv::async>(env->loop, [this] {
+        const std::string url = util::mapbox::normalizeStyleURL(region.styleURL, region.accessToken);
+        styleRequest = env->request({ Resource::Kind::JSON, url }, [this](const Response &res) {
+            styleRequest = nullptr;
+            loadStyle(res);
+        });
+    });
+
+    asyncTerminate = util::make_unique<uv::async>(env->loop, [this] {
+        terminate();
+    });
+
+    // Look up the progress of an earlier run before starting. The callback runs in the cache
+    // thread.
+    cache.get(progressResource, [this](std::unique_ptr<Response> res) {
+        std::lock_guard<std::mutex> lock(storedMutex);
+        if (res && res->status == Response::Successful) {
+            rapidjson::Document doc;
+            doc.Parse<0>(res->data->c_str());
+            if (!doc.HasParseError() && doc.IsObject() &&
+                doc.HasMember("completed") && doc["completed"].IsUint64() &&
+                doc.HasMember("required") && doc["required"].IsUint64() &&
+                doc.HasMember("hash") && doc["hash"].IsUint64()) {
+                storedCompleted = doc["completed"].GetUint64();
+                storedRequired = doc["required"].GetUint64();
+                storedHash = doc["hash"].GetUint64();
+            }
+        }
+        storedLoaded = true;
+        asyncStart->send();
+        storedCondition.notify_one();
+    });
+
+    thread = std::thread([this] {
+        EnvironmentScope scope(*env, ThreadType::Map, "Offline");
+        uv_run(env->loop, UV_RUN_DEFAULT);
+    });
+}
+
+OfflineDownload::~OfflineDownload() {
+    {
+        // The cache callback refers to this object.
+        std::unique_lock<std::mutex> lock(storedMutex);
+        storedCondition.wait(lock, [this] { return storedLoaded; });
+    }
+
+    asyncTerminate->send();
+    thread.join();
+}
+
+void OfflineDownload::terminate() {
+    assert(Environment::currentlyOn(ThreadType::Map));
+
+    // Canceled requests keep the loop alive until the file source confirmed the cancelation.
+    if (styleRequest) {
+        env->cancelRequest(styleRequest);
+        styleRequest = nullptr;
+    }
+    for (auto &req : sourceRequests) {
+        if (req) {
+            env->cancelRequest(req);
+            req = nullptr;
+        }
+    }
+    for (auto &pair : active) {
+        env->cancelRequest(pair.second);
+    }
+    active.clear();
+
+    if (!finished && !resources.empty()) {
+        saveProgress();
+    }
+
+    style.reset();
+    asyncStart.reset();
+    asyncTerminate.reset();
+}
+
+void OfflineDownload::loadStyle(const Response &res) {
+    if (res.status != Response::Successful) {
+        finish("Failed to load style: " + res.message);
+        return;
+    }
+
+    style = util::make_unique<Style>();
+    try {
+        style->loadJSON(reinterpret_cast<const uint8_t *>(res.data->c_str()));
+    } catch (const std::exception &ex) {
+        finish(std::string("Failed to parse style: ") + ex.what());
+        return;
+    }
+
+    // Sources that are referenced by a URL need their TileJSON before we know their tiles.
+    std::set<const StyleSource *> seen;
+    for (const auto &layer : style->layers->layers) {
+        if (!layer->bucket || !layer->bucket->style_source) {
+            continue;
+        }
+        StyleSource &source = *layer->bucket->style_source;
+        if (!seen.insert(&source).second || source.info.url.empty()) {
+            continue;
+        }
+
+        const std::size_t index = sourceRequests.size();
+        const std::string url = util::mapbox::normalizeSourceURL(source.info.url, region.accessToken);
+        pendingSources++;
+        sourceRequests.push_back(nullptr);
+        sourceRequests[index] = env->request({ Resource::Kind::JSON, url }, [this, index, &source](const Response &sourceRes) {
+            sourceRequests[index] = nullptr;
+            if (sourceRes.status == Response::Successful) {
+                rapidjson::Document doc;
+                doc.Parse<0>(sourceRes.data->c_str());
+                if (!doc.HasParseError()) {
+                    source.info.parseTileJSONProperties(doc);
+                } else {
+                    Log::Warning(Event::General, "Invalid source TileJSON; Parse Error at %d: %s",
+                                 doc.GetErrorOffset(), doc.GetParseError());
+                }
+            } else {
+                Log::Warning(Event::General, "Failed to load source TileJSON: %s", sourceRes.message.c_str());
+            }
+            loadedSource();
+        });
+    }
+
+    if (!pendingSources) {
+        enumerateResources();
+    }
+}
+
+void OfflineDownload::loadedSource() {
+    assert(pendingSources > 0);
+    if (--pendingSources == 0) {
+        enumerateResources();
+    }
+}
+
+void OfflineDownload::enumerateResources() {
+    const std::string styleURL = util::mapbox::normalizeStyleURL(region.styleURL, region.accessToken);
+    resources.push_back({ Resource::Kind::JSON, styleURL });
+
+    std::vector<const SourceInfo *> sources;
+    std::set<std::string> fontStacks;
+    std::set<const StyleSource *> seen;
+
+    for (const auto &layer : style->layers->layers) {
+        if (!layer->bucket) {
+            continue;
+        }
+        const StyleBucket &bucket = *layer->bucket;
+
+        if (bucket.style_source && seen.insert(bucket.style_source.get()).second) {
+            const SourceInfo &info = bucket.style_source->info;
+            if (!info.url.empty()) {
+                resources.push_back({ Resource::Kind::JSON,
+                                      util::mapbox::normalizeSourceURL(info.url, region.accessToken) });
+            }
+            if (info.type == SourceType::Vector || info.type == SourceType::Raster) {
+                sources.push_back(&info);
+            }
+        }
+
+        // The font stack may depend on the zoom level.
+        auto font = bucket.layout.properties.find(PropertyKey::TextFont);
+        if (font != bucket.layout.properties.end() && font->second.is<Function<std::string>>()) {
+            const auto &function = font->second.get<Function<std::string>>();
+            for (int32_t z = std::floor(region.minZoom); z <= std::ceil(region.maxZoom); z++) {
+                const std::string fontStack =
+                    mapbox::util::apply_visitor(FunctionEvaluator<std::string>(z), function);
+                if (!fontStack.empty()) {
+                    fontStacks.insert(fontStack);
+                }
+            }
+        }
+    }
+
+    const std::string &spriteURL = style->getSpriteURL();
+    if (!spriteURL.empty()) {
+        const std::string suffix = region.pixelRatio > 1 ? "@2x" : "";
+        resources.push_back({ Resource::Kind::JSON, spriteURL + suffix + ".json" });
+        resources.push_back({ Resource::Kind::Image, spriteURL + suffix + ".png" });
+    }
+
+    if (!style->glyph_url.empty()) {
+        // Labels may use any range, so all of them are needed.
+        const std::string glyphURL = util::mapbox::normalizeGlyphsURL(style->glyph_url, region.accessToken);
+        for (const auto &fontStack : fontStacks) {
+            for (uint32_t start = 0; start < 65536; start += 256) {
+                resources.push_back({ Resource::Kind::Glyphs,
+                    util::replaceTokens(glyphURL, [&](const std::string &name) -> std::string {
+                        if (name == "fontstack") return util::percentEncode(fontStack);
+                        if (name == "range") return util::toString(start) + "-" + util::toString(start + 255);
+                        return "";
+                    })
+                });
+            }
+        }
+    }
+
+    for (const SourceInfo *info : sources) {
+        // Sources with smaller tiles are shown at higher tile zoom levels; see Source::getZoom().
+        const double offset = std::log(util::tileSize / info->tile_size) / std::log(2);
+        const int32_t minZoom = std::max<int32_t>(std::floor(region.minZoom + offset), info->min_zoom);
+        const int32_t maxZoom = std::min<int32_t>(std::floor(region.maxZoom + offset), info->max_zoom);
+        for (int32_t z = minZoom; z <= maxZoom; z++) {
+            for (const auto &id : coverRegion(region.bounds, z)) {
+                const std::string url = info->tileURL(id, region.pixelRatio);
+                if (!url.empty()) {
+                    resources.push_back({ Resource::Kind::Tile, url });
+                }
+            }
+        }
+    }
+
+    done.resize(resources.size(), false);
+    resourcesHash = hashResources(resources);
+    progress.requiredResources = resources.size();
+
+    {
+        // Resume if an earlier run downloaded the same list of resources.
+        std::lock_guard<std::mutex> lock(storedMutex);
+        if (storedHash == resourcesHash && storedRequired == resources.size() &&
+            storedCompleted <= resources.size()) {
+            watermark = next = storedCompleted;
+            std::fill(done.begin(), done.begin() + watermark, true);
+        }
+    }
+    progress.completedResources = watermark;
+
+    if (progressCallback) {
+        progressCallback(progress);
+    }
+
+    requestResources();
+}
+
+void OfflineDownload::requestResources() {
+    while (active.size() < maximumConcurrentRequests && next < resources.size()) {
+        const std::size_t index = next++;
+        active.emplace(index, env->request(resources[index], [this, index](const Response &res) {
+            completed(index, res);
+        }));
+    }
+
+    if (active.empty() && next == resources.size()) {
+        saveProgress();
+        finish("");
+    }
+}
+
+void OfflineDownload::completed(std::size_t index, const Response &res) {
+    active.erase(index);
+    done[index] = true;
+
+    progress.completedResources++;
+    progress.completedBytes += res.data->size();
+    if (res.status == Response::Successful) {
+        // The file source stored the response before notifying us.
+        cache.pin(resources[index]);
+    } else {
+        progress.failedResources++;
+        Log::Warning(Event::General, "Failed to download %s for offline use: %s",
+                     resources[index].url.c_str(), res.message.c_str());
+    }
+
+    const std::size_t previous = watermark;
+    while (watermark < done.size() && done[watermark]) {
+        watermark++;
+    }
+    if (watermark / progressInterval != previous / progressInterval) {
+        saveProgress();
+    }
+
+    if (progressCallback) {
+        progressCallback(progress);
+    }
+
+    requestResources();
+}
+
+void OfflineDownload::saveProgress() {
+    // Only the contiguous prefix of completed resources is recorded; a restart may fetch some
+    // resources again, which the cache answers without hitting the network.
+    auto res = std::make_shared<Response>();
+    res->status = Response::Successful;
+    res->expires = std::numeric_limits<int64_t>::max();
+    res->data = std::make_shared<const std::string>(
+        "{\"completed\":" + util::toString(uint64_t(watermark)) +
+        ",\"required\":" + util::toString(uint64_t(resources.size())) +
+        ",\"hash\":" + util::toString(resourcesHash) + "}");
+
+    cache.put(progressResource, res, FileCache::Hint::Full);
+    cache.pin(progressResource);
+}
+
+void OfflineDownload::finish(const std::string &error) {
+    finished = true;
+    if (!error.empty()) {
+        Log::Error(Event::General, "Offline download of %s failed: %s", region.name.c_str(), error.c_str());
+    }
+    if (completionCallback) {
+        completionCallback(progress, error);
+    }
+}
+
+}
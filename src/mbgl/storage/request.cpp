@@ -17,7 +17,7 @@ struct Request::Canceled { std::mutex mutex; bool confirmed = false; };
 
 // Note: This requires that loop is running in the current thread (or not yet running).
 Request::Request(const Resource &resource_, uv_loop_t *loop, const Environment &env_, Callback callback_)
-    : callback(callback_), resource(resource_), env(env_) {
+    : callback(callback_), resource(resource_), priority(resource_.priority), env(env_) {
     // When there is no loop supplied (== nullptr), the callback will be fired in an arbitrary
     // thread (the thread notify() is called from) rather than kicking back to the calling thread.
     if (loop) {
@@ -50,13 +50,23 @@ void Request::notifyCallback() {
 }
 
 void Request::invoke() {
-    assert(response);
+    std::shared_ptr<const Response> current;
+    bool finished = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        current.swap(response);
+        finished = completed;
+    }
+
     // The user could supply a null pointer or empty std::function as a callback. In this case, we
     // still do the file request, but we don't need to deliver a result.
-    if (callback) {
-        callback(*response);
+    if (callback && current) {
+        callback(*current);
+    }
+
+    if (finished) {
+        delete this;
     }
-    delete this;
 }
 
 Request::~Request() {
@@ -69,9 +79,14 @@ Request::~Request() {
 
 // Called in the FileSource thread.
 void Request::notify(const std::shared_ptr<const Response> &response_) {
-    assert(!response);
-    response = response_;
-    assert(response);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        assert(!completed);
+        // Both notifications may arrive before the callback ran. The newer response replaces a
+        // stale one that wasn't delivered yet.
+        response = response_;
+        completed = !response_->stale;
+    }
 
     if (async) {
         uv_async_send(async);
@@ -0,0 +1,205 @@
+#include <mbgl/style/filter_program.hpp>
+#include <mbgl/style/filter_expression_private.hpp>
+
+#include <algorithm>
+
+namespace mbgl {
+
+namespace {
+
+// Yields the same value for every key. Used to evaluate a single comparison
+// against one candidate value.
+class ConstantExtractor {
+public:
+    ConstantExtractor(const mapbox::util::optional<Value>& value_)
+        : value(value_) {}
+
+    mapbox::util::optional<Value> getValue(const std::string&) const {
+        return value;
+    }
+
+private:
+    const mapbox::util::optional<Value>& value;
+};
+
+bool evaluateConstant(const FilterExpression& expression, const mapbox::util::optional<Value>& value) {
+    return evaluate(expression, ConstantExtractor(value));
+}
+
+}
+
+class FilterProgramCompiler : public mapbox::util::static_visitor<void> {
+public:
+    FilterProgramCompiler(FilterProgram& program_,
+                          const std::unordered_map<std::string, uint32_t>& keys_,
+                          const FilterExpression& expression_)
+        : program(program_), keys(keys_), expression(expression_) {}
+
+    void operator()(const NullExpression&) {
+        FilterProgram::Instruction instruction;
+        instruction.op = FilterProgram::Op::Const;
+        instruction.result = true;
+        program.instructions.push_back(instruction);
+    }
+
+    void operator()(const AnyExpression& e) { compound(FilterProgram::Op::Any, e.expressions); }
+    void operator()(const AllExpression& e) { compound(FilterProgram::Op::All, e.expressions); }
+    void operator()(const NoneExpression& e) { compound(FilterProgram::Op::None, e.expressions); }
+
+    template <class E>
+    void operator()(const E& e) {
+        FilterProgram::Instruction instruction;
+        instruction.expression = &expression;
+
+        if (e.key == "$type") {
+            instruction.op = FilterProgram::Op::Type;
+            for (uint32_t type = 0; type < 32; ++type) {
+                if (evaluateConstant(expression, Value(uint64_t(type)))) {
+                    instruction.offset |= 1u << type;
+                }
+            }
+            program.instructions.push_back(instruction);
+            return;
+        }
+
+        const mapbox::util::optional<Value> missing;
+        instruction.result = evaluateConstant(expression, missing);
+
+        auto it = keys.find(e.key);
+        if (it == keys.end()) {
+            // No feature in this layer can have this key.
+            instruction.op = FilterProgram::Op::Const;
+            program.instructions.push_back(instruction);
+            return;
+        }
+
+        auto& slot = program.slots[it->second];
+        if (slot == FilterProgram::noValue) {
+            slot = program.slotValues.size();
+            program.slotValues.push_back(FilterProgram::noValue);
+        }
+
+        instruction.op = FilterProgram::Op::Test;
+        instruction.slot = slot;
+        instruction.offset = program.tables.size();
+        program.tables.resize(program.tables.size() + program.values.size(), -1);
+        program.instructions.push_back(instruction);
+    }
+
+private:
+    void compound(FilterProgram::Op op, const std::vector<FilterExpression>& expressions) {
+        const std::size_t index = program.instructions.size();
+
+        FilterProgram::Instruction instruction;
+        instruction.op = op;
+        program.instructions.push_back(instruction);
+
+        for (const auto& child : expressions) {
+            FilterProgramCompiler compiler(program, keys, child);
+            mapbox::util::apply_visitor(compiler, child);
+        }
+
+        program.instructions[index].size = program.instructions.size() - index;
+    }
+
+    FilterProgram& program;
+    const std::unordered_map<std::string, uint32_t>& keys;
+    const FilterExpression& expression;
+};
+
+const uint32_t FilterProgram::noValue;
+
+FilterProgram::FilterProgram(const FilterExpression& expression,
+                             const std::unordered_map<std::string, uint32_t>& keys,
+                             const std::vector<Value>& values_)
+    : values(values_),
+      slots(keys.size(), noValue) {
+    FilterProgramCompiler compiler(*this, keys, expression);
+    mapbox::util::apply_visitor(compiler, expression);
+}
+
+bool FilterProgram::evaluate(FeatureType type, const uint32_t* tags, std::size_t count) const {
+    std::fill(slotValues.begin(), slotValues.end(), noValue);
+
+    if (!slotValues.empty()) {
+        for (std::size_t i = 0; i + 1 < count; i += 2) {
+            const uint32_t key = tags[i];
+            if (key < slots.size() && slots[key] != noValue) {
+                // Like getValue(), use the first occurrence of a key.
+                uint32_t& value = slotValues[slots[key]];
+                if (value == noValue) {
+                    value = tags[i + 1];
+                }
+            }
+        }
+    }
+
+    std::size_t pc = 0;
+    return run(pc, type);
+}
+
+bool FilterProgram::run(std::size_t& pc, FeatureType type) const {
+    const Instruction& instruction = instructions[pc];
+    const std::size_t end = pc + instruction.size;
+    ++pc;
+
+    switch (instruction.op) {
+    case Op::Const:
+        return instruction.result;
+
+    case Op::Type:
+        if (uint8_t(type) < 32) {
+            return instruction.offset & (1u << uint8_t(type));
+        } else {
+            return evaluateConstant(*instruction.expression, Value(uint64_t(type)));
+        }
+
+    case Op::Test: {
+        const uint32_t value = slotValues[instruction.slot];
+        return value == noValue ? instruction.result : test(instruction, value);
+    }
+
+    case Op::Any:
+        while (pc < end) {
+            if (run(pc, type)) {
+                pc = end;
+                return true;
+            }
+        }
+        return false;
+
+    case Op::All:
+        while (pc < end) {
+            if (!run(pc, type)) {
+                pc = end;
+                return false;
+            }
+        }
+        return true;
+
+    case Op::None:
+        while (pc < end) {
+            if (run(pc, type)) {
+                pc = end;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    return false;
+}
+
+bool FilterProgram::test(const Instruction& instruction, uint32_t value) const {
+    if (value >= values.size()) {
+        return false;
+    }
+
+    int8_t& result = tables[instruction.offset + value];
+    if (result < 0) {
+        result = evaluateConstant(*instruction.expression, values[value]);
+    }
+    return result;
+}
+
+}
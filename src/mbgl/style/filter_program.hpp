@@ -0,0 +1,73 @@
+#ifndef MBGL_STYLE_FILTER_PROGRAM
+#define MBGL_STYLE_FILTER_PROGRAM
+
+#include <mbgl/style/filter_expression.hpp>
+#include <mbgl/map/geometry_tile.hpp>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mbgl {
+
+// A FilterExpression compiled against the key and value tables of a single
+// vector tile layer. Keys are resolved to key indices at compile time, and the
+// result of every comparison is memoized per value index, so that evaluating
+// a feature only takes a single pass over its key/value index pairs.
+//
+// Programs keep references to the expression and the value table they were
+// compiled from, and are meant to be used by a single thread.
+class FilterProgram : private util::noncopyable {
+public:
+    FilterProgram(const FilterExpression&,
+                  const std::unordered_map<std::string, uint32_t>& keys,
+                  const std::vector<Value>& values);
+
+    // Evaluates the program for a feature whose tags are given as `count`
+    // consecutive key index/value index pairs.
+    bool evaluate(FeatureType, const uint32_t* tags, std::size_t count) const;
+
+    static const uint32_t noValue = uint32_t(-1);
+
+private:
+    enum class Op : uint8_t {
+        Const,  // Always yields `result`.
+        Type,   // Tests the feature type against the bit mask in `offset`.
+        Test,   // Looks up the value of `slot` in the table at `offset`.
+        Any,
+        All,
+        None
+    };
+
+    struct Instruction {
+        Op op;
+        bool result = false;
+        uint32_t slot = 0;
+        uint32_t offset = 0;
+        // Number of instructions in the subtree rooted here, including this one.
+        uint32_t size = 1;
+        const FilterExpression* expression = nullptr;
+    };
+
+    friend class FilterProgramCompiler;
+
+    bool run(std::size_t& pc, FeatureType) const;
+    bool test(const Instruction&, uint32_t value) const;
+
+    const std::vector<Value>& values;
+    std::vector<Instruction> instructions;
+
+    // Maps key indices to slots. Only keys referenced by the filter get a slot.
+    std::vector<uint32_t> slots;
+
+    // Memoized comparison results per value index; -1 if not computed yet.
+    mutable std::vector<int8_t> tables;
+
+    // Value index per slot for the feature currently being evaluated.
+    mutable std::vector<uint32_t> slotValues;
+};
+
+}
+
+#endif
@@ -20,6 +20,7 @@ template <> inline TranslateAnchorType defaultStopsValue() { return {}; };
 template <> inline RotateAnchorType defaultStopsValue() { return {}; };
 template <> inline CapType defaultStopsValue() { return {}; };
 template <> inline JoinType defaultStopsValue() { return {}; };
+template <> inline TriangulationType defaultStopsValue() { return {}; };
 template <> inline PlacementType defaultStopsValue() { return {}; };
 template <> inline TextAnchorType defaultStopsValue() { return {}; };
 template <> inline TextJustifyType defaultStopsValue() { return {}; };
@@ -84,6 +85,7 @@ template TranslateAnchorType StopsFunction<TranslateAnchorType>::evaluate(float
 template RotateAnchorType StopsFunction<RotateAnchorType>::evaluate(float z) const;
 template CapType StopsFunction<CapType>::evaluate(float z) const;
 template JoinType StopsFunction<JoinType>::evaluate(float z) const;
+template TriangulationType StopsFunction<TriangulationType>::evaluate(float z) const;
 template PlacementType StopsFunction<PlacementType>::evaluate(float z) const;
 template TextAnchorType StopsFunction<TextAnchorType>::evaluate(float z) const;
 template TextJustifyType StopsFunction<TextJustifyType>::evaluate(float z) const;
@@ -51,6 +51,8 @@ const std::map<PropertyKey, PropertyValue> PropertyFallbackValue::properties = {
     { PropertyKey::BackgroundOpacity, defaultStyleProperties<BackgroundProperties>().opacity },
     { PropertyKey::BackgroundColor, defaultStyleProperties<BackgroundProperties>().color },
 
+    { PropertyKey::FillTriangulation, defaultStyleLayout<StyleLayoutFill>().triangulation },
+
     { PropertyKey::LineCap, defaultStyleLayout<StyleLayoutLine>().cap },
     { PropertyKey::LineJoin, defaultStyleLayout<StyleLayoutLine>().join },
     { PropertyKey::LineMiterLimit, defaultStyleLayout<StyleLayoutLine>().miter_limit },
@@ -12,6 +12,8 @@ enum class PropertyKey {
     FillTranslateAnchor,
     FillImage,
 
+    FillTriangulation,
+
     LineOpacity,
     LineColor,
     LineTranslate, // for transitions only
@@ -17,6 +17,7 @@ typedef mapbox::util::variant<
     Function<RotateAnchorType>,
     Function<CapType>,
     Function<JoinType>,
+    Function<TriangulationType>,
     VisibilityType,
     Function<PlacementType>,
     Function<RotationAlignmentType>,
@@ -15,6 +15,11 @@ public:
     StyleLayoutFill& operator=(StyleLayoutFill &&) = default;
     StyleLayoutFill(const StyleLayoutFill &) = delete;
     StyleLayoutFill& operator=(const StyleLayoutFill &) = delete;
+
+    // Set with the "fill-triangulation" layout property. Polygons that earcut can't triangulate
+    // cleanly are always unioned and tessellated instead; "tessellator" does that for every
+    // polygon, for comparison.
+    TriangulationType triangulation = TriangulationType::Earcut;
 };
 
 class StyleLayoutLine {
@@ -522,6 +522,15 @@ template<> std::tuple<bool, JoinType> StyleParser::parseProperty<JoinType>(JSVal
     return std::tuple<bool, JoinType> { true, JoinTypeClass({ value.GetString(), value.GetStringLength() }) };
 }
 
+template<> std::tuple<bool, TriangulationType> StyleParser::parseProperty<TriangulationType>(JSVal value, const char *property_name) {
+    if (!value.IsString()) {
+        Log::Warning(Event::ParseStyle, "value of '%s' must be a string", property_name);
+        return std::tuple<bool, TriangulationType> { false, TriangulationType::Earcut };
+    }
+
+    return std::tuple<bool, TriangulationType> { true, TriangulationTypeClass({ value.GetString(), value.GetStringLength() }) };
+}
+
 template<> std::tuple<bool, PlacementType> StyleParser::parseProperty<PlacementType>(JSVal value, const char *property_name) {
     if (!value.IsString()) {
         Log::Warning(Event::ParseStyle, "value of '%s' must be a string", property_name);
@@ -609,6 +618,10 @@ template<> std::tuple<bool, Function<JoinType>> StyleParser::parseProperty(JSVal
     return parseFunction<JoinType>(value, property_name);
 }
 
+template<> std::tuple<bool, Function<TriangulationType>> StyleParser::parseProperty(JSVal value, const char *property_name) {
+    return parseFunction<TriangulationType>(value, property_name);
+}
+
 template<> std::tuple<bool, Function<PlacementType>> StyleParser::parseProperty(JSVal value, const char *property_name) {
     return parseFunction<PlacementType>(value, property_name);
 }
@@ -879,6 +892,8 @@ void StyleParser::parseLayout(JSVal value, util::ptr<StyleBucket> &bucket) {
 
     parseVisibility<VisibilityType>(*bucket, value);
 
+    parseOptionalProperty<Function<TriangulationType>>("fill-triangulation", Key::FillTriangulation, bucket->layout, value);
+
     parseOptionalProperty<Function<CapType>>("line-cap", Key::LineCap, bucket->layout, value);
     parseOptionalProperty<Function<JoinType>>("line-join", Key::LineJoin, bucket->layout, value);
     parseOptionalProperty<Function<float>>("line-miter-limit", Key::LineMiterLimit, bucket->layout, value);
@@ -1,6 +1,9 @@
 #include <mbgl/style/style_source.hpp>
 #include <mbgl/platform/platform.hpp>
 #include <mbgl/platform/log.hpp>
+#include <mbgl/util/mapbox.hpp>
+#include <mbgl/util/string.hpp>
+#include <mbgl/util/token.hpp>
 
 #include <limits>
 
@@ -74,4 +77,27 @@ void SourceInfo::parseTileJSONProperties(const rapidjson::Value& value) {
     parse(value, bounds, "bounds");
 }
 
+std::string SourceInfo::tileURL(const Tile::ID& id, float pixelRatio) const {
+    if (tiles.empty()) {
+        return "";
+    }
+
+    std::string result = tiles[(id.x + id.y) % tiles.size()];
+    result = util::mapbox::normalizeTileURL(result, url, type);
+    result = util::replaceTokens(result, [&](const std::string &token) -> std::string {
+        if (token == "z") return util::toString(id.z);
+        if (token == "x") return util::toString(id.x);
+        if (token == "y") return util::toString(id.y);
+        if (token == "prefix") {
+            std::string prefix { 2 };
+            prefix[0] = "0123456789abcdef"[id.x % 16];
+            prefix[1] = "0123456789abcdef"[id.y % 16];
+            return prefix;
+        }
+        if (token == "ratio") return pixelRatio > 1.0 ? "@2x" : "";
+        return "";
+    });
+    return result;
+}
+
 }
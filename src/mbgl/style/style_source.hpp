@@ -2,6 +2,7 @@
 #define MBGL_STYLE_STYLE_SOURCE
 
 #include <mbgl/style/types.hpp>
+#include <mbgl/map/tile.hpp>
 #include <mbgl/util/ptr.hpp>
 #include <mbgl/util/noncopyable.hpp>
 #include <rapidjson/document.h>
@@ -26,6 +27,9 @@ public:
     std::array<float, 4> bounds = {{-180, -90, 180, 90}};
 
     void parseTileJSONProperties(const rapidjson::Value&);
+
+    // Expands the tile URL template for a tile; returns an empty string if there are no tiles.
+    std::string tileURL(const Tile::ID& id, float pixelRatio) const;
 };
 
 
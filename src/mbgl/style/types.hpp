@@ -88,6 +88,18 @@ MBGL_DEFINE_ENUM_CLASS(CapTypeClass, CapType, {
 
 // -------------------------------------------------------------------------------------------------
 
+enum class TriangulationType : bool {
+    Earcut,
+    Tessellator,
+};
+
+MBGL_DEFINE_ENUM_CLASS(TriangulationTypeClass, TriangulationType, {
+    { TriangulationType::Earcut, "earcut" },
+    { TriangulationType::Tessellator, "tessellator" },
+});
+
+// -------------------------------------------------------------------------------------------------
+
 enum class JoinType : uint8_t {
     Miter,
     Bevel,
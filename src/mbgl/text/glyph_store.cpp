@@ -11,6 +11,7 @@
 #include <mbgl/util/math.hpp>
 #include <mbgl/storage/file_source.hpp>
 #include <mbgl/platform/platform.hpp>
+#include <mbgl/platform/log.hpp>
 #include <mbgl/util/uv_detail.hpp>
 #include <algorithm>
 
@@ -141,8 +142,10 @@ void FontStack::lineWrap(Shaping &shaping, const float lineHeight, const float m
 GlyphPBF::GlyphPBF(const std::string &glyphURL,
                    const std::string &fontStack,
                    GlyphRange glyphRange,
-                   Environment &env)
-    : future(promise.get_future().share()) {
+                   Environment &env_,
+                   std::function<void()> callback)
+    : env(env_),
+      loaded(false) {
     // Load the glyph set URL
     std::string url = util::replaceTokens(glyphURL, [&](const std::string &name) -> std::string {
         if (name == "fontstack") return util::percentEncode(fontStack);
@@ -150,39 +153,57 @@ GlyphPBF::GlyphPBF(const std::string &glyphURL,
         return "";
     });
 
-    // The prepare call jumps back to the main thread.
-    env.requestAsync({ Resource::Kind::Glyphs, url }, [&, url](const Response &res) {
+    req = env.request({ Resource::Kind::Glyphs, url }, [&, url, callback](const Response &res) {
+        req = nullptr;
+
         if (res.status != Response::Successful) {
-            // Something went wrong with loading the glyph pbf. Pass on the error to the future listeners.
-            const std::string msg = std::string { "[ERROR] failed to load glyphs: " } + res.message;
-            promise.set_exception(std::make_exception_ptr(std::runtime_error(msg)));
+            // Something went wrong with loading the glyph pbf. Mark the range as loaded anyway so
+            // that tiles waiting for it don't wait forever; its glyphs will be missing. The store
+            // requests it again for later tiles once the retry delay has passed.
+            Log::Error(Event::ParseTile, "Failed to load glyphs %s: %s", url.c_str(), res.message.c_str());
+            std::lock_guard<std::mutex> lock(mtx);
+            failed = true;
+            failedAt = std::chrono::steady_clock::now();
         } else {
             // Transfer the data to the GlyphSet and signal its availability.
             // Once it is available, the caller will need to call parse() to actually
-            // parse the data we received. We are not doing this here since this callback is being
-            // called from another (unknown) thread.
+            // parse the data we received. We are not doing this here since parsing
+            // should happen on a worker thread.
+            std::lock_guard<std::mutex> lock(mtx);
             data = res.data;
-            promise.set_value(*this);
         }
+
+        loaded = true;
+        callback();
     });
 }
 
+GlyphPBF::~GlyphPBF() {
+    if (req) {
+        env.cancelRequest(req);
+    }
+}
 
-std::shared_future<GlyphPBF &> GlyphPBF::getFuture() {
-    return future;
+bool GlyphPBF::isLoaded() const {
+    return loaded;
+}
+
+bool GlyphPBF::isRetryable(std::chrono::steady_clock::duration delay) const {
+    std::lock_guard<std::mutex> lock(mtx);
+    return failed && std::chrono::steady_clock::now() - failedAt >= delay;
 }
 
 void GlyphPBF::parse(FontStack &stack) {
     std::lock_guard<std::mutex> lock(mtx);
 
-    if (!data.size()) {
+    if (!data || data->empty()) {
         // If there is no data, this means we either haven't received any data, or
         // we have already parsed the data.
         return;
     }
 
     // Parse the glyph PBF
-    pbf glyphs_pbf(reinterpret_cast<const uint8_t *>(data.data()), data.size());
+    pbf glyphs_pbf(reinterpret_cast<const uint8_t *>(data->data()), data->size());
 
     while (glyphs_pbf.next()) {
         if (glyphs_pbf.tag == 1) { // stacks
@@ -223,7 +244,7 @@ void GlyphPBF::parse(FontStack &stack) {
         }
     }
 
-    data.clear();
+    data.reset();
 }
 
 GlyphStore::GlyphStore(Environment& env_) : env(env_), mtx(util::make_unique<uv::mutex>()) {}
@@ -232,46 +253,68 @@ void GlyphStore::setURL(const std::string &url) {
     glyphURL = url;
 }
 
+void GlyphStore::setRetryDelay(std::chrono::steady_clock::duration delay) {
+    retryDelay = delay;
+}
+
 
-void GlyphStore::waitForGlyphRanges(const std::string &fontStack, const std::set<GlyphRange> &glyphRanges) {
-    // We are implementing a blocking wait with futures: Every GlyphSet has a future that we are
-    // waiting for until it is loaded.
+bool GlyphStore::hasGlyphRanges(const std::string &fontStack, const std::set<GlyphRange> &glyphRanges) {
     if (glyphRanges.empty()) {
-        return;
+        return true;
     }
 
-    uv::exclusive<FontStack> stack(mtx);
+    uv::lock lock(mtx);
 
-    std::vector<std::shared_future<GlyphPBF &>> futures;
-    futures.reserve(glyphRanges.size());
-    {
-        auto &rangeSets = ranges[fontStack];
+    auto &rangeSets = ranges[fontStack];
+    for (const auto range : glyphRanges) {
+        auto range_it = rangeSets.find(range);
+        if (range_it == rangeSets.end() || !range_it->second->isLoaded() ||
+            range_it->second->isRetryable(retryDelay)) {
+            return false;
+        }
+    }
 
-        stack << createFontStack(fontStack);
+    return true;
+}
 
-        // Attempt to load the glyph range. If the GlyphSet already exists, we are getting back
-        // the same shared_future.
-        for (const auto range : glyphRanges) {
-            futures.emplace_back(loadGlyphRange(fontStack, rangeSets, range));
-        }
+void GlyphStore::requestGlyphRanges(const std::string &fontStack, const std::set<GlyphRange> &glyphRanges,
+                                    std::function<void()> callback) {
+    if (glyphRanges.empty()) {
+        return;
     }
 
-    // Now that we potentially created all GlyphSets, we are waiting for the results, one by one.
-    // When we get a result (or the GlyphSet is aready loaded), we are attempting to parse the
-    // GlyphSet.
-    for (const auto& future : futures) {
-        future.get().parse(stack);
+    uv::lock lock(mtx);
+
+    auto &rangeSets = ranges[fontStack];
+    for (const auto range : glyphRanges) {
+        auto range_it = rangeSets.find(range);
+        if (range_it == rangeSets.end()) {
+            // We don't have this glyph set yet for this font stack.
+            rangeSets.emplace(range, util::make_unique<GlyphPBF>(glyphURL, fontStack, range, env, callback));
+        } else if (range_it->second->isRetryable(retryDelay)) {
+            // The last attempt failed. Tiles that were waiting for it went ahead without its
+            // glyphs, so requesting it again doesn't keep them waiting in a loop.
+            range_it->second = util::make_unique<GlyphPBF>(glyphURL, fontStack, range, env, callback);
+        }
     }
 }
 
-std::shared_future<GlyphPBF &> GlyphStore::loadGlyphRange(const std::string &fontStack, std::map<GlyphRange, std::unique_ptr<GlyphPBF>> &rangeSets, const GlyphRange range) {
-    auto range_it = rangeSets.find(range);
-    if (range_it == rangeSets.end()) {
-        // We don't have this glyph set yet for this font stack.
-        range_it = rangeSets.emplace(range, util::make_unique<GlyphPBF>(glyphURL, fontStack, range, env)).first;
+void GlyphStore::parseGlyphRanges(const std::string &fontStack, const std::set<GlyphRange> &glyphRanges) {
+    if (glyphRanges.empty()) {
+        return;
     }
 
-    return range_it->second->getFuture();
+    uv::exclusive<FontStack> stack(mtx);
+    stack << createFontStack(fontStack);
+
+    // Parse the ranges that have arrived. Ranges that were parsed before are skipped.
+    auto &rangeSets = ranges[fontStack];
+    for (const auto range : glyphRanges) {
+        auto range_it = rangeSets.find(range);
+        if (range_it != rangeSets.end() && range_it->second->isLoaded()) {
+            range_it->second->parse(stack);
+        }
+    }
 }
 
 FontStack &GlyphStore::createFontStack(const std::string &fontStack) {
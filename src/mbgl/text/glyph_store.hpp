@@ -6,10 +6,13 @@
 #include <mbgl/util/ptr.hpp>
 #include <mbgl/util/uv.hpp>
 
+#include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <functional>
 #include <vector>
-#include <future>
 #include <map>
+#include <mutex>
 #include <set>
 #include <unordered_map>
 
@@ -17,6 +20,7 @@ namespace mbgl {
 
 class FileSource;
 class Environment;
+class Request;
 
 class SDFGlyph {
 public:
@@ -52,7 +56,9 @@ public:
     GlyphPBF(const std::string &glyphURL,
              const std::string &fontStack,
              GlyphRange glyphRange,
-             Environment &env);
+             Environment &env,
+             std::function<void()> callback);
+    ~GlyphPBF();
 
 private:
     GlyphPBF(const GlyphPBF &) = delete;
@@ -63,13 +69,21 @@ private:
 public:
     void parse(FontStack &stack);
 
-    std::shared_future<GlyphPBF &> getFuture();
+    // Returns true once the request finished, whether it succeeded or not.
+    bool isLoaded() const;
+
+    // Returns true if the request failed more than /delay/ ago, so that the range should be
+    // requested again.
+    bool isRetryable(std::chrono::steady_clock::duration delay) const;
 
 private:
-    std::string data;
-    std::promise<GlyphPBF &> promise;
-    std::shared_future<GlyphPBF &> future;
-    std::mutex mtx;
+    Environment &env;
+    Request *req = nullptr;
+    std::shared_ptr<const std::string> data;
+    std::atomic<bool> loaded;
+    bool failed = false;
+    std::chrono::steady_clock::time_point failedAt;
+    mutable std::mutex mtx;
 };
 
 // Manages Glyphrange PBF loading.
@@ -77,20 +91,32 @@ class GlyphStore {
 public:
     GlyphStore(Environment &);
 
-    // Block until all specified GlyphRanges of the specified font stack are loaded.
-    void waitForGlyphRanges(const std::string &fontStack, const std::set<GlyphRange> &glyphRanges);
+    // Returns true if all specified GlyphRanges of the specified font stack have been loaded.
+    // A range that failed to load counts as loaded until it's due for another attempt.
+    // Never blocks.
+    bool hasGlyphRanges(const std::string &fontStack, const std::set<GlyphRange> &glyphRanges);
+
+    // Starts loading the specified GlyphRanges that haven't been requested yet, or that failed
+    // to load at least the retry delay ago. The callback is called on the map thread whenever
+    // one of them arrives. Must be called on the map thread.
+    void requestGlyphRanges(const std::string &fontStack, const std::set<GlyphRange> &glyphRanges,
+                            std::function<void()> callback);
+
+    // Adds the glyphs of all specified GlyphRanges that have been loaded to the font stack.
+    void parseGlyphRanges(const std::string &fontStack, const std::set<GlyphRange> &glyphRanges);
 
     uv::exclusive<FontStack> getFontStack(const std::string &fontStack);
 
     void setURL(const std::string &url);
 
-private:
-    // Loads an individual glyph range from the font stack and adds it to rangeSets
-    std::shared_future<GlyphPBF &> loadGlyphRange(const std::string &fontStack, std::map<GlyphRange, std::unique_ptr<GlyphPBF>> &rangeSets, GlyphRange range);
+    // Sets how long a range that failed to load is left alone before it's requested again.
+    void setRetryDelay(std::chrono::steady_clock::duration delay);
 
+private:
     FontStack &createFontStack(const std::string &fontStack);
 
     std::string glyphURL;
+    std::chrono::steady_clock::duration retryDelay = std::chrono::seconds(30);
     Environment &env;
     std::unordered_map<std::string, std::map<GlyphRange, std::unique_ptr<GlyphPBF>>> ranges;
     std::unordered_map<std::string, std::unique_ptr<FontStack>> stacks;
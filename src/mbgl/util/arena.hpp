@@ -0,0 +1,96 @@
+#ifndef MBGL_UTIL_ARENA
+#define MBGL_UTIL_ARENA
+
+#include <mbgl/util/noncopyable.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace mbgl {
+namespace util {
+
+// Bump allocator for many small arrays of the same type that share a common
+// lifetime. Memory is handed out from large chunks and only released when the
+// arena is destroyed; pointers to committed arrays stay valid until then.
+//
+// Arrays are built by appending to the open allocation with push() and are
+// finalized with commit(). When the current chunk runs out of space, the open
+// allocation moves to a new chunk, so only committed arrays are stable.
+template <typename T>
+class Arena : private util::noncopyable {
+public:
+    Arena(std::size_t chunkSize_ = 4096) : chunkSize(chunkSize_) {}
+
+    inline void push(const T& value) {
+        if (chunks.empty() || chunks.back().size() == chunks.back().capacity()) {
+            grow();
+        }
+        chunks.back().push_back(value);
+    }
+
+    // Returns the number of items in the open allocation.
+    inline std::size_t pending() const {
+        return chunks.empty() ? 0 : chunks.back().size() - start;
+    }
+
+    // Returns the open allocation. It is not stable until it has been committed.
+    inline T* open() {
+        return chunks.empty() ? nullptr : chunks.back().data() + start;
+    }
+
+    inline T& operator[](std::size_t i) {
+        return open()[i];
+    }
+
+    // Finalizes the open allocation and returns a pointer to it.
+    inline T* commit() {
+        T* result = open();
+        if (!chunks.empty()) {
+            start = chunks.back().size();
+        }
+        return result;
+    }
+
+    // Drops the open allocation.
+    inline void discard() {
+        if (!chunks.empty()) {
+            auto& chunk = chunks.back();
+            chunk.erase(chunk.begin() + start, chunk.end());
+        }
+    }
+
+    // Returns the number of items allocated from this arena, including unused chunk space.
+    inline std::size_t capacity() const {
+        std::size_t total = 0;
+        for (const auto& chunk : chunks) {
+            total += chunk.capacity();
+        }
+        return total;
+    }
+
+private:
+    void grow() {
+        const std::size_t count = pending();
+        std::vector<T> chunk;
+        chunk.reserve(std::max(chunkSize, count * 2));
+        if (count) {
+            auto& previous = chunks.back();
+            chunk.insert(chunk.end(), previous.begin() + start, previous.end());
+            previous.erase(previous.begin() + start, previous.end());
+        }
+        chunks.push_back(std::move(chunk));
+        start = 0;
+    }
+
+    const std::size_t chunkSize;
+    std::vector<std::vector<T>> chunks;
+
+    // Offset of the open allocation in the last chunk.
+    std::size_t start = 0;
+};
+
+}
+}
+
+#endif
@@ -2,6 +2,14 @@
 
 #include <zlib.h>
 
+#ifdef MBGL_USE_LZ4
+#include <lz4.h>
+#endif
+
+#include <pthread.h>
+
+#include <algorithm>
+#include <cstdint>
 #include <cstring>
 #include <stdexcept>
 
@@ -23,74 +31,233 @@ const static bool zlibVersionCheck = []() {
 namespace mbgl {
 namespace util {
 
-std::string compress(const std::string &raw) {
-    z_stream deflate_stream;
-    memset(&deflate_stream, 0, sizeof(deflate_stream));
+namespace {
+
+// Setting up a z_stream allocates its window and state, so every thread keeps its streams and
+// only resets them between uses.
+class Streams {
+public:
+    static Streams &Get() {
+        static pthread_once_t store_once = PTHREAD_ONCE_INIT;
+        static pthread_key_t store_key;
+
+        // Create the key.
+        pthread_once(&store_once, []() {
+            pthread_key_create(&store_key, [](void *ptr) {
+                delete reinterpret_cast<Streams *>(ptr);
+            });
+        });
 
-    // TODO: reuse z_streams
-    if (deflateInit(&deflate_stream, Z_DEFAULT_COMPRESSION) != Z_OK) {
-        throw std::runtime_error("failed to initialize deflate");
+        Streams *ptr = reinterpret_cast<Streams *>(pthread_getspecific(store_key));
+        if (ptr == nullptr) {
+            ptr = new Streams();
+            pthread_setspecific(store_key, ptr);
+        }
+
+        return *ptr;
     }
 
-    deflate_stream.next_in = (Bytef *)raw.data();
-    deflate_stream.avail_in = uInt(raw.size());
+    ~Streams() {
+        if (inflateReady) {
+            inflateEnd(&inflater);
+        }
+        for (int i = 0; i < 2; i++) {
+            if (deflateReady[i]) {
+                deflateEnd(&deflaters[i]);
+            }
+        }
+    }
 
-    std::string result;
-    char out[16384];
+    z_stream &inflateStream() {
+        if (!inflateReady) {
+            memset(&inflater, 0, sizeof(inflater));
+            // Adding 32 to the window bits detects both zlib and gzip headers.
+            if (inflateInit2(&inflater, MAX_WBITS + 32) != Z_OK) {
+                throw std::runtime_error("failed to initialize inflate");
+            }
+            inflateReady = true;
+        } else {
+            inflateReset(&inflater);
+        }
+        return inflater;
+    }
 
-    int code;
-    do {
-        deflate_stream.next_out = reinterpret_cast<Bytef *>(out);
-        deflate_stream.avail_out = sizeof(out);
-        code = deflate(&deflate_stream, Z_FINISH);
-        if (result.size() < deflate_stream.total_out) {
-            // append the block to the output string
-            result.append(out, deflate_stream.total_out - result.size());
+    z_stream &deflateStream(bool gzip) {
+        z_stream &stream = deflaters[gzip];
+        if (!deflateReady[gzip]) {
+            memset(&stream, 0, sizeof(stream));
+            // Adding 16 to the window bits writes a gzip header and trailer instead of zlib ones.
+            if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + (gzip ? 16 : 0),
+                             8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                throw std::runtime_error("failed to initialize deflate");
+            }
+            deflateReady[gzip] = true;
+        } else {
+            deflateReset(&stream);
         }
-    } while (code == Z_OK);
+        return stream;
+    }
 
-    deflateEnd(&deflate_stream);
+    // Output of unknown size goes here first, so that the result doesn't keep a worst case or
+    // doubled capacity.
+    std::string buffer;
 
-    if (code != Z_STREAM_END) {
-        throw std::runtime_error(deflate_stream.msg);
+    // Frees the buffer after it grew for an unusually large input, so that every thread doesn't
+    // keep the largest size it ever needed.
+    void trimBuffer() {
+        if (buffer.size() > maxBufferSize) {
+            std::string().swap(buffer);
+        }
+    }
+    static const std::size_t maxBufferSize = 1 << 20;
+
+private:
+    z_stream inflater;
+    z_stream deflaters[2];
+    bool inflateReady = false;
+    bool deflateReady[2] = { false, false };
+};
+
+// Sizes are stored little endian, like the one in the gzip trailer.
+uint32_t readSize(const char *src) {
+    const auto bytes = reinterpret_cast<const uint8_t *>(src);
+    return uint32_t(bytes[0]) | uint32_t(bytes[1]) << 8 | uint32_t(bytes[2]) << 16 |
+           uint32_t(bytes[3]) << 24;
+}
+
+#ifdef MBGL_USE_LZ4
+void writeSize(char *dst, uint32_t size) {
+    for (int i = 0; i < 4; i++) {
+        dst[i] = char((size >> (8 * i)) & 0xFF);
+    }
+}
+#endif
+
+}
+
+std::string compress(const std::string &raw, bool gzip) {
+    Streams &streams = Streams::Get();
+    z_stream &deflate_stream = streams.deflateStream(gzip);
+
+    // With room for the worst case, a single call finishes the stream.
+    const std::size_t bound = deflateBound(&deflate_stream, uLong(raw.size()));
+    if (streams.buffer.size() < bound) {
+        streams.buffer.resize(bound);
     }
 
+    deflate_stream.next_in = (Bytef *)raw.data();
+    deflate_stream.avail_in = uInt(raw.size());
+    deflate_stream.next_out = reinterpret_cast<Bytef *>(&streams.buffer[0]);
+    deflate_stream.avail_out = uInt(bound);
+
+    const int code = deflate(&deflate_stream, Z_FINISH);
+    std::string result;
+    if (code == Z_STREAM_END) {
+        result.assign(streams.buffer.data(), std::size_t(deflate_stream.total_out));
+    }
+    streams.trimBuffer();
+
+    if (code != Z_STREAM_END) {
+        throw std::runtime_error(deflate_stream.msg ? deflate_stream.msg : "compression error");
+    }
     return result;
 }
 
 std::string decompress(const std::string &raw) {
-    z_stream inflate_stream;
-    memset(&inflate_stream, 0, sizeof(inflate_stream));
+    return decompress(raw.data(), raw.size());
+}
 
-    // TODO: reuse z_streams
-    if (inflateInit(&inflate_stream) != Z_OK) {
-        throw std::runtime_error("failed to initialize inflate");
-    }
+std::string decompress(const char *raw, std::size_t size, std::size_t sizeHint) {
+    Streams &streams = Streams::Get();
+    z_stream &inflate_stream = streams.inflateStream();
 
-    inflate_stream.next_in = (Bytef *)raw.data();
-    inflate_stream.avail_in = uInt(raw.size());
+    std::size_t expected = sizeHint;
+    if (!expected && size >= 18 && uint8_t(raw[0]) == 0x1F && uint8_t(raw[1]) == 0x8B) {
+        // The gzip trailer ends with the uncompressed size modulo 2^32.
+        expected = readSize(raw + size - 4);
+    }
 
+    // With a known size, we inflate straight into the result. Don't trust the size blindly:
+    // deflate doesn't compress better than about 1:1032. The extra byte lets inflate() read the
+    // trailer without running out of output space first. Otherwise, we inflate into the thread's
+    // buffer, which keeps its size across calls, and copy the result out.
     std::string result;
-    char out[15384];
+    std::string &output = expected ? result : streams.buffer;
+    if (expected) {
+        result.resize(std::min(expected, size * 1032 + 1024) + 1);
+    } else if (output.size() < std::max<std::size_t>(size * 4, 16384)) {
+        output.resize(std::max<std::size_t>(size * 4, 16384));
+    }
+
+    inflate_stream.next_in = (Bytef *)raw;
+    inflate_stream.avail_in = uInt(size);
 
     int code;
     do {
-        inflate_stream.next_out = reinterpret_cast<Bytef *>(out);
-        inflate_stream.avail_out = sizeof(out);
-        code = inflate(&inflate_stream, 0);
-        // result.append(out, sizeof(out) - inflate_stream.avail_out);
-        if (result.size() < inflate_stream.total_out) {
-            result.append(out, inflate_stream.total_out - result.size());
+        if (inflate_stream.total_out == output.size()) {
+            output.resize(output.size() * 2);
         }
+        inflate_stream.next_out = reinterpret_cast<Bytef *>(&output[inflate_stream.total_out]);
+        inflate_stream.avail_out = uInt(output.size() - inflate_stream.total_out);
+        code = inflate(&inflate_stream, Z_NO_FLUSH);
     } while (code == Z_OK);
 
-    inflateEnd(&inflate_stream);
+    if (code == Z_STREAM_END) {
+        if (expected) {
+            result.resize(inflate_stream.total_out);
+        } else {
+            result.assign(output.data(), std::size_t(inflate_stream.total_out));
+        }
+    }
+    streams.trimBuffer();
 
     if (code != Z_STREAM_END) {
         throw std::runtime_error(inflate_stream.msg ? inflate_stream.msg : "decompression error");
     }
+    return result;
+}
 
+#ifdef MBGL_USE_LZ4
+std::string compressLZ4(const std::string &raw) {
+    if (raw.size() > LZ4_MAX_INPUT_SIZE) {
+        throw std::runtime_error("input is too large for LZ4");
+    }
+
+    std::string result(4 + LZ4_compressBound(int(raw.size())), '\0');
+    writeSize(&result[0], uint32_t(raw.size()));
+
+    const int compressed = LZ4_compress_default(raw.data(), &result[4], int(raw.size()),
+                                                int(result.size() - 4));
+    if (compressed <= 0) {
+        throw std::runtime_error("LZ4 compression error");
+    }
+
+    result.resize(4 + compressed);
     return result;
 }
+
+std::string decompressLZ4(const char *raw, std::size_t size) {
+    if (size < 4) {
+        throw std::runtime_error("LZ4 data is truncated");
+    }
+
+    // LZ4 doesn't compress better than 1:255, so larger sizes can only come from corrupt data.
+    // Check before allocating the result.
+    const uint32_t expected = readSize(raw);
+    if (expected > uint64_t(size - 4) * 255 + 16) {
+        throw std::runtime_error("LZ4 size is corrupt");
+    }
+
+    std::string result(expected, '\0');
+    const int decompressed = LZ4_decompress_safe(raw + 4, &result[0], int(size - 4),
+                                                 int(result.size()));
+    if (decompressed < 0 || std::size_t(decompressed) != result.size()) {
+        throw std::runtime_error("LZ4 decompression error");
+    }
+
+    return result;
+}
+#endif
+
 }
 }
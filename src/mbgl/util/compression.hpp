@@ -6,8 +6,21 @@
 namespace mbgl {
 namespace util {
 
-std::string compress(const std::string &raw);
+// Deflates with a zlib header, or with a gzip header and trailer. The gzip trailer records the
+// uncompressed size, which lets decompress() allocate its output in one go.
+std::string compress(const std::string &raw, bool gzip = false);
+
+// Inflates zlib and gzip streams. The output is sized from the gzip trailer if there is one, or
+// from sizeHint, e.g. a stored uncompressed length.
 std::string decompress(const std::string &raw);
+std::string decompress(const char *raw, std::size_t size, std::size_t sizeHint = 0);
+
+#ifdef MBGL_USE_LZ4
+// A faster codec for data we write and read ourselves, like cache blobs. The uncompressed size is
+// stored in front of the LZ4 block.
+std::string compressLZ4(const std::string &raw);
+std::string decompressLZ4(const char *raw, std::size_t size);
+#endif
 
 }
 }
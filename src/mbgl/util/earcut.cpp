@@ -0,0 +1,662 @@
+#include <mbgl/util/earcut.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+namespace mbgl {
+namespace util {
+
+struct EarcutNode {
+    // Vertex index and coordinates.
+    uint32_t i;
+    int32_t x;
+    int32_t y;
+
+    // Previous and next vertex in the polygon ring.
+    EarcutNode *prev;
+    EarcutNode *next;
+
+    // Z-order curve value, and previous and next nodes in z-order.
+    int32_t z;
+    EarcutNode *prevZ;
+    EarcutNode *nextZ;
+
+    // Whether this is a hole of a single point that we can't remove.
+    bool steiner;
+};
+
+namespace {
+
+using Node = EarcutNode;
+
+// Polygons with more vertices than this use a z-order hash to find points inside of ears.
+const std::size_t hashThreshold = 80;
+
+// Twice the signed area of a triangle.
+int64_t area(const Node *p, const Node *q, const Node *r) {
+    return int64_t(q->y - p->y) * (r->x - q->x) - int64_t(q->x - p->x) * (r->y - q->y);
+}
+
+bool equals(const Node *p1, const Node *p2) {
+    return p1->x == p2->x && p1->y == p2->y;
+}
+
+// Products of tile coordinates fit into a double's mantissa, so this is exact.
+bool pointInTriangle(double ax, double ay, double bx, double by, double cx, double cy,
+                     double px, double py) {
+    return (cx - px) * (ay - py) - (ax - px) * (cy - py) >= 0 &&
+           (ax - px) * (by - py) - (bx - px) * (ay - py) >= 0 &&
+           (bx - px) * (cy - py) - (cx - px) * (by - py) >= 0;
+}
+
+// Whether the segments p1-q1 and p2-q2 intersect.
+bool intersects(const Node *p1, const Node *q1, const Node *p2, const Node *q2) {
+    if ((equals(p1, q1) && equals(p2, q2)) || (equals(p1, q2) && equals(p2, q1))) {
+        return true;
+    }
+    return (area(p1, q1, p2) > 0) != (area(p1, q1, q2) > 0) &&
+           (area(p2, q2, p1) > 0) != (area(p2, q2, q1) > 0);
+}
+
+// Whether the diagonal a-b intersects any edge of the polygon.
+bool intersectsPolygon(const Node *a, const Node *b) {
+    const Node *p = a;
+    do {
+        if (p->i != a->i && p->next->i != a->i && p->i != b->i && p->next->i != b->i &&
+            intersects(p, p->next, a, b)) {
+            return true;
+        }
+        p = p->next;
+    } while (p != a);
+    return false;
+}
+
+// Whether the diagonal a-b is inside the polygon near a.
+bool locallyInside(const Node *a, const Node *b) {
+    return area(a->prev, a, a->next) < 0
+        ? area(a, b, a->next) >= 0 && area(a, a->prev, b) >= 0
+        : area(a, b, a->prev) < 0 || area(a, a->next, b) < 0;
+}
+
+// Whether the middle of the diagonal a-b is inside the polygon.
+bool middleInside(const Node *a, const Node *b) {
+    const Node *p = a;
+    bool inside = false;
+    const double px = (a->x + b->x) / 2.0;
+    const double py = (a->y + b->y) / 2.0;
+    do {
+        if (((p->y > py) != (p->next->y > py)) && p->next->y != p->y &&
+            (px < double(p->next->x - p->x) * (py - p->y) / (p->next->y - p->y) + p->x)) {
+            inside = !inside;
+        }
+        p = p->next;
+    } while (p != a);
+    return inside;
+}
+
+// Whether a diagonal between a and b can split the polygon in two.
+bool isValidDiagonal(const Node *a, const Node *b) {
+    return a->next->i != b->i && a->prev->i != b->i && !intersectsPolygon(a, b) &&
+           locallyInside(a, b) && locallyInside(b, a) && middleInside(a, b);
+}
+
+Node *insertNode(Node *p, Node *last) {
+    if (!last) {
+        p->prev = p;
+        p->next = p;
+    } else {
+        p->next = last->next;
+        p->prev = last;
+        last->next->prev = p;
+        last->next = p;
+    }
+    return p;
+}
+
+void removeNode(Node *p) {
+    p->next->prev = p->prev;
+    p->prev->next = p->next;
+    if (p->prevZ) {
+        p->prevZ->nextZ = p->nextZ;
+    }
+    if (p->nextZ) {
+        p->nextZ->prevZ = p->prevZ;
+    }
+}
+
+Node *getLeftmost(Node *start) {
+    Node *p = start;
+    Node *leftmost = start;
+    do {
+        if (p->x < leftmost->x) {
+            leftmost = p;
+        }
+        p = p->next;
+    } while (p != start);
+    return leftmost;
+}
+
+// Simon Tatham's linked list merge sort, on the z-order links.
+Node *sortLinked(Node *list) {
+    std::size_t inSize = 1;
+    std::size_t numMerges;
+    do {
+        Node *p = list;
+        Node *tail = nullptr;
+        list = nullptr;
+        numMerges = 0;
+
+        while (p) {
+            numMerges++;
+            Node *q = p;
+            std::size_t pSize = 0;
+            for (std::size_t i = 0; i < inSize; i++) {
+                pSize++;
+                q = q->nextZ;
+                if (!q) {
+                    break;
+                }
+            }
+            std::size_t qSize = inSize;
+
+            while (pSize > 0 || (qSize > 0 && q)) {
+                Node *e;
+                if (pSize != 0 && (qSize == 0 || !q || p->z <= q->z)) {
+                    e = p;
+                    p = p->nextZ;
+                    pSize--;
+                } else {
+                    e = q;
+                    q = q->nextZ;
+                    qSize--;
+                }
+
+                if (tail) {
+                    tail->nextZ = e;
+                } else {
+                    list = e;
+                }
+                e->prevZ = tail;
+                tail = e;
+            }
+
+            p = q;
+        }
+
+        tail->nextZ = nullptr;
+        inSize *= 2;
+    } while (numMerges > 1);
+
+    return list;
+}
+
+}
+
+Earcut::Earcut() = default;
+Earcut::~Earcut() = default;
+
+int64_t Earcut::signedArea(const GeometryLine &ring) {
+    int64_t sum = 0;
+    for (std::size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+        sum += int64_t(ring[j].x - ring[i].x) * (ring[i].y + ring[j].y);
+    }
+    return sum;
+}
+
+bool Earcut::operator()(const std::vector<GeometryLine> &rings, std::vector<uint32_t> &triangles) {
+    triangles.clear();
+    used = 0;
+    size = 0;
+    trianglesArea = 0;
+    output = &triangles;
+
+    if (rings.empty()) {
+        return true;
+    }
+
+    Node *outerNode = linkedList(rings.front(), 0, true);
+    if (!outerNode) {
+        return true;
+    }
+
+    std::size_t vertexCount = 0;
+    int64_t polygonArea = std::abs(signedArea(rings.front()));
+    for (std::size_t r = 0; r < rings.size(); r++) {
+        vertexCount += rings[r].size();
+        if (r > 0) {
+            polygonArea -= std::abs(signedArea(rings[r]));
+        }
+    }
+
+    if (rings.size() > 1) {
+        outerNode = eliminateHoles(rings, outerNode);
+    }
+
+    // Finding points inside of ears is quadratic, so larger polygons sort their points along a
+    // z-order curve and only look at the ones near each ear.
+    if (vertexCount > hashThreshold) {
+        const GeometryLine &outer = rings.front();
+        int32_t maxX = outer[0].x, maxY = outer[0].y;
+        minX = maxX;
+        minY = maxY;
+        for (const auto &point : outer) {
+            minX = std::min<int32_t>(minX, point.x);
+            minY = std::min<int32_t>(minY, point.y);
+            maxX = std::max<int32_t>(maxX, point.x);
+            maxY = std::max<int32_t>(maxY, point.y);
+        }
+        size = std::max(maxX - minX, maxY - minY);
+    }
+
+    earcutLinked(outerNode);
+    output = nullptr;
+
+    return trianglesArea == polygonArea;
+}
+
+Earcut::Node *Earcut::createNode(uint32_t i, int32_t x, int32_t y) {
+    if (used == blocks.size() * blockSize) {
+        blocks.emplace_back(new Node[blockSize]);
+    }
+    Node *node = &blocks[used / blockSize][used % blockSize];
+    used++;
+
+    node->i = i;
+    node->x = x;
+    node->y = y;
+    node->prev = nullptr;
+    node->next = nullptr;
+    node->z = -1;
+    node->prevZ = nullptr;
+    node->nextZ = nullptr;
+    node->steiner = false;
+    return node;
+}
+
+void Earcut::addTriangle(const Node *a, const Node *b, const Node *c) {
+    output->push_back(a->i);
+    output->push_back(b->i);
+    output->push_back(c->i);
+    trianglesArea += std::abs(area(a, b, c));
+}
+
+// Creates a circular doubly linked list from the ring, in the requested winding order.
+Earcut::Node *Earcut::linkedList(const GeometryLine &ring, uint32_t start, bool clockwise) {
+    Node *last = nullptr;
+    if (clockwise == (signedArea(ring) > 0)) {
+        for (std::size_t i = 0; i < ring.size(); i++) {
+            last = insertNode(createNode(start + uint32_t(i), ring[i].x, ring[i].y), last);
+        }
+    } else {
+        for (std::size_t i = ring.size(); i-- > 0;) {
+            last = insertNode(createNode(start + uint32_t(i), ring[i].x, ring[i].y), last);
+        }
+    }
+
+    if (last && equals(last, last->next)) {
+        removeNode(last);
+        last = last->next;
+    }
+
+    return last;
+}
+
+// Removes duplicate and collinear points.
+Earcut::Node *Earcut::filterPoints(Node *start, Node *end) {
+    if (!start) {
+        return start;
+    }
+    if (!end) {
+        end = start;
+    }
+
+    Node *p = start;
+    bool again;
+    do {
+        again = false;
+        if (!p->steiner && (equals(p, p->next) || area(p->prev, p, p->next) == 0)) {
+            removeNode(p);
+            p = end = p->prev;
+            if (p == p->next) {
+                return nullptr;
+            }
+            again = true;
+        } else {
+            p = p->next;
+        }
+    } while (again || p != end);
+
+    return end;
+}
+
+// Links every hole into the outer ring, which produces a single ring without holes.
+Earcut::Node *Earcut::eliminateHoles(const std::vector<GeometryLine> &rings, Node *outerNode) {
+    queue.clear();
+    uint32_t start = uint32_t(rings.front().size());
+    for (std::size_t r = 1; r < rings.size(); r++) {
+        Node *list = linkedList(rings[r], start, false);
+        start += uint32_t(rings[r].size());
+        if (!list) {
+            continue;
+        }
+        if (list == list->next) {
+            list->steiner = true;
+        }
+        queue.push_back(getLeftmost(list));
+    }
+
+    std::sort(queue.begin(), queue.end(), [](const Node *a, const Node *b) { return a->x < b->x; });
+
+    // Process holes from left to right.
+    for (Node *hole : queue) {
+        if (!outerNode) {
+            break;
+        }
+        eliminateHole(hole, outerNode);
+        outerNode = filterPoints(outerNode, outerNode->next);
+    }
+
+    return outerNode;
+}
+
+// Finds a bridge between the hole and the outer ring and links them.
+void Earcut::eliminateHole(Node *hole, Node *outerNode) {
+    outerNode = findHoleBridge(hole, outerNode);
+    if (outerNode) {
+        Node *b = splitPolygon(outerNode, hole);
+        filterPoints(b, b->next);
+    }
+}
+
+// David Eberly's algorithm for finding a bridge between a hole and the outer polygon.
+Earcut::Node *Earcut::findHoleBridge(Node *hole, Node *outerNode) {
+    Node *p = outerNode;
+    const int32_t hx = hole->x;
+    const int32_t hy = hole->y;
+    double qx = -std::numeric_limits<double>::infinity();
+    Node *m = nullptr;
+
+    // Find a segment intersected by a ray from the hole's leftmost point to the left. The segment's
+    // endpoint with lesser x will be the potential connection point.
+    do {
+        if (hy <= p->y && hy >= p->next->y && p->next->y != p->y) {
+            const double x = p->x + double(hy - p->y) * (p->next->x - p->x) / (p->next->y - p->y);
+            if (x <= hx && x > qx) {
+                qx = x;
+                if (x == hx) {
+                    if (hy == p->y) {
+                        return p;
+                    }
+                    if (hy == p->next->y) {
+                        return p->next;
+                    }
+                }
+                m = p->x < p->next->x ? p : p->next;
+            }
+        }
+        p = p->next;
+    } while (p != outerNode);
+
+    if (!m) {
+        return nullptr;
+    }
+
+    if (hx == qx) {
+        // The hole touches the outer segment; pick its lower endpoint.
+        return m->prev;
+    }
+
+    // Look for points inside the triangle of the hole point, the segment intersection and the
+    // endpoint. If there are none, that endpoint is the connection point. Otherwise, use the point
+    // with the smallest angle to the ray.
+    const Node *stop = m;
+    const int32_t mx = m->x;
+    const int32_t my = m->y;
+    double tanMin = std::numeric_limits<double>::infinity();
+
+    p = m->next;
+    while (p != stop) {
+        if (hx >= p->x && p->x >= mx && hx != p->x &&
+            pointInTriangle(hy < my ? hx : qx, hy, mx, my, hy < my ? qx : hx, hy, p->x, p->y)) {
+            const double tan = double(std::abs(hy - p->y)) / (hx - p->x);
+            if ((tan < tanMin || (tan == tanMin && p->x > m->x)) && locallyInside(p, hole)) {
+                m = p;
+                tanMin = tan;
+            }
+        }
+        p = p->next;
+    }
+
+    return m;
+}
+
+// Main ear slicing loop which triangulates a polygon given as a linked list.
+void Earcut::earcutLinked(Node *ear, int pass) {
+    if (!ear) {
+        return;
+    }
+
+    // Interlink the polygon nodes in z-order.
+    if (!pass && size) {
+        indexCurve(ear);
+    }
+
+    Node *stop = ear;
+
+    // Iterate through ears, slicing them one by one.
+    while (ear->prev != ear->next) {
+        Node *prev = ear->prev;
+        Node *next = ear->next;
+
+        if (size ? isEarHashed(ear) : isEar(ear)) {
+            addTriangle(prev, ear, next);
+            removeNode(ear);
+
+            // Skipping the next vertex leads to fewer sliver triangles.
+            ear = next->next;
+            stop = next->next;
+            continue;
+        }
+
+        ear = next;
+
+        // If we looped through the whole remaining polygon and can't find any more ears.
+        if (ear == stop) {
+            if (!pass) {
+                // Try filtering points and slicing again.
+                earcutLinked(filterPoints(ear), 1);
+            } else if (pass == 1) {
+                // If this didn't work, try curing all small self-intersections locally.
+                ear = cureLocalIntersections(ear);
+                earcutLinked(ear, 2);
+            } else if (pass == 2) {
+                // As a last resort, try splitting the remaining polygon into two.
+                splitEarcut(ear);
+            }
+            break;
+        }
+    }
+}
+
+// Whether a polygon node forms a valid ear with its neighbors.
+bool Earcut::isEar(Node *ear) {
+    const Node *a = ear->prev;
+    const Node *b = ear;
+    const Node *c = ear->next;
+
+    if (area(a, b, c) >= 0) {
+        // Reflex, can't be an ear.
+        return false;
+    }
+
+    // Now make sure we don't have other points inside the potential ear.
+    const Node *p = ear->next->next;
+    while (p != ear->prev) {
+        if (pointInTriangle(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y) &&
+            area(p->prev, p, p->next) >= 0) {
+            return false;
+        }
+        p = p->next;
+    }
+
+    return true;
+}
+
+bool Earcut::isEarHashed(Node *ear) {
+    const Node *a = ear->prev;
+    const Node *b = ear;
+    const Node *c = ear->next;
+
+    if (area(a, b, c) >= 0) {
+        return false;
+    }
+
+    // The triangle's bounding box.
+    const int32_t minTX = std::min({ a->x, b->x, c->x });
+    const int32_t minTY = std::min({ a->y, b->y, c->y });
+    const int32_t maxTX = std::max({ a->x, b->x, c->x });
+    const int32_t maxTY = std::max({ a->y, b->y, c->y });
+
+    // Z-order range for the current triangle's bounding box.
+    const int32_t minZ = zOrder(minTX, minTY);
+    const int32_t maxZ = zOrder(maxTX, maxTY);
+
+    // First look for points inside the triangle in increasing z-order.
+    const Node *p = ear->nextZ;
+    while (p && p->z <= maxZ) {
+        if (p != ear->prev && p != ear->next &&
+            pointInTriangle(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y) &&
+            area(p->prev, p, p->next) >= 0) {
+            return false;
+        }
+        p = p->nextZ;
+    }
+
+    // Then look for points in decreasing z-order.
+    p = ear->prevZ;
+    while (p && p->z >= minZ) {
+        if (p != ear->prev && p != ear->next &&
+            pointInTriangle(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y) &&
+            area(p->prev, p, p->next) >= 0) {
+            return false;
+        }
+        p = p->prevZ;
+    }
+
+    return true;
+}
+
+// Goes through all polygon nodes and cures small local self-intersections.
+Earcut::Node *Earcut::cureLocalIntersections(Node *start) {
+    Node *p = start;
+    do {
+        Node *a = p->prev;
+        Node *b = p->next->next;
+
+        if (!equals(a, b) && intersects(a, p, p->next, b) && locallyInside(a, b) &&
+            locallyInside(b, a)) {
+            addTriangle(a, p, b);
+
+            // Remove two nodes involved.
+            removeNode(p);
+            removeNode(p->next);
+
+            p = start = b;
+        }
+        p = p->next;
+    } while (p != start);
+
+    return p;
+}
+
+// Tries splitting the polygon into two and triangulating them independently.
+void Earcut::splitEarcut(Node *start) {
+    // Look for a valid diagonal that divides the polygon into two.
+    Node *a = start;
+    do {
+        Node *b = a->next->next;
+        while (b != a->prev) {
+            if (a->i != b->i && isValidDiagonal(a, b)) {
+                // Split the polygon in two by the diagonal.
+                Node *c = splitPolygon(a, b);
+
+                // Filter colinear points around the cuts.
+                a = filterPoints(a, a->next);
+                c = filterPoints(c, c->next);
+
+                // Run earcut on each half.
+                earcutLinked(a);
+                earcutLinked(c);
+                return;
+            }
+            b = b->next;
+        }
+        a = a->next;
+    } while (a != start);
+}
+
+// Interlinks polygon nodes in z-order.
+void Earcut::indexCurve(Node *start) {
+    Node *p = start;
+    do {
+        if (p->z < 0) {
+            p->z = zOrder(p->x, p->y);
+        }
+        p->prevZ = p->prev;
+        p->nextZ = p->next;
+        p = p->next;
+    } while (p != start);
+
+    p->prevZ->nextZ = nullptr;
+    p->prevZ = nullptr;
+
+    sortLinked(p);
+}
+
+// Z-order of a point given coords and size of the data bounding box.
+int32_t Earcut::zOrder(int32_t x_, int32_t y_) const {
+    // Coords are transformed into non-negative 15-bit integer range.
+    uint32_t x = uint32_t(int64_t(32767) * (x_ - minX) / size);
+    uint32_t y = uint32_t(int64_t(32767) * (y_ - minY) / size);
+
+    x = (x | (x << 8)) & 0x00FF00FF;
+    x = (x | (x << 4)) & 0x0F0F0F0F;
+    x = (x | (x << 2)) & 0x33333333;
+    x = (x | (x << 1)) & 0x55555555;
+
+    y = (y | (y << 8)) & 0x00FF00FF;
+    y = (y | (y << 4)) & 0x0F0F0F0F;
+    y = (y | (y << 2)) & 0x33333333;
+    y = (y | (y << 1)) & 0x55555555;
+
+    return int32_t(x | (y << 1));
+}
+
+// Links two polygon vertices with a bridge. If the vertices belong to the same ring, it splits
+// the polygon into two. If one belongs to the outer ring and another to a hole, it merges them
+// into a single ring.
+Earcut::Node *Earcut::splitPolygon(Node *a, Node *b) {
+    Node *a2 = createNode(a->i, a->x, a->y);
+    Node *b2 = createNode(b->i, b->x, b->y);
+
+    Node *an = a->next;
+    Node *bp = b->prev;
+
+    a->next = b;
+    b->prev = a;
+
+    a2->next = an;
+    an->prev = a2;
+
+    b2->next = a2;
+    a2->prev = b2;
+
+    bp->next = b2;
+    b2->prev = bp;
+
+    return b2;
+}
+
+}
+}
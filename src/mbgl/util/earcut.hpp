@@ -0,0 +1,70 @@
+#ifndef MBGL_UTIL_EARCUT
+#define MBGL_UTIL_EARCUT
+
+#include <mbgl/map/geometry_tile.hpp>
+#include <mbgl/util/noncopyable.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace mbgl {
+namespace util {
+
+struct EarcutNode;
+
+// Triangulates polygons with holes by ear clipping, after Mapbox's earcut.js. Holes are joined to
+// the outer ring with bridges first. All math runs on the integer tile coordinates, so it's exact.
+// Nodes are allocated from a pool that is kept for the next polygon.
+class Earcut : private util::noncopyable {
+public:
+    Earcut();
+    ~Earcut();
+
+    // Triangulates the polygon made of an outer ring followed by its holes. Rings must not repeat
+    // their first point at the end. Vertices are numbered in ring order across all rings, and three
+    // indices are written to `triangles` per triangle.
+    //
+    // Returns false if the triangles don't cover exactly the area of the polygon, which happens for
+    // self-intersecting rings and for holes that cross the outer ring.
+    bool operator()(const std::vector<GeometryLine> &rings, std::vector<uint32_t> &triangles);
+
+    // Twice the signed area of the ring.
+    static int64_t signedArea(const GeometryLine &ring);
+
+private:
+    using Node = EarcutNode;
+
+    Node *createNode(uint32_t i, int32_t x, int32_t y);
+    void addTriangle(const Node *a, const Node *b, const Node *c);
+    Node *linkedList(const GeometryLine &ring, uint32_t start, bool clockwise);
+    Node *filterPoints(Node *start, Node *end = nullptr);
+    Node *eliminateHoles(const std::vector<GeometryLine> &rings, Node *outerNode);
+    void eliminateHole(Node *hole, Node *outerNode);
+    Node *findHoleBridge(Node *hole, Node *outerNode);
+    void earcutLinked(Node *ear, int pass = 0);
+    bool isEar(Node *ear);
+    bool isEarHashed(Node *ear);
+    Node *cureLocalIntersections(Node *start);
+    void splitEarcut(Node *start);
+    void indexCurve(Node *start);
+    int32_t zOrder(int32_t x, int32_t y) const;
+    Node *splitPolygon(Node *a, Node *b);
+
+    std::vector<uint32_t> *output = nullptr;
+    int64_t trianglesArea = 0;
+
+    // Bounding box for the z-order hash of larger polygons. Zero size disables hashing.
+    int32_t minX = 0, minY = 0, size = 0;
+
+    static const std::size_t blockSize = 1024;
+    std::vector<std::unique_ptr<Node[]>> blocks;
+    std::size_t used = 0;
+
+    std::vector<Node *> queue;
+};
+
+}
+}
+
+#endif
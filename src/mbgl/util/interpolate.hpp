@@ -40,6 +40,7 @@ template<> inline TranslateAnchorType interpolate(const TranslateAnchorType a, c
 template<> inline RotateAnchorType interpolate(const RotateAnchorType a, const RotateAnchorType, const double) { return a; }
 template<> inline CapType interpolate(const CapType a, const CapType, const double) { return a; }
 template<> inline JoinType interpolate(const JoinType a, const JoinType, const double) { return a; }
+template<> inline TriangulationType interpolate(const TriangulationType a, const TriangulationType, const double) { return a; }
 template<> inline PlacementType interpolate(const PlacementType a, const PlacementType, const double) { return a; }
 template<> inline TextAnchorType interpolate(const TextAnchorType a, const TextAnchorType, const double) { return a; }
 template<> inline TextJustifyType interpolate(const TextJustifyType a, const TextJustifyType, const double) { return a; }
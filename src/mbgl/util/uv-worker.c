@@ -2,14 +2,20 @@
 #include <mbgl/util/uv-messenger.h>
 
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 
-typedef struct uv__worker_item_s uv__worker_item_t;
-struct uv__worker_item_s {
+struct uv_worker_item_s {
     uv_worker_t *worker;
     void *data;
     uv_worker_cb work_cb;
     uv_worker_after_cb after_work_cb;
+    double priority;
+    uint64_t sequence;
+    uint64_t queued_at;
+    // Position in the worker's heap, or -1 if the item isn't queued.
+    int heap_index;
+    int status;
 };
 
 typedef struct uv__worker_thread_s uv__worker_thread_t;
@@ -22,6 +28,78 @@ void uv__worker_free_messenger(uv_messenger_t *msgr) {
     free(msgr);
 }
 
+// Heap helpers. The caller must hold worker->mutex.
+
+static int uv__worker_item_less(const uv_worker_item_t *a, const uv_worker_item_t *b) {
+    if (a->priority != b->priority) {
+        return a->priority < b->priority;
+    }
+    return a->sequence < b->sequence;
+}
+
+static void uv__worker_heap_set(uv_worker_t *worker, unsigned int i, uv_worker_item_t *item) {
+    worker->heap[i] = item;
+    item->heap_index = (int)i;
+}
+
+static void uv__worker_heap_up(uv_worker_t *worker, unsigned int i) {
+    uv_worker_item_t *item = worker->heap[i];
+    while (i > 0) {
+        unsigned int parent = (i - 1) / 2;
+        if (!uv__worker_item_less(item, worker->heap[parent])) {
+            break;
+        }
+        uv__worker_heap_set(worker, i, worker->heap[parent]);
+        i = parent;
+    }
+    uv__worker_heap_set(worker, i, item);
+}
+
+static void uv__worker_heap_down(uv_worker_t *worker, unsigned int i) {
+    uv_worker_item_t *item = worker->heap[i];
+    for (;;) {
+        unsigned int child = 2 * i + 1;
+        if (child >= worker->heap_size) {
+            break;
+        }
+        if (child + 1 < worker->heap_size &&
+            uv__worker_item_less(worker->heap[child + 1], worker->heap[child])) {
+            child++;
+        }
+        if (!uv__worker_item_less(worker->heap[child], item)) {
+            break;
+        }
+        uv__worker_heap_set(worker, i, worker->heap[child]);
+        i = child;
+    }
+    uv__worker_heap_set(worker, i, item);
+}
+
+static void uv__worker_heap_push(uv_worker_t *worker, uv_worker_item_t *item) {
+    if (worker->heap_size == worker->heap_capacity) {
+        worker->heap_capacity = worker->heap_capacity ? worker->heap_capacity * 2 : 64;
+        worker->heap = (uv_worker_item_t **)realloc(worker->heap,
+            worker->heap_capacity * sizeof(uv_worker_item_t *));
+        assert(worker->heap);
+    }
+    uv__worker_heap_set(worker, worker->heap_size++, item);
+    uv__worker_heap_up(worker, worker->heap_size - 1);
+}
+
+static void uv__worker_heap_remove(uv_worker_t *worker, uv_worker_item_t *item) {
+    unsigned int i = (unsigned int)item->heap_index;
+    assert(i < worker->heap_size && worker->heap[i] == item);
+    item->heap_index = -1;
+
+    worker->heap_size--;
+    if (i < worker->heap_size) {
+        uv_worker_item_t *last = worker->heap[worker->heap_size];
+        uv__worker_heap_set(worker, i, last);
+        uv__worker_heap_up(worker, i);
+        uv__worker_heap_down(worker, (unsigned int)last->heap_index);
+    }
+}
+
 void uv__worker_thread_finished(uv__worker_thread_t *worker_thread) {
     uv_worker_t *worker = worker_thread->worker;
 
@@ -38,7 +116,10 @@ void uv__worker_thread_finished(uv__worker_thread_t *worker_thread) {
     assert(worker->count > 0);
     worker->count--;
     if (worker->count == 0) {
-        uv_chan_destroy(&worker->chan);
+        assert(worker->heap_size == 0);
+        free(worker->heap);
+        uv_cond_destroy(&worker->cond);
+        uv_mutex_destroy(&worker->mutex);
         uv_messenger_stop(worker->msgr, uv__worker_free_messenger);
         if (worker->close_cb) {
             worker->close_cb(worker);
@@ -47,13 +128,12 @@ void uv__worker_thread_finished(uv__worker_thread_t *worker_thread) {
 }
 
 void uv__worker_after(void *ptr) {
-    uv__worker_item_t *item = (uv__worker_item_t *)ptr;
+    uv_worker_item_t *item = (uv_worker_item_t *)ptr;
 
     if (item->work_cb) {
         // We are finishing a regular work request.
         if (item->after_work_cb) {
-            assert(item->after_work_cb);
-            item->after_work_cb(item->data);
+            item->after_work_cb(item->data, item->status);
         }
         uv_worker_t *worker = item->worker;
         assert(worker->active_items > 0);
@@ -70,6 +150,33 @@ void uv__worker_after(void *ptr) {
     free(item);
 }
 
+// Blocks until an item is available and removes it from the queue. Returns
+// NULL once the worker is closing and the queue has been drained.
+static uv_worker_item_t *uv__worker_receive(uv_worker_t *worker) {
+    uv_worker_item_t *item = NULL;
+
+    uv_mutex_lock(&worker->mutex);
+    while (worker->heap_size == 0 && !worker->closing) {
+        uv_cond_wait(&worker->cond, &worker->mutex);
+    }
+
+    if (worker->heap_size) {
+        item = worker->heap[0];
+        uv__worker_heap_remove(worker, item);
+
+        const uint64_t wait = uv_hrtime() - item->queued_at;
+        worker->stats.queued--;
+        worker->stats.started++;
+        worker->stats.total_wait_ns += wait;
+        if (wait > worker->stats.max_wait_ns) {
+            worker->stats.max_wait_ns = wait;
+        }
+    }
+    uv_mutex_unlock(&worker->mutex);
+
+    return item;
+}
+
 void uv__worker_thread_loop(void *ptr) {
     uv__worker_thread_t *worker_thread = (uv__worker_thread_t *)ptr;
     uv_worker_t *worker = worker_thread->worker;
@@ -80,8 +187,8 @@ void uv__worker_thread_loop(void *ptr) {
     }
 #endif
 
-    uv__worker_item_t *item = NULL;
-    while ((item = (uv__worker_item_t *)uv_chan_receive(&worker->chan)) != NULL) {
+    uv_worker_item_t *item = NULL;
+    while ((item = uv__worker_receive(worker)) != NULL) {
         assert(item->work_cb);
         item->work_cb(item->data);
 
@@ -89,11 +196,8 @@ void uv__worker_thread_loop(void *ptr) {
         uv_messenger_send(worker->msgr, item);
     }
 
-    // Make sure to close all other workers too.
-    uv_chan_send(&worker->chan, NULL);
-
     // Create a new worker item that acts as a terminate flag for this thread.
-    item = (uv__worker_item_t *)malloc(sizeof(uv__worker_item_t));
+    item = (uv_worker_item_t *)malloc(sizeof(uv_worker_item_t));
     item->data = worker_thread;
     item->work_cb = NULL;
     item->after_work_cb = NULL;
@@ -109,6 +213,12 @@ int uv_worker_init(uv_worker_t *worker, uv_loop_t *loop, int count, const char *
     worker->count = 0;
     worker->close_cb = NULL;
     worker->active_items = 0;
+    worker->heap = NULL;
+    worker->heap_size = 0;
+    worker->heap_capacity = 0;
+    worker->sequence = 0;
+    worker->closing = 0;
+    memset(&worker->stats, 0, sizeof(worker->stats));
     worker->msgr = (uv_messenger_t *)malloc(sizeof(uv_messenger_t));
     int ret = uv_messenger_init(loop, worker->msgr, uv__worker_after);
     if (ret < 0) {
@@ -116,7 +226,9 @@ int uv_worker_init(uv_worker_t *worker, uv_loop_t *loop, int count, const char *
         return ret;
     }
     uv_messenger_unref(worker->msgr);
-    ret = uv_chan_init(&worker->chan);
+    ret = uv_mutex_init(&worker->mutex);
+    if (ret < 0) return ret;
+    ret = uv_cond_init(&worker->cond);
     if (ret < 0) return ret;
 
     // Initialize all worker threads.
@@ -132,26 +244,87 @@ int uv_worker_init(uv_worker_t *worker, uv_loop_t *loop, int count, const char *
     return 0;
 }
 
-void uv_worker_send(uv_worker_t *worker, void *data, uv_worker_cb work_cb,
-                    uv_worker_after_cb after_work_cb) {
+uv_worker_item_t *uv_worker_send(uv_worker_t *worker, void *data, double priority,
+                                 uv_worker_cb work_cb, uv_worker_after_cb after_work_cb) {
 #ifdef DEBUG
     assert(uv_thread_self() == worker->thread_id);
 #endif
 
     // It doesn't make sense to not provide a work callback. On the other hand, the after_work_cb
-    // may be NULL. In that case, there will be no callback called in the current thread and the
-    // worker item will instead be freed in the worker thread.
+    // may be NULL. In that case, there will be no callback called in the current thread.
     assert(work_cb);
 
-    uv__worker_item_t *item = (uv__worker_item_t *)malloc(sizeof(uv__worker_item_t));
+    uv_worker_item_t *item = (uv_worker_item_t *)malloc(sizeof(uv_worker_item_t));
     item->worker = worker;
     item->work_cb = work_cb;
     item->after_work_cb = after_work_cb;
     item->data = data;
-    uv_chan_send(&worker->chan, item);
+    item->priority = priority;
+    item->heap_index = -1;
+    item->status = 0;
+
+    uv_mutex_lock(&worker->mutex);
+    assert(!worker->closing);
+    item->sequence = worker->sequence++;
+    item->queued_at = uv_hrtime();
+    uv__worker_heap_push(worker, item);
+    if (++worker->stats.queued > worker->stats.max_queued) {
+        worker->stats.max_queued = worker->stats.queued;
+    }
+    uv_cond_signal(&worker->cond);
+    uv_mutex_unlock(&worker->mutex);
+
     if (worker->active_items++ == 0) {
         uv_messenger_ref(worker->msgr);
     }
+
+    return item;
+}
+
+int uv_worker_set_priority(uv_worker_t *worker, uv_worker_item_t *item, double priority) {
+#ifdef DEBUG
+    assert(uv_thread_self() == worker->thread_id);
+#endif
+
+    int ret = 0;
+    uv_mutex_lock(&worker->mutex);
+    if (item->heap_index < 0) {
+        ret = UV_EBUSY;
+    } else if (item->priority != priority) {
+        item->priority = priority;
+        uv__worker_heap_up(worker, (unsigned int)item->heap_index);
+        uv__worker_heap_down(worker, (unsigned int)item->heap_index);
+    }
+    uv_mutex_unlock(&worker->mutex);
+    return ret;
+}
+
+int uv_worker_cancel(uv_worker_t *worker, uv_worker_item_t *item) {
+#ifdef DEBUG
+    assert(uv_thread_self() == worker->thread_id);
+#endif
+
+    uv_mutex_lock(&worker->mutex);
+    if (item->heap_index < 0) {
+        uv_mutex_unlock(&worker->mutex);
+        return UV_EBUSY;
+    }
+    uv__worker_heap_remove(worker, item);
+    worker->stats.queued--;
+    worker->stats.canceled++;
+    uv_mutex_unlock(&worker->mutex);
+
+    // Deliver the cancelation asynchronously so that after_work_cb is never
+    // called from within the caller's stack.
+    item->status = UV_ECANCELED;
+    uv_messenger_send(worker->msgr, item);
+    return 0;
+}
+
+void uv_worker_stats(uv_worker_t *worker, uv_worker_stats_t *stats) {
+    uv_mutex_lock(&worker->mutex);
+    *stats = worker->stats;
+    uv_mutex_unlock(&worker->mutex);
 }
 
 void uv_worker_close(uv_worker_t *worker, uv_worker_close_cb close_cb) {
@@ -163,7 +336,13 @@ void uv_worker_close(uv_worker_t *worker, uv_worker_close_cb close_cb) {
     assert(worker->close_cb == NULL);
 
     worker->close_cb = close_cb;
-    uv_chan_send(&worker->chan, NULL);
+
+    // Worker threads drain the remaining items before they exit.
+    uv_mutex_lock(&worker->mutex);
+    worker->closing = 1;
+    uv_cond_broadcast(&worker->cond);
+    uv_mutex_unlock(&worker->mutex);
+
     if (worker->active_items++ == 0) {
         uv_messenger_ref(worker->msgr);
     }
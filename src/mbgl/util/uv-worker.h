@@ -2,36 +2,75 @@
 #define MBGL_UTIL_UV_WORKER
 
 #include <stdlib.h>
+#include <stdint.h>
 
 #include <mbgl/util/uv-messenger.h>
-#include <mbgl/util/uv-channel.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 typedef struct uv_worker_s uv_worker_t;
+typedef struct uv_worker_item_s uv_worker_item_t;
+typedef struct uv_worker_stats_s uv_worker_stats_t;
 
 typedef void (*uv_worker_cb)(void *data);
-typedef void (*uv_worker_after_cb)(void *data);
+// status is 0 when the work callback ran, or UV_ECANCELED when the item was
+// canceled before a worker thread picked it up.
+typedef void (*uv_worker_after_cb)(void *data, int status);
 typedef void (*uv_worker_close_cb)(uv_worker_t *worker);
 
+struct uv_worker_stats_s {
+    // Number of items currently waiting for a worker thread.
+    unsigned int queued;
+    unsigned int max_queued;
+    uint64_t started;
+    uint64_t canceled;
+    // Time items spent in the queue before a worker thread picked them up.
+    uint64_t total_wait_ns;
+    uint64_t max_wait_ns;
+};
+
 struct uv_worker_s {
 #ifdef DEBUG
     unsigned long thread_id;
 #endif
     uv_loop_t *loop;
     uv_messenger_t *msgr;
-    uv_chan_t chan;
     const char *name;
     int count;
     uv_worker_close_cb close_cb;
     unsigned int active_items;
+
+    // Pending items, ordered as a binary min-heap on (priority, sequence).
+    uv_mutex_t mutex;
+    uv_cond_t cond;
+    uv_worker_item_t **heap;
+    unsigned int heap_size;
+    unsigned int heap_capacity;
+    uint64_t sequence;
+    int closing;
+    uv_worker_stats_t stats;
 };
 
 int uv_worker_init(uv_worker_t *worker, uv_loop_t *loop, int count, const char *name);
-void uv_worker_send(uv_worker_t *worker, void *data, uv_worker_cb work_cb,
-                    uv_worker_after_cb after_work_cb);
+
+// Queues an item. Items with lower priority values are processed first; items
+// with equal priority are processed in the order they were sent. The returned
+// handle is valid until after_work_cb has been called.
+uv_worker_item_t *uv_worker_send(uv_worker_t *worker, void *data, double priority,
+                                 uv_worker_cb work_cb, uv_worker_after_cb after_work_cb);
+
+// Changes the priority of a queued item. Returns UV_EBUSY if the item has
+// already been picked up by a worker thread.
+int uv_worker_set_priority(uv_worker_t *worker, uv_worker_item_t *item, double priority);
+
+// Removes a queued item. Its after_work_cb is called with UV_ECANCELED on the
+// next loop iteration. Returns UV_EBUSY if the item has already been picked up
+// by a worker thread; in that case it completes normally.
+int uv_worker_cancel(uv_worker_t *worker, uv_worker_item_t *item);
+
+void uv_worker_stats(uv_worker_t *worker, uv_worker_stats_t *stats);
 void uv_worker_close(uv_worker_t *worker, uv_worker_close_cb close_cb);
 
 #ifdef __cplusplus
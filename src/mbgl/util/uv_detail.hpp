@@ -127,14 +127,28 @@ public:
             delete worker_;
         });
     }
-    inline void add(void *data, uv_worker_cb work_cb, uv_worker_after_cb after_work_cb) {
-        uv_worker_send(w, data, work_cb, after_work_cb);
+    inline uv_worker_item_t *add(void *data, double priority, uv_worker_cb work_cb, uv_worker_after_cb after_work_cb) {
+        return uv_worker_send(w, data, priority, work_cb, after_work_cb);
+    }
+    inline bool setPriority(uv_worker_item_t *item, double priority) {
+        return uv_worker_set_priority(w, item, priority) == 0;
+    }
+    inline bool cancel(uv_worker_item_t *item) {
+        return uv_worker_cancel(w, item) == 0;
+    }
+    inline uv_worker_stats_t stats() const {
+        uv_worker_stats_t result;
+        uv_worker_stats(w, &result);
+        return result;
     }
 
 private:
     uv_worker_t *w;
 };
 
+// A work request that deletes itself after the after work handler ran. Work
+// requests with lower priority values are processed first. A request that was
+// canceled before it started deletes itself without calling either handler.
 template <typename T>
 class work : public mbgl::util::noncopyable {
 public:
@@ -142,11 +156,23 @@ public:
     typedef std::function<void (T&)> after_work_callback;
 
     template<typename... Args>
-    work(worker &worker, work_callback work_cb_, after_work_callback after_work_cb_, Args&&... args)
+    work(worker &worker_, double priority, work_callback work_cb_, after_work_callback after_work_cb_, Args&&... args)
         : data(std::forward<Args>(args)...),
           work_cb(work_cb_),
-          after_work_cb(after_work_cb_) {
-        worker.add(this, do_work, after_work);
+          after_work_cb(after_work_cb_),
+          owner(worker_) {
+        item = owner.add(this, priority, do_work, after_work);
+    }
+
+    // Returns false if the request has already started.
+    inline bool setPriority(double priority) {
+        return owner.setPriority(item, priority);
+    }
+
+    // Returns false if the request has already started; it then completes
+    // normally. Otherwise, the request must not be used anymore.
+    inline bool cancel() {
+        return owner.cancel(item);
     }
 
 private:
@@ -155,9 +181,11 @@ private:
         w->work_cb(w->data);
     }
 
-    static void after_work(void *data) {
+    static void after_work(void *data, int status) {
         work<T> *w = reinterpret_cast<work<T> *>(data);
-        w->after_work_cb(w->data);
+        if (status != UV_ECANCELED) {
+            w->after_work_cb(w->data);
+        }
         delete w;
     }
 
@@ -165,6 +193,8 @@ private:
     T data;
     work_callback work_cb;
     after_work_callback after_work_cb;
+    worker &owner;
+    uv_worker_item_t *item;
 };
 
 }
@@ -0,0 +1,23 @@
+#ifndef MBGL_TEST_FIXTURE_STUB_FILE_SOURCE
+#define MBGL_TEST_FIXTURE_STUB_FILE_SOURCE
+
+#include <mbgl/storage/file_source.hpp>
+
+namespace mbgl {
+
+// A file source that never answers, for tests of objects that need an Environment but don't
+// load anything.
+class StubFileSource : public FileSource {
+public:
+    Request *request(const Resource &, uv_loop_t *, const Environment &, Callback) override {
+        return nullptr;
+    }
+    void cancel(Request *) override {}
+    void setPriority(Request *, double) override {}
+    void request(const Resource &, const Environment &, Callback) override {}
+    void abort(const Environment &) override {}
+};
+
+}
+
+#endif
@@ -3,6 +3,8 @@
 #include <mbgl/platform/log.hpp>
 
 #include <csignal>
+#include <cstdarg>
+#include <cstdio>
 
 namespace mbgl {
 namespace test {
@@ -33,5 +35,14 @@ void stopServer(pid_t pid) {
     kill(pid, SIGTERM);
 }
 
+void reportBenchmark(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    printf("[ BENCH    ] ");
+    vprintf(format, args);
+    printf("\n");
+    va_end(args);
+}
+
 }
 }
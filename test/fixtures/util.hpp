@@ -17,6 +17,12 @@ namespace test {
 pid_t startServer(const char *executable);
 void stopServer(pid_t pid);
 
+// Benchmarks are separate tests named DISABLED_Benchmark or DISABLED_*Benchmark, so that they don't
+// run with the correctness tests. Run them with
+// --gtest_also_run_disabled_tests --gtest_filter='*Benchmark*'. They print their measurements
+// with this, one line per measurement.
+void reportBenchmark(const char *format, ...) __attribute__((format(printf, 1, 2)));
+
 }
 }
 
@@ -0,0 +1,86 @@
+#include "../fixtures/util.hpp"
+
+#include <mbgl/geometry/buffer.hpp>
+#include <mbgl/geometry/buffer_pool.hpp>
+
+using namespace mbgl;
+
+namespace {
+
+class TestBuffer : public Buffer<4, GL_ARRAY_BUFFER, 64> {
+public:
+    void add(int32_t value) {
+        *reinterpret_cast<int32_t *>(addElement()) = value;
+    }
+
+    int32_t get(size_t i) {
+        return *reinterpret_cast<int32_t *>(getElement(i));
+    }
+
+    const void *data() {
+        return getElement(0);
+    }
+};
+
+}
+
+TEST(Buffer, Growth) {
+    TestBuffer buffer;
+    for (int32_t i = 0; i < 10000; i++) {
+        buffer.add(i);
+    }
+
+    EXPECT_EQ(10000u, buffer.index());
+    EXPECT_EQ(40000u, buffer.bytes());
+    for (int32_t i = 0; i < 10000; i++) {
+        ASSERT_EQ(i, buffer.get(i));
+    }
+}
+
+TEST(Buffer, Reserve) {
+    TestBuffer buffer;
+    buffer.add(1);
+    buffer.reserve(1000);
+    const void *data = buffer.data();
+    for (int32_t i = 0; i < 1000; i++) {
+        buffer.add(i);
+    }
+
+    // Nothing moved while adding the reserved elements.
+    EXPECT_EQ(data, buffer.data());
+    EXPECT_EQ(1, buffer.get(0));
+    EXPECT_EQ(999, buffer.get(1000));
+}
+
+TEST(Buffer, Pool) {
+    BufferPool &pool = BufferPool::Get();
+    pool.clear();
+
+    const void *data;
+    {
+        TestBuffer buffer;
+        buffer.reserve(1000);
+        buffer.add(1);
+        data = buffer.data();
+        buffer.cleanup();
+        EXPECT_EQ(4096u, pool.retainedBytes());
+    }
+
+    // The next buffer of the same size gets the same memory back.
+    TestBuffer buffer;
+    buffer.reserve(1000);
+    buffer.add(1);
+    EXPECT_EQ(data, buffer.data());
+    EXPECT_EQ(0u, pool.retainedBytes());
+
+    // Blocks that don't fit into the pool are freed.
+    size_t size = BufferPool::maxRetainedBytes;
+    void *large = pool.acquire(size);
+    size_t small = 16;
+    pool.release(pool.acquire(small), small);
+    pool.release(large, size);
+    EXPECT_EQ(16u, pool.retainedBytes());
+
+    pool.clear();
+    EXPECT_EQ(0u, pool.retainedBytes());
+}
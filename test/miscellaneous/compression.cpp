@@ -0,0 +1,198 @@
+#include "../fixtures/util.hpp"
+
+#include <mbgl/util/compression.hpp>
+#include <mbgl/util/io.hpp>
+
+#include <dirent.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace mbgl;
+
+namespace {
+
+std::string sample(std::size_t size) {
+    // Compressible, but not trivially so.
+    std::string result;
+    result.reserve(size);
+    for (std::size_t i = 0; result.size() < size; i++) {
+        result += "feature " + std::to_string(i % 97) + " ";
+    }
+    result.resize(size);
+    return result;
+}
+
+std::vector<std::string> readTiles(const std::string &directory) {
+    std::vector<std::string> tiles;
+    DIR *dir = opendir(directory.c_str());
+    if (!dir) {
+        return tiles;
+    }
+    while (dirent *entry = readdir(dir)) {
+        const std::string name = entry->d_name;
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".pbf") == 0) {
+            tiles.push_back(util::read_file(directory + "/" + name));
+        }
+    }
+    closedir(dir);
+    return tiles;
+}
+
+double elapsedSeconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+TEST(Compression, RoundTrip) {
+    for (const std::size_t size : { std::size_t(0), std::size_t(1), std::size_t(1000), std::size_t(1 << 20) }) {
+        const std::string raw = sample(size);
+
+        const std::string zlib = util::compress(raw);
+        EXPECT_EQ(0x78, uint8_t(zlib[0])) << size;
+        EXPECT_EQ(raw, util::decompress(zlib)) << size;
+        EXPECT_EQ(raw, util::decompress(zlib.data(), zlib.size(), raw.size())) << size;
+
+        const std::string gzip = util::compress(raw, true);
+        EXPECT_EQ(0x1F, uint8_t(gzip[0])) << size;
+        EXPECT_EQ(0x8B, uint8_t(gzip[1])) << size;
+        EXPECT_EQ(raw, util::decompress(gzip)) << size;
+
+#ifdef MBGL_USE_LZ4
+        const std::string lz4 = util::compressLZ4(raw);
+        EXPECT_EQ(raw, util::decompressLZ4(lz4.data(), lz4.size())) << size;
+#endif
+    }
+}
+
+TEST(Compression, WrongSizeHint) {
+    // Hints and trailers only size the first allocation; the output grows if they are too small.
+    const std::string raw = sample(100000);
+    const std::string zlib = util::compress(raw);
+    EXPECT_EQ(raw, util::decompress(zlib.data(), zlib.size(), 10));
+    EXPECT_EQ(raw, util::decompress(zlib.data(), zlib.size(), 1 << 24));
+
+    std::string gzip = util::compress(raw, true);
+    gzip[gzip.size() - 4] = 1;
+    gzip[gzip.size() - 3] = 0;
+    gzip[gzip.size() - 2] = 0;
+    gzip[gzip.size() - 1] = 0;
+    // The gzip trailer is part of the checked data, so this fails after inflating everything.
+    EXPECT_THROW(util::decompress(gzip), std::runtime_error);
+}
+
+TEST(Compression, Errors) {
+    EXPECT_THROW(util::decompress("not compressed"), std::runtime_error);
+
+    // A stream that failed doesn't affect the next one in the same thread.
+    const std::string raw = sample(1000);
+    const std::string zlib = util::compress(raw);
+    EXPECT_THROW(util::decompress(zlib.substr(0, zlib.size() / 2)), std::runtime_error);
+    EXPECT_EQ(raw, util::decompress(zlib));
+}
+
+TEST(Compression, Threads) {
+    // Every thread uses its own streams.
+    const std::string raw = sample(200000);
+    const std::string gzip = util::compress(raw, true);
+
+    std::vector<std::thread> threads;
+    std::vector<int> results(4, 0);
+    for (std::size_t t = 0; t < results.size(); t++) {
+        threads.emplace_back([&, t] {
+            for (int i = 0; i < 20; i++) {
+                if (util::decompress(util::compress(raw, i % 2)) == raw && util::decompress(gzip) == raw) {
+                    results[t]++;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (const int result : results) {
+        EXPECT_EQ(20, result);
+    }
+}
+
+#ifdef MBGL_USE_LZ4
+TEST(Compression, LZ4CorruptSize) {
+    // A size that the data can't possibly inflate to is rejected before it is allocated.
+    std::string lz4 = util::compressLZ4(sample(1000));
+    lz4[0] = lz4[1] = lz4[2] = lz4[3] = char(0xFF);
+    EXPECT_THROW(util::decompressLZ4(lz4.data(), lz4.size()), std::runtime_error);
+}
+#endif
+
+// Reports the throughput over the vector tiles of the test suite.
+TEST(Compression, DISABLED_Benchmark) {
+    const std::vector<std::string> tiles = readTiles("test/suite/tiles");
+    if (tiles.empty()) {
+        test::reportBenchmark("compression skipped: no tiles in test/suite/tiles");
+        return;
+    }
+
+    std::size_t bytes = 0;
+    std::vector<std::string> compressed;
+    for (const auto &tile : tiles) {
+        bytes += tile.size();
+        compressed.push_back(util::compress(tile, true));
+    }
+
+    const int rounds = std::max<int>(1, int((64 << 20) / std::max<std::size_t>(bytes, 1)));
+    const double megabytes = double(bytes) * rounds / (1 << 20);
+
+    auto report = [&](const char *name, std::chrono::steady_clock::time_point start) {
+        const double seconds = elapsedSeconds(start);
+        test::reportBenchmark("%s: %.1f MB/s (%.1f MB of %zu tiles in %.3fs)", name,
+                              megabytes / seconds, megabytes, tiles.size(), seconds);
+    };
+
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < rounds; round++) {
+            for (const auto &tile : tiles) {
+                util::compress(tile, true);
+            }
+        }
+        report("gzip compress", start);
+    }
+
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < rounds; round++) {
+            for (const auto &data : compressed) {
+                util::decompress(data);
+            }
+        }
+        report("gzip decompress", start);
+    }
+
+#ifdef MBGL_USE_LZ4
+    std::vector<std::string> lz4;
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < rounds; round++) {
+            lz4.clear();
+            for (const auto &tile : tiles) {
+                lz4.push_back(util::compressLZ4(tile));
+            }
+        }
+        report("lz4 compress", start);
+    }
+
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < rounds; round++) {
+            for (const auto &data : lz4) {
+                util::decompressLZ4(data.data(), data.size());
+            }
+        }
+        report("lz4 decompress", start);
+    }
+#endif
+}
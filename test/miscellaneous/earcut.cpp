@@ -0,0 +1,242 @@
+#include "../fixtures/util.hpp"
+
+#include <mbgl/util/earcut.hpp>
+#include <mbgl/map/vector_tile.hpp>
+#include <mbgl/renderer/fill_bucket.hpp>
+#include <mbgl/util/io.hpp>
+#include <mbgl/util/std.hpp>
+
+#include <dirent.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace mbgl;
+
+namespace {
+
+int64_t trianglesArea(const std::vector<Coordinate> &points, const std::vector<uint32_t> &triangles) {
+    int64_t sum = 0;
+    for (std::size_t i = 0; i < triangles.size(); i += 3) {
+        const Coordinate &a = points[triangles[i]];
+        const Coordinate &b = points[triangles[i + 1]];
+        const Coordinate &c = points[triangles[i + 2]];
+        sum += std::abs(int64_t(a.x - c.x) * (b.y - a.y) - int64_t(a.x - b.x) * (c.y - a.y));
+    }
+    return sum;
+}
+
+// Adds up the area of the triangles that the bucket wrote to the buffers. It doesn't have
+// more than one group, so the elements refer to the vertices directly.
+int64_t bucketArea(const FillVertexBuffer &vertexBuffer,
+                   const TriangleElementsBuffer &triangleElementsBuffer) {
+    const auto vertices = reinterpret_cast<const int16_t *>(vertexBuffer.data());
+    const auto elements = reinterpret_cast<const uint16_t *>(triangleElementsBuffer.data());
+    std::vector<Coordinate> points;
+    for (std::size_t i = 0; i < vertexBuffer.index(); i++) {
+        points.emplace_back(vertices[i * 2], vertices[i * 2 + 1]);
+    }
+    return trianglesArea(points, std::vector<uint32_t>(elements,
+                                                       elements + triangleElementsBuffer.index() * 3));
+}
+
+// Splits the points into rings of the given sizes.
+std::vector<GeometryLine> rings(const std::vector<Coordinate> &points,
+                                const std::vector<std::size_t> &sizes) {
+    std::vector<GeometryLine> result;
+    const Coordinate *begin = points.data();
+    for (const std::size_t size : sizes) {
+        result.emplace_back(begin, begin + size);
+        begin += size;
+    }
+    return result;
+}
+
+std::vector<std::string> readTiles(const std::string &directory) {
+    std::vector<std::string> tiles;
+    DIR *dir = opendir(directory.c_str());
+    if (!dir) {
+        return tiles;
+    }
+    while (dirent *entry = readdir(dir)) {
+        const std::string name = entry->d_name;
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".pbf") == 0) {
+            tiles.push_back(util::read_file(directory + "/" + name));
+        }
+    }
+    closedir(dir);
+    return tiles;
+}
+
+// Collects the polygon features of all layers of the tile, with their geometries decoded. They
+// refer to the tile and its data.
+void readPolygons(const VectorTile &tile, const std::string &data,
+                  std::vector<util::ptr<const GeometryTileFeature>> &result) {
+    pbf message(reinterpret_cast<const unsigned char *>(data.data()), data.size());
+    while (message.next()) {
+        if (message.tag != 3) {
+            message.skip();
+            continue;
+        }
+        pbf layerMessage = message.message();
+        while (layerMessage.next(1)) {
+            const auto layer = tile.getLayer(layerMessage.string());
+            for (std::size_t i = 0; layer && i < layer->featureCount(); i++) {
+                auto feature = layer->getFeature(i);
+                if (feature->getType() == FeatureType::Polygon) {
+                    feature->getGeometries();
+                    result.push_back(feature);
+                }
+            }
+        }
+    }
+}
+
+double elapsedSeconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+TEST(Earcut, Square) {
+    const std::vector<Coordinate> points = { { 0, 0 }, { 10, 0 }, { 10, 10 }, { 0, 10 } };
+    std::vector<uint32_t> triangles;
+    util::Earcut earcut;
+    EXPECT_TRUE(earcut(rings(points, { 4 }), triangles));
+    EXPECT_EQ(6u, triangles.size());
+    EXPECT_EQ(200, trianglesArea(points, triangles));
+}
+
+TEST(Earcut, Holes) {
+    // Both windings of the outer ring, with two holes that touch each other.
+    for (const bool reverse : { false, true }) {
+        std::vector<Coordinate> points = { { 0, 0 }, { 100, 0 }, { 100, 100 }, { 0, 100 } };
+        if (reverse) {
+            std::reverse(points.begin(), points.end());
+        }
+        points.insert(points.end(), { { 10, 10 }, { 10, 50 }, { 50, 50 }, { 50, 10 } });
+        points.insert(points.end(), { { 50, 50 }, { 50, 90 }, { 90, 90 }, { 90, 50 } });
+
+        std::vector<uint32_t> triangles;
+        util::Earcut earcut;
+        EXPECT_TRUE(earcut(rings(points, { 4, 4, 4 }), triangles));
+        EXPECT_EQ(2 * (10000 - 1600 - 1600), trianglesArea(points, triangles));
+    }
+}
+
+TEST(Earcut, Concave) {
+    // A comb with many teeth, which is large enough to use the z-order hash.
+    std::vector<Coordinate> points;
+    for (int16_t i = 0; i < 50; i++) {
+        points.emplace_back(i * 20, 0);
+        points.emplace_back(i * 20 + 10, 100);
+    }
+    points.emplace_back(1000, 0);
+    points.emplace_back(1000, -100);
+    points.emplace_back(0, -100);
+
+    std::vector<uint32_t> triangles;
+    util::Earcut earcut;
+    EXPECT_TRUE(earcut(rings(points, { points.size() }), triangles));
+    EXPECT_EQ((points.size() - 2) * 3, triangles.size());
+    EXPECT_EQ(std::abs(util::Earcut::signedArea(rings(points, { points.size() }).front())),
+              trianglesArea(points, triangles));
+}
+
+TEST(Earcut, SelfIntersecting) {
+    util::Earcut earcut;
+    std::vector<uint32_t> triangles;
+
+    // A bow tie.
+    const std::vector<Coordinate> bowtie = { { 0, 0 }, { 10, 10 }, { 10, 0 }, { 0, 10 } };
+    EXPECT_FALSE(earcut(rings(bowtie, { 4 }), triangles));
+
+    // A hole that sticks out of the outer ring.
+    const std::vector<Coordinate> crossing = { { 0, 0 }, { 10, 0 }, { 10, 10 }, { 0, 10 },
+                                               { 5, 5 }, { 5, 20 }, { 8, 20 }, { 8, 5 } };
+    EXPECT_FALSE(earcut(rings(crossing, { 4, 4 }), triangles));
+
+    // The same instance works afterwards.
+    const std::vector<Coordinate> square = { { 0, 0 }, { 10, 0 }, { 10, 10 }, { 0, 10 } };
+    EXPECT_TRUE(earcut(rings(square, { 4 }), triangles));
+    EXPECT_EQ(200, trianglesArea(square, triangles));
+}
+
+TEST(Earcut, FillBucketSelfIntersecting) {
+    // A square, followed by a closed bow tie whose lobes cancel out.
+    const std::vector<Coordinate> points = { { 20, 0 }, { 30, 0 }, { 30, 10 }, { 20, 10 }, { 20, 0 },
+                                             { 0, 0 }, { 10, 10 }, { 10, 0 }, { 0, 10 }, { 0, 0 } };
+    const std::vector<uint32_t> offsets = { 0, 5, 10 };
+    const GeometryCollection geometry(points.data(), offsets.data(), 2);
+
+    std::vector<int64_t> areas;
+    for (const auto triangulation : { TriangulationType::Earcut, TriangulationType::Tessellator }) {
+        FillVertexBuffer vertexBuffer;
+        TriangleElementsBuffer triangleElementsBuffer;
+        LineElementsBuffer lineElementsBuffer;
+
+        FillBucket bucket(vertexBuffer, triangleElementsBuffer, lineElementsBuffer);
+        bucket.layout.triangulation = triangulation;
+        bucket.addGeometry(geometry);
+        areas.push_back(bucketArea(vertexBuffer, triangleElementsBuffer));
+    }
+
+    // The earcut path hands the bow tie to the tessellator, which fills one of its lobes.
+    EXPECT_EQ(areas[1], areas[0]);
+    EXPECT_EQ(2 * (100 + 25), areas[0]);
+}
+
+// Reports how long it takes to build the fill buckets of the vector tiles of the test suite with
+// either triangulation.
+TEST(Earcut, DISABLED_Benchmark) {
+    const std::vector<std::string> data = readTiles("test/suite/tiles");
+    std::vector<std::unique_ptr<VectorTile>> tiles;
+    std::vector<std::vector<util::ptr<const GeometryTileFeature>>> features(data.size());
+    std::size_t featureCount = 0;
+    for (std::size_t i = 0; i < data.size(); i++) {
+        tiles.emplace_back(util::make_unique<VectorTile>(
+            pbf(reinterpret_cast<const unsigned char *>(data[i].data()), data[i].size())));
+        readPolygons(*tiles.back(), data[i], features[i]);
+        featureCount += features[i].size();
+    }
+    if (featureCount == 0) {
+        test::reportBenchmark("earcut skipped: no polygons in test/suite/tiles");
+        return;
+    }
+
+    for (const auto triangulation : { TriangulationType::Earcut, TriangulationType::Tessellator }) {
+        const int rounds = 5;
+        std::size_t triangles = 0;
+        std::size_t vertices = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int round = 0; round < rounds; round++) {
+            for (const auto &tileFeatures : features) {
+                // Every tile has its own buffers.
+                FillVertexBuffer vertexBuffer;
+                TriangleElementsBuffer triangleElementsBuffer;
+                LineElementsBuffer lineElementsBuffer;
+
+                FillBucket bucket(vertexBuffer, triangleElementsBuffer, lineElementsBuffer);
+                bucket.layout.triangulation = triangulation;
+                for (const auto &feature : tileFeatures) {
+                    bucket.addGeometry(feature->getGeometries());
+                }
+
+                triangles += triangleElementsBuffer.index();
+                vertices += vertexBuffer.index();
+            }
+        }
+        const double seconds = elapsedSeconds(start);
+
+        test::reportBenchmark("%s: %.1f ms per round (%zu tiles, %zu polygons, %zu triangles, "
+                              "%zu vertices)", TriangulationTypeClass(triangulation).c_str(),
+                              seconds * 1000 / rounds, tiles.size(), featureCount,
+                              triangles / rounds, vertices / rounds);
+    }
+}
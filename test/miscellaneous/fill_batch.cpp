@@ -0,0 +1,107 @@
+#include "../fixtures/util.hpp"
+
+#include <mbgl/renderer/fill_batch.hpp>
+#include <mbgl/renderer/fill_bucket.hpp>
+#include <mbgl/util/std.hpp>
+
+#include <cmath>
+#include <memory>
+#include <vector>
+
+using namespace mbgl;
+
+namespace {
+
+// The buffers of a tile with a single fill bucket that holds a convex polygon.
+struct TestTile {
+    explicit TestTile(std::size_t vertexCount) {
+        vertexBuffer.retain();
+        triangleElementsBuffer.retain();
+
+        std::vector<Coordinate> points;
+        for (std::size_t i = 0; i < vertexCount; i++) {
+            const double angle = 2 * M_PI * i / vertexCount;
+            points.emplace_back(2048 + 2000 * std::cos(angle), 2048 + 2000 * std::sin(angle));
+        }
+        const std::vector<uint32_t> offsets = { 0, uint32_t(points.size()) };
+
+        bucket = util::make_unique<FillBucket>(vertexBuffer, triangleElementsBuffer, lineElementsBuffer);
+        bucket->addGeometry(GeometryCollection(points.data(), offsets.data(), 1));
+    }
+
+    FillVertexBuffer vertexBuffer;
+    TriangleElementsBuffer triangleElementsBuffer;
+    LineElementsBuffer lineElementsBuffer;
+    std::unique_ptr<FillBucket> bucket;
+};
+
+std::vector<const FillBucket*> buckets(const std::vector<std::unique_ptr<TestTile>>& tiles) {
+    std::vector<const FillBucket*> result;
+    for (const auto& tile : tiles) {
+        result.push_back(tile->bucket.get());
+    }
+    return result;
+}
+
+}
+
+TEST(FillBatch, Tiles) {
+    std::vector<std::unique_ptr<TestTile>> tiles;
+    tiles.emplace_back(util::make_unique<TestTile>(4));
+    tiles.emplace_back(util::make_unique<TestTile>(8));
+
+    FillBatch batch;
+    EXPECT_TRUE(batch.update(buckets(tiles)));
+    EXPECT_EQ(1u, batch.groupCount());
+    EXPECT_EQ(12u, batch.vertexCount());
+    EXPECT_EQ(2u + 6u, batch.triangleCount());
+
+    // The same buckets are kept, others replace the contents.
+    EXPECT_TRUE(batch.update(buckets(tiles)));
+    EXPECT_EQ(12u, batch.vertexCount());
+    tiles.emplace_back(util::make_unique<TestTile>(4));
+    EXPECT_TRUE(batch.update(buckets(tiles)));
+    EXPECT_EQ(16u, batch.vertexCount());
+    tiles.erase(tiles.begin());
+    EXPECT_TRUE(batch.update(buckets(tiles)));
+    EXPECT_EQ(12u, batch.vertexCount());
+    EXPECT_EQ(6u + 2u, batch.triangleCount());
+}
+
+TEST(FillBatch, Groups) {
+    // Each group holds at most 65535 vertices.
+    std::vector<std::unique_ptr<TestTile>> tiles;
+    tiles.emplace_back(util::make_unique<TestTile>(40000));
+    tiles.emplace_back(util::make_unique<TestTile>(40000));
+
+    FillBatch batch;
+    EXPECT_TRUE(batch.update(buckets(tiles)));
+    EXPECT_EQ(2u, batch.groupCount());
+    EXPECT_EQ(tiles[0]->vertexBuffer.index() + tiles[1]->vertexBuffer.index(), batch.vertexCount());
+    EXPECT_EQ(tiles[0]->triangleElementsBuffer.index() + tiles[1]->triangleElementsBuffer.index(),
+              batch.triangleCount());
+}
+
+TEST(FillBatch, Chunks) {
+    // Tiles beyond the matrices of the shader start another group.
+    std::vector<std::unique_ptr<TestTile>> tiles;
+    for (std::size_t i = 0; i < FillBatch::maxTiles + 1; i++) {
+        tiles.emplace_back(util::make_unique<TestTile>(4));
+    }
+
+    FillBatch batch;
+    EXPECT_TRUE(batch.update(buckets(tiles)));
+    EXPECT_EQ(2u, batch.groupCount());
+    EXPECT_EQ(4 * tiles.size(), batch.vertexCount());
+}
+
+TEST(FillBatch, Empty) {
+    FillVertexBuffer vertexBuffer;
+    TriangleElementsBuffer triangleElementsBuffer;
+    LineElementsBuffer lineElementsBuffer;
+    FillBucket bucket(vertexBuffer, triangleElementsBuffer, lineElementsBuffer);
+
+    FillBatch batch;
+    EXPECT_TRUE(batch.update({ &bucket }));
+    EXPECT_EQ(0u, batch.groupCount());
+}
@@ -0,0 +1,269 @@
+#include "../fixtures/util.hpp"
+
+#include <mbgl/map/environment.hpp>
+#include <mbgl/map/sprite.hpp>
+#include <mbgl/map/vector_tile_data.hpp>
+#include <mbgl/renderer/symbol_bucket.hpp>
+#include <mbgl/geometry/glyph_atlas.hpp>
+#include <mbgl/geometry/sprite_atlas.hpp>
+#include <mbgl/storage/file_source.hpp>
+#include <mbgl/style/style.hpp>
+#include <mbgl/style/style_layer.hpp>
+#include <mbgl/style/style_layer_group.hpp>
+#include <mbgl/style/style_source.hpp>
+#include <mbgl/text/glyph_store.hpp>
+#include <mbgl/util/std.hpp>
+#include <mbgl/util/uv_detail.hpp>
+
+#include <uv.h>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace mbgl;
+
+namespace {
+
+// A file source that holds on to the requests until the test answers them.
+class ManualFileSource : public FileSource {
+public:
+    Request *request(const Resource &resource, uv_loop_t *, const Environment &, Callback callback) override {
+        urls.push_back(resource.url);
+        callbacks.push_back(callback);
+        return nullptr;
+    }
+    void cancel(Request *) override {}
+    void setPriority(Request *, double) override {}
+    void request(const Resource &, const Environment &, Callback) override {}
+    void abort(const Environment &) override {}
+
+    // Answers the oldest pending request.
+    void respond(const Response &res) {
+        ASSERT_FALSE(callbacks.empty());
+        Callback callback = callbacks.front();
+        callbacks.erase(callbacks.begin());
+        callback(res);
+    }
+
+    std::vector<std::string> urls;
+    std::vector<Callback> callbacks;
+};
+
+// Minimal protobuf writer for building tiles and glyph ranges in memory.
+class Writer {
+public:
+    void varint(uint64_t value) {
+        while (value >= 0x80) {
+            data.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        data.push_back(static_cast<char>(value));
+    }
+
+    void key(uint32_t tag, uint32_t type) { varint((tag << 3) | type); }
+    void bytes(uint32_t tag, const std::string& value) { key(tag, 2); varint(value.size()); data += value; }
+    void field(uint32_t tag, uint64_t value) { key(tag, 0); varint(value); }
+
+    std::string data;
+};
+
+// Builds a tile with a single "poi" layer that contains one point named "Ab".
+std::string buildTile() {
+    Writer layer;
+    layer.bytes(1, "poi");
+    layer.bytes(3, "name");
+
+    Writer value;
+    value.bytes(1, "Ab");
+    layer.bytes(4, value.data);
+
+    Writer tags;
+    tags.varint(0);
+    tags.varint(0);
+
+    Writer geometry;
+    geometry.varint((1 << 3) | 1); // moveTo
+    geometry.varint(2048 << 1);
+    geometry.varint(2048 << 1);
+
+    Writer feature;
+    feature.bytes(2, tags.data);
+    feature.field(3, uint64_t(FeatureType::Point));
+    feature.bytes(4, geometry.data);
+    layer.bytes(2, feature.data);
+
+    Writer tile;
+    tile.bytes(3, layer.data);
+    return tile.data;
+}
+
+// Builds the glyph range 0-255 with the glyphs of "Ab".
+std::string buildGlyphs() {
+    Writer stack;
+    stack.bytes(1, "Test");
+    stack.bytes(2, "0-255");
+    for (const uint32_t id : { 'A', 'b' }) {
+        Writer glyph;
+        glyph.field(1, id);
+        glyph.bytes(2, std::string((10 + 6) * (10 + 6), '\x80'));
+        glyph.field(3, 10);
+        glyph.field(4, 10);
+        glyph.field(7, 12);
+        stack.bytes(3, glyph.data);
+    }
+
+    Writer glyphs;
+    glyphs.bytes(1, stack.data);
+    return glyphs.data;
+}
+
+const char *styleJSON = R"JSON({
+  "version": 6,
+  "sources": { "test": { "type": "vector" } },
+  "layers": [{
+    "id": "label",
+    "type": "symbol",
+    "source": "test",
+    "source-layer": "poi",
+    "layout": { "text-field": "{name}", "text-font": "Test" }
+  }]
+})JSON";
+
+Response successful(const std::string& data) {
+    Response res;
+    res.status = Response::Successful;
+    res.data = std::make_shared<const std::string>(data);
+    return res;
+}
+
+Response failed() {
+    Response res;
+    res.message = "unavailable";
+    return res;
+}
+
+class GlyphStoreTest : public ::testing::Test {
+protected:
+    GlyphStoreTest() {
+        style->loadJSON(reinterpret_cast<const uint8_t *>(styleJSON));
+        glyphStore.setURL("test://{fontstack}/{range}.pbf");
+    }
+
+    ~GlyphStoreTest() {
+        worker.reset();
+        uv_run(loop, UV_RUN_DEFAULT);
+
+        // The atlases abandon their textures, which the environment has to delete.
+        glyphAtlas.reset();
+        spriteAtlas.reset();
+        env.performCleanup();
+    }
+
+    util::ptr<VectorTileData> tile() {
+        return std::make_shared<VectorTileData>(Tile::ID(10, 0, 0), 22, style, *glyphAtlas,
+                                                glyphStore, *spriteAtlas, sprite, info);
+    }
+
+    // Runs the loop until the tile's parse job is done.
+    void parse(const util::ptr<VectorTileData>& data) {
+        const std::size_t before = notifications;
+        data->load(successful(buildTile()), *worker, notify());
+        while (notifications == before) {
+            uv_run(loop, UV_RUN_ONCE);
+        }
+    }
+
+    // Resumes a partial tile the way its source does, and waits for the parse job it starts
+    // once the glyphs are available.
+    void resume(const util::ptr<VectorTileData>& data) {
+        const std::size_t before = notifications;
+        const bool partial = data->state == TileData::State::partial;
+        data->resume(*worker, notify());
+        if (partial && glyphStore.hasGlyphRanges("Test", { GlyphRange(0, 255) })) {
+            while (notifications == before) {
+                uv_run(loop, UV_RUN_ONCE);
+            }
+        }
+    }
+
+    // The callback for parse jobs and arriving glyphs, which a source uses to update the map.
+    std::function<void()> notify() {
+        return [this] { notifications++; };
+    }
+
+    bool hasText(const util::ptr<VectorTileData>& data) {
+        const auto bucket = data->getBucket(*style->layers->layers.front());
+        return bucket && static_cast<SymbolBucket *>(bucket)->hasTextData();
+    }
+
+    std::size_t notifications = 0;
+
+    ManualFileSource fileSource;
+    Environment env { fileSource };
+    EnvironmentScope scope { env, ThreadType::Map, "Map" };
+    uv_loop_t *loop = uv_default_loop();
+    std::unique_ptr<uv::worker> worker = util::make_unique<uv::worker>(loop, 1, "Test Worker");
+
+    SourceInfo info;
+    util::ptr<Style> style = std::make_shared<Style>();
+    std::unique_ptr<GlyphAtlas> glyphAtlas = util::make_unique<GlyphAtlas>(1024, 1024);
+    GlyphStore glyphStore { env };
+    std::unique_ptr<SpriteAtlas> spriteAtlas = util::make_unique<SpriteAtlas>(512, 512);
+    util::ptr<Sprite> sprite = Sprite::Create("", 1, env);
+};
+
+}
+
+TEST_F(GlyphStoreTest, PartialTile) {
+    auto data = tile();
+    parse(data);
+    EXPECT_EQ(TileData::State::partial, data->state);
+
+    resume(data);
+    EXPECT_EQ(TileData::State::partial, data->state);
+    ASSERT_EQ(1u, fileSource.urls.size());
+    EXPECT_EQ("test://Test/0-255.pbf", fileSource.urls.front());
+
+    // The arriving range lets the tile finish.
+    fileSource.respond(successful(buildGlyphs()));
+    resume(data);
+    EXPECT_EQ(TileData::State::parsed, data->state);
+    EXPECT_TRUE(hasText(data));
+    EXPECT_EQ(1u, fileSource.urls.size());
+}
+
+TEST_F(GlyphStoreTest, FailedRange) {
+    auto first = tile();
+    parse(first);
+    resume(first);
+    ASSERT_EQ(1u, fileSource.urls.size());
+
+    // The waiting tile goes ahead without the glyphs instead of requesting them again.
+    fileSource.respond(failed());
+    resume(first);
+    EXPECT_EQ(TileData::State::parsed, first->state);
+    EXPECT_FALSE(hasText(first));
+    EXPECT_EQ(1u, fileSource.urls.size());
+
+    // Tiles that are parsed before the retry delay passed don't request the range either.
+    auto second = tile();
+    parse(second);
+    EXPECT_EQ(TileData::State::parsed, second->state);
+    EXPECT_EQ(1u, fileSource.urls.size());
+
+    // Afterwards, the next tile requests it again.
+    glyphStore.setRetryDelay(std::chrono::steady_clock::duration::zero());
+    auto third = tile();
+    parse(third);
+    EXPECT_EQ(TileData::State::partial, third->state);
+    resume(third);
+    EXPECT_EQ(2u, fileSource.urls.size());
+
+    fileSource.respond(successful(buildGlyphs()));
+    resume(third);
+    EXPECT_EQ(TileData::State::parsed, third->state);
+    EXPECT_TRUE(hasText(third));
+}
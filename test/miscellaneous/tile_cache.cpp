@@ -0,0 +1,172 @@
+#include "../fixtures/util.hpp"
+#include "../fixtures/stub_file_source.hpp"
+
+#include <mbgl/map/environment.hpp>
+#include <mbgl/map/tile_cache.hpp>
+#include <mbgl/map/tile_data.hpp>
+#include <mbgl/style/style_source.hpp>
+
+#include <memory>
+
+using namespace mbgl;
+
+namespace {
+
+class TestTileData : public TileData {
+public:
+    TestTileData(const Tile::ID& id_, const SourceInfo& source_, std::size_t bytes_)
+        : TileData(id_, source_), bytes(bytes_) {}
+
+    void parse() override {}
+    Bucket* getBucket(const StyleLayer&) override { return nullptr; }
+    std::size_t getByteSize() const override { return bytes; }
+
+    const std::size_t bytes;
+};
+
+class TileCacheTest : public ::testing::Test {
+protected:
+    util::ptr<TileData> tile(int32_t x, std::size_t bytes) {
+        return std::make_shared<TestTileData>(Tile::ID(10, x, 0), info, bytes);
+    }
+
+    StubFileSource fileSource;
+    Environment env { fileSource };
+    EnvironmentScope scope { env, ThreadType::Map, "Map" };
+    SourceInfo info;
+};
+
+const Tile::ID a(10, 1, 0);
+const Tile::ID b(10, 2, 0);
+const Tile::ID c(10, 3, 0);
+const Tile::ID d(10, 4, 0);
+
+}
+
+TEST_F(TileCacheTest, Disabled) {
+    TileCache cache;
+    cache.add(a, tile(1, 100));
+    EXPECT_FALSE(cache.has(a));
+    EXPECT_EQ(1u, cache.getStats().evictions);
+}
+
+TEST_F(TileCacheTest, LeastRecentlyUsed) {
+    TileCache cache;
+    cache.setSize(300);
+    cache.add(a, tile(1, 100));
+    cache.add(b, tile(2, 100));
+    cache.add(c, tile(3, 100));
+    EXPECT_EQ(3u, cache.getStats().tiles);
+    EXPECT_EQ(300u, cache.getStats().bytes);
+
+    // Taking a tile out and adding it back makes it the most recently used one.
+    const util::ptr<TileData> data = cache.get(a);
+    ASSERT_TRUE(data.get());
+    EXPECT_EQ(a, data->id);
+    EXPECT_FALSE(cache.has(a));
+    cache.add(a, data);
+
+    cache.add(d, tile(4, 100));
+    EXPECT_TRUE(cache.has(a));
+    EXPECT_FALSE(cache.has(b));
+    EXPECT_TRUE(cache.has(c));
+    EXPECT_TRUE(cache.has(d));
+
+    // Adding a cached tile again replaces it and makes it the most recently used one.
+    cache.add(c, tile(3, 100));
+    cache.add(b, tile(2, 100));
+    EXPECT_FALSE(cache.has(a));
+    EXPECT_TRUE(cache.has(c));
+    EXPECT_EQ(3u, cache.getStats().tiles);
+    EXPECT_EQ(2u, cache.getStats().evictions);
+}
+
+TEST_F(TileCacheTest, ByteBudget) {
+    TileCache cache;
+    cache.setSize(250);
+    cache.add(a, tile(1, 100));
+    cache.add(b, tile(2, 100));
+
+    // A larger tile evicts as many of the oldest tiles as it needs.
+    cache.add(c, tile(3, 200));
+    EXPECT_FALSE(cache.has(a));
+    EXPECT_FALSE(cache.has(b));
+    EXPECT_TRUE(cache.has(c));
+    EXPECT_EQ(200u, cache.getStats().bytes);
+    EXPECT_EQ(2u, cache.getStats().evictions);
+
+    cache.add(d, tile(4, 50));
+    EXPECT_TRUE(cache.has(c));
+    EXPECT_TRUE(cache.has(d));
+    EXPECT_EQ(250u, cache.getStats().bytes);
+}
+
+TEST_F(TileCacheTest, Oversize) {
+    TileCache cache;
+    cache.setSize(250);
+    cache.add(a, tile(1, 100));
+
+    // A tile that would never fit is dropped without evicting others.
+    cache.add(b, tile(2, 300));
+    EXPECT_FALSE(cache.has(b));
+    EXPECT_TRUE(cache.has(a));
+    EXPECT_EQ(100u, cache.getStats().bytes);
+    EXPECT_EQ(1u, cache.getStats().evictions);
+
+    // It replaces a cached tile with the same ID all the same.
+    cache.add(a, tile(1, 300));
+    EXPECT_FALSE(cache.has(a));
+    EXPECT_EQ(0u, cache.getStats().bytes);
+    EXPECT_EQ(0u, cache.getStats().tiles);
+}
+
+TEST_F(TileCacheTest, Shrink) {
+    TileCache cache;
+    cache.setSize(400);
+    cache.add(a, tile(1, 100));
+    cache.add(b, tile(2, 100));
+    cache.add(c, tile(3, 100));
+    cache.add(d, tile(4, 100));
+
+    cache.setSize(250);
+    EXPECT_EQ(250u, cache.getSize());
+    EXPECT_FALSE(cache.has(a));
+    EXPECT_FALSE(cache.has(b));
+    EXPECT_TRUE(cache.has(c));
+    EXPECT_TRUE(cache.has(d));
+    EXPECT_EQ(200u, cache.getStats().bytes);
+    EXPECT_EQ(2u, cache.getStats().evictions);
+
+    cache.setSize(0);
+    EXPECT_FALSE(cache.has(c));
+    EXPECT_FALSE(cache.has(d));
+    EXPECT_EQ(0u, cache.getStats().bytes);
+    EXPECT_EQ(0u, cache.getStats().tiles);
+    EXPECT_EQ(4u, cache.getStats().evictions);
+}
+
+TEST_F(TileCacheTest, Stats) {
+    TileCache cache;
+    cache.setSize(1000);
+    cache.add(a, tile(1, 100));
+    cache.add(b, tile(2, 100));
+
+    EXPECT_FALSE(cache.get(c).get());
+    EXPECT_TRUE(cache.get(a).get());
+    EXPECT_FALSE(cache.get(a).get());
+    EXPECT_EQ(1u, cache.getStats().hits);
+    EXPECT_EQ(2u, cache.getStats().misses);
+    EXPECT_EQ(0u, cache.getStats().evictions);
+    EXPECT_EQ(1u, cache.getStats().tiles);
+    EXPECT_EQ(100u, cache.getStats().bytes);
+
+    // Removing and clearing aren't evictions.
+    cache.remove(b);
+    EXPECT_EQ(0u, cache.getStats().tiles);
+    cache.add(a, tile(1, 100));
+    cache.clear();
+    EXPECT_FALSE(cache.has(a));
+    EXPECT_EQ(0u, cache.getStats().bytes);
+    EXPECT_EQ(0u, cache.getStats().evictions);
+    EXPECT_EQ(1u, cache.getStats().hits);
+}
@@ -0,0 +1,153 @@
+#include "../fixtures/util.hpp"
+#include "../fixtures/stub_file_source.hpp"
+
+#include <mbgl/map/environment.hpp>
+#include <mbgl/map/tile_data.hpp>
+#include <mbgl/style/style_source.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using namespace mbgl;
+
+namespace {
+
+// A parsed tile whose buffers only count the bytes they would upload.
+class TestTileData : public TileData {
+public:
+    TestTileData(const Tile::ID& id_, const SourceInfo& source_, std::vector<std::size_t> buffers_)
+        : TileData(id_, source_), buffers(buffers_) {
+        state = State::parsed;
+    }
+
+    void parse() override {}
+    Bucket* getBucket(const StyleLayer&) override { return nullptr; }
+
+    // Whether all buffers have been uploaded.
+    bool complete() const { return next == buffers.size(); }
+
+    const std::vector<std::size_t> buffers;
+    std::size_t next = 0;
+
+protected:
+    bool uploadNext(std::size_t& bytes) override {
+        if (complete()) {
+            return false;
+        }
+        bytes += buffers[next++];
+        return !complete();
+    }
+};
+
+class TileDataTest : public ::testing::Test {
+protected:
+    std::shared_ptr<TestTileData> tile(int32_t x, std::vector<std::size_t> buffers) {
+        return std::make_shared<TestTileData>(Tile::ID(10, x, 0), info, buffers);
+    }
+
+    // Uploads the tiles within one frame's budget, the way a source does.
+    std::size_t frame(const std::vector<std::shared_ptr<TestTileData>>& tiles, std::size_t budget) {
+        std::size_t bytes = 0;
+        for (const auto& data : tiles) {
+            if (!data->ready() && bytes < budget) {
+                bytes += data->upload(budget - bytes);
+            }
+        }
+        return bytes;
+    }
+
+    StubFileSource fileSource;
+    Environment env { fileSource };
+    EnvironmentScope scope { env, ThreadType::Map, "Map" };
+    SourceInfo info;
+};
+
+}
+
+TEST_F(TileDataTest, Ready) {
+    auto data = tile(1, { 100, 100, 100 });
+
+    EXPECT_EQ(200u, data->upload(150));
+    EXPECT_EQ(2u, data->next);
+    EXPECT_FALSE(data->ready());
+
+    // The tile is ready as soon as the last buffer went up, even though it used up the budget.
+    EXPECT_EQ(100u, data->upload(100));
+    EXPECT_TRUE(data->complete());
+    EXPECT_TRUE(data->ready());
+    EXPECT_EQ(0u, data->upload(100));
+}
+
+TEST_F(TileDataTest, LastBuffer) {
+    auto data = tile(1, { 100, 100 });
+
+    EXPECT_EQ(100u, data->upload(100));
+    EXPECT_FALSE(data->ready());
+
+    // A budget that isn't used up lets the tile finish within the same call.
+    EXPECT_EQ(100u, data->upload(150));
+    EXPECT_TRUE(data->complete());
+    EXPECT_TRUE(data->ready());
+}
+
+TEST_F(TileDataTest, Unparsed) {
+    auto data = tile(1, { 100 });
+    data->state = TileData::State::partial;
+    EXPECT_EQ(0u, data->upload(1000));
+    EXPECT_FALSE(data->ready());
+    EXPECT_EQ(0u, data->next);
+
+    data->state = TileData::State::parsed;
+    EXPECT_EQ(100u, data->upload(1000));
+    EXPECT_TRUE(data->ready());
+}
+
+TEST_F(TileDataTest, Oversize) {
+    // A buffer that's larger than the budget still goes up, on its own.
+    auto data = tile(1, { 1000, 100 });
+    EXPECT_EQ(1000u, data->upload(100));
+    EXPECT_EQ(1u, data->next);
+    EXPECT_FALSE(data->ready());
+
+    EXPECT_EQ(100u, data->upload(100));
+    EXPECT_TRUE(data->ready());
+}
+
+TEST_F(TileDataTest, Budget) {
+    const std::vector<std::shared_ptr<TestTileData>> tiles = {
+        tile(1, { 100, 100, 100 }),
+        tile(2, { 50, 50 }),
+        tile(3, { 200 }),
+        tile(4, { 100, 100, 100, 100 }),
+    };
+
+    const std::size_t budget = 250;
+    std::vector<std::size_t> frames;
+    while (frames.size() < 20) {
+        const std::size_t bytes = frame(tiles, budget);
+        if (bytes == 0 && std::all_of(tiles.begin(), tiles.end(),
+                                      [](const std::shared_ptr<TestTileData>& data) {
+                                          return data->ready();
+                                      })) {
+            break;
+        }
+        frames.push_back(bytes);
+
+        // A frame stops within one buffer of the budget.
+        EXPECT_LT(bytes, budget + 200);
+
+        // Tiles are ready as soon as they uploaded everything, and go in order.
+        for (std::size_t i = 0; i < tiles.size(); i++) {
+            EXPECT_EQ(tiles[i]->complete(), tiles[i]->ready());
+            if (i > 0 && tiles[i]->next > 0) {
+                EXPECT_TRUE(tiles[i - 1]->complete());
+            }
+        }
+    }
+
+    EXPECT_EQ((std::vector<std::size_t> { 300, 300, 300, 100 }), frames);
+    for (const auto& data : tiles) {
+        EXPECT_TRUE(data->ready());
+    }
+}
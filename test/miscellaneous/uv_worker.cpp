@@ -0,0 +1,108 @@
+#include "../fixtures/util.hpp"
+
+#include <mbgl/util/uv_detail.hpp>
+#include <mbgl/util/std.hpp>
+
+#include <uv.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Occupies the only worker thread until released, so that everything sent
+// afterwards stays queued.
+struct Gate {
+    std::atomic<bool> entered { false };
+    std::atomic<bool> open { false };
+
+    void block(uv::worker& worker) {
+        new uv::work<Gate*>(worker, 0, [](Gate*& gate) {
+            gate->entered = true;
+            while (!gate->open) {
+                std::this_thread::yield();
+            }
+        }, [](Gate*&) {}, this);
+
+        while (!entered) {
+            std::this_thread::yield();
+        }
+    }
+};
+
+}
+
+TEST(Worker, Priority) {
+    uv_loop_t* loop = uv_default_loop();
+    auto worker = mbgl::util::make_unique<uv::worker>(loop, 1, "Test Worker");
+
+    Gate gate;
+    gate.block(*worker);
+
+    std::vector<int> order;
+    std::vector<int> completed;
+    auto send = [&](int value, double priority) {
+        return new uv::work<int>(*worker, priority, [&order](int& v) {
+            order.push_back(v);
+        }, [&completed](int& v) {
+            completed.push_back(v);
+        }, value);
+    };
+
+    send(1, 5);
+    auto two = send(2, 1);
+    send(3, 3);
+    auto four = send(4, 3);
+    auto five = send(5, 0);
+
+    // Equal priorities keep their submission order.
+    EXPECT_TRUE(two->setPriority(4));
+    EXPECT_TRUE(four->setPriority(3));
+    EXPECT_TRUE(five->cancel());
+
+    uv_worker_stats_t stats = worker->stats();
+    EXPECT_EQ(4u, stats.queued);
+    EXPECT_EQ(5u, stats.max_queued);
+    EXPECT_EQ(1u, stats.canceled);
+    EXPECT_EQ(1u, stats.started);
+
+    gate.open = true;
+    worker.reset();
+    uv_run(loop, UV_RUN_DEFAULT);
+
+    EXPECT_EQ((std::vector<int> { 3, 4, 2, 1 }), order);
+    EXPECT_EQ(order, completed);
+}
+
+TEST(Worker, CancelStarted) {
+    uv_loop_t* loop = uv_default_loop();
+    auto worker = mbgl::util::make_unique<uv::worker>(loop, 1, "Test Worker");
+
+    std::atomic<bool> entered { false };
+    std::atomic<bool> open { false };
+    bool completed = false;
+
+    auto work = new uv::work<int>(*worker, 0, [&](int&) {
+        entered = true;
+        while (!open) {
+            std::this_thread::yield();
+        }
+    }, [&](int&) {
+        completed = true;
+    }, 0);
+
+    while (!entered) {
+        std::this_thread::yield();
+    }
+
+    // Jobs that already started can be neither reprioritized nor canceled.
+    EXPECT_FALSE(work->setPriority(1));
+    EXPECT_FALSE(work->cancel());
+
+    open = true;
+    worker.reset();
+    uv_run(loop, UV_RUN_DEFAULT);
+
+    EXPECT_TRUE(completed);
+}
@@ -0,0 +1,358 @@
+#include "../fixtures/util.hpp"
+
+#include <mbgl/map/vector_tile.hpp>
+#include <mbgl/style/filter_expression.hpp>
+
+#include <rapidjson/document.h>
+
+#include <algorithm>
+#include <chrono>
+#include <set>
+
+using namespace mbgl;
+
+namespace {
+
+// Minimal protobuf writer for building vector tiles in memory.
+class Writer {
+public:
+    void varint(uint64_t value) {
+        while (value >= 0x80) {
+            data.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        data.push_back(static_cast<char>(value));
+    }
+
+    void key(uint32_t tag, uint32_t type) { varint((tag << 3) | type); }
+    void bytes(uint32_t tag, const std::string& value) { key(tag, 2); varint(value.size()); data += value; }
+    void field(uint32_t tag, uint64_t value) { key(tag, 0); varint(value); }
+
+    std::string data;
+};
+
+uint32_t zigzag(int32_t n) {
+    return (n << 1) ^ (n >> 31);
+}
+
+// Builds a tile with a single "road" layer containing `count` two-ring polygons.
+std::string buildTile(std::size_t count) {
+    Writer layer;
+    layer.bytes(1, "road");
+    layer.bytes(3, "class");
+    layer.bytes(3, "oneway");
+
+    Writer value;
+    value.bytes(1, "street");
+    layer.bytes(4, value.data);
+    value.data.clear();
+    value.field(5, 1);
+    layer.bytes(4, value.data);
+
+    for (std::size_t i = 0; i < count; ++i) {
+        Writer tags;
+        tags.varint(0);
+        tags.varint(0);
+        tags.varint(1);
+        tags.varint(1);
+
+        Writer geometry;
+        for (int ring = 0; ring < 2; ++ring) {
+            geometry.varint((1 << 3) | 1); // moveTo
+            geometry.varint(zigzag(ring * 10 + 1));
+            geometry.varint(zigzag(ring * 10 + 1));
+            geometry.varint((3 << 3) | 2); // lineTo
+            geometry.varint(zigzag(8));
+            geometry.varint(zigzag(0));
+            geometry.varint(zigzag(0));
+            geometry.varint(zigzag(8));
+            geometry.varint(zigzag(-8));
+            geometry.varint(zigzag(0));
+            geometry.varint((1 << 3) | 7); // closePolygon
+        }
+
+        Writer feature;
+        feature.bytes(2, tags.data);
+        feature.field(3, uint64_t(FeatureType::Polygon));
+        feature.bytes(4, geometry.data);
+        layer.bytes(2, feature.data);
+    }
+
+    Writer tile;
+    tile.bytes(3, layer.data);
+    return tile.data;
+}
+
+// Builds a tile with a "road" layer whose keys and values resemble Streets.
+std::string buildStreetsTile(std::size_t count) {
+    const std::vector<std::string> keys = { "class", "type", "oneway", "structure", "layer", "name" };
+    const std::vector<std::string> classes = { "motorway", "main", "street", "street_limited", "service", "path", "major_rail" };
+    const std::vector<std::string> structures = { "none", "bridge", "tunnel" };
+
+    Writer layer;
+    layer.bytes(1, "road");
+    for (const auto& key : keys) {
+        layer.bytes(3, key);
+    }
+
+    // Values: classes, structures, oneway 0/1, layer -1..1, followed by unique names.
+    Writer value;
+    for (const auto& str : classes) {
+        value.data.clear();
+        value.bytes(1, str);
+        layer.bytes(4, value.data);
+    }
+    for (const auto& str : structures) {
+        value.data.clear();
+        value.bytes(1, str);
+        layer.bytes(4, value.data);
+    }
+    const uint32_t onewayBase = classes.size() + structures.size();
+    for (uint64_t oneway = 0; oneway < 2; ++oneway) {
+        value.data.clear();
+        value.field(5, oneway);
+        layer.bytes(4, value.data);
+    }
+    const uint32_t layerBase = onewayBase + 2;
+    for (int32_t level = -1; level <= 1; ++level) {
+        value.data.clear();
+        value.field(6, zigzag(level));
+        layer.bytes(4, value.data);
+    }
+    const uint32_t nameBase = layerBase + 3;
+    for (std::size_t i = 0; i < count; ++i) {
+        value.data.clear();
+        value.bytes(1, "Street " + std::to_string(i));
+        layer.bytes(4, value.data);
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        Writer tags;
+        tags.varint(0); tags.varint(i % classes.size());
+        tags.varint(3); tags.varint(classes.size() + (i / 7) % structures.size());
+        if (i % 3) {
+            tags.varint(2); tags.varint(onewayBase + (i / 3) % 2);
+        }
+        if (i % 5 == 0) {
+            tags.varint(4); tags.varint(layerBase + (i / 5) % 3);
+        }
+        tags.varint(5); tags.varint(nameBase + i);
+
+        Writer geometry;
+        geometry.varint((1 << 3) | 1);
+        geometry.varint(zigzag(1));
+        geometry.varint(zigzag(1));
+        geometry.varint((1 << 3) | 2);
+        geometry.varint(zigzag(8));
+        geometry.varint(zigzag(8));
+
+        Writer feature;
+        feature.bytes(2, tags.data);
+        feature.field(3, uint64_t(i % 11 ? FeatureType::LineString : FeatureType::Polygon));
+        feature.bytes(4, geometry.data);
+        layer.bytes(2, feature.data);
+    }
+
+    Writer tile;
+    tile.bytes(3, layer.data);
+    return tile.data;
+}
+
+FilterExpression parseFilter(const std::string& json) {
+    rapidjson::Document doc;
+    doc.Parse<0>(json.c_str());
+    return parseFilterExpression(doc);
+}
+
+const std::vector<std::string> streetsFilters = {
+    R"(["all", ["==", "$type", "LineString"], ["in", "class", "motorway", "main"], ["!=", "structure", "tunnel"]])",
+    R"(["all", ["==", "structure", "bridge"], ["==", "class", "street"]])",
+    R"(["any", ["==", "class", "street"], ["==", "class", "street_limited"], ["==", "class", "service"]])",
+    R"(["all", ["==", "oneway", 1], ["!in", "class", "path", "major_rail"]])",
+    R"(["none", ["==", "structure", "tunnel"], ["==", "$type", "Polygon"]])",
+    R"(["all", [">=", "layer", 0], ["<", "layer", 2], ["==", "class", "path"]])",
+    R"(["==", "$type", "Polygon"])",
+};
+
+// Filters that yield the same result for every feature in the fixture.
+const std::vector<std::string> constantFilters = {
+    R"(["==", "ref", "A1"])",
+    R"(["!=", "ref", "A1"])",
+    R"(["all"])",
+    R"(["any"])",
+};
+
+pbf toPBF(const std::string& data) {
+    return pbf(reinterpret_cast<const uint8_t *>(data.data()), data.size());
+}
+
+}
+
+TEST(VectorTile, Geometries) {
+    const std::string data = buildTile(1);
+    VectorTile tile(toPBF(data));
+
+    auto layer = tile.getLayer("road");
+    ASSERT_TRUE(bool(layer));
+    ASSERT_EQ(1u, layer->featureCount());
+
+    auto feature = layer->getFeature(0);
+    EXPECT_EQ(FeatureType::Polygon, feature->getType());
+    EXPECT_EQ(Value(std::string("street")), *feature->getValue("class"));
+    EXPECT_EQ(Value(uint64_t(1)), *feature->getValue("oneway"));
+    EXPECT_FALSE(feature->getValue("name"));
+
+    const GeometryCollection geometries = feature->getGeometries();
+    ASSERT_EQ(2u, geometries.size());
+    ASSERT_EQ(5u, geometries[0].size());
+    EXPECT_EQ(Coordinate(1, 1), geometries[0][0]);
+    EXPECT_EQ(Coordinate(9, 1), geometries[0][1]);
+    EXPECT_EQ(Coordinate(1, 1), geometries[0][4]);
+    ASSERT_EQ(5u, geometries[1].size());
+    EXPECT_EQ(Coordinate(12, 20), geometries[1][0]);
+
+    // Geometries are decoded once and then served from the tile's arena.
+    EXPECT_EQ(geometries[1].begin(), feature->getGeometries()[1].begin());
+}
+
+TEST(VectorTile, DecodeOncePerTile) {
+    // Simulates a style with many style layers reading the same source layer, and counts how many
+    // features get decoded per tile.
+    const std::size_t featureCount = 2000;
+    const std::size_t bucketCount = 12;
+    const std::string data = buildTile(featureCount);
+
+    // All buckets share the decoded features of a single tile.
+    std::set<const GeometryTileFeature *> decoded;
+    VectorTile tile(toPBF(data));
+    auto layer = tile.getLayer("road");
+    for (std::size_t b = 0; b < bucketCount; ++b) {
+        for (std::size_t i = 0; i < layer->featureCount(); ++i) {
+            auto feature = layer->getFeature(i);
+            feature->getGeometries();
+            decoded.insert(feature.get());
+        }
+    }
+    EXPECT_EQ(featureCount, decoded.size());
+
+    // Geometries decoded early must stay valid while the arena grows.
+    const GeometryCollection first = layer->getFeature(0)->getGeometries();
+    ASSERT_EQ(2u, first.size());
+    EXPECT_EQ(Coordinate(1, 1), first[0].front());
+    EXPECT_EQ(Coordinate(1, 1), first[0].back());
+}
+
+TEST(VectorTile, CompiledFilters) {
+    const std::string data = buildStreetsTile(500);
+    VectorTile tile(toPBF(data));
+    auto layer = tile.getLayer("road");
+    ASSERT_TRUE(bool(layer));
+
+    std::vector<std::string> filters = streetsFilters;
+    filters.insert(filters.end(), constantFilters.begin(), constantFilters.end());
+
+    for (const auto& json : filters) {
+        const FilterExpression filter = parseFilter(json);
+        const auto compiled = layer->compileFilter(filter);
+
+        std::size_t matches = 0;
+        for (std::size_t i = 0; i < layer->featureCount(); ++i) {
+            auto feature = layer->getFeature(i);
+            const bool expected = evaluate(filter, GeometryTileFeatureExtractor(*feature));
+            EXPECT_EQ(expected, (*compiled)(*feature)) << json << " feature " << i;
+            matches += expected;
+        }
+
+        // Make sure the fixture exercises both outcomes.
+        if (std::find(constantFilters.begin(), constantFilters.end(), json) == constantFilters.end()) {
+            EXPECT_GT(matches, 0u) << json;
+            EXPECT_LT(matches, layer->featureCount()) << json;
+        }
+    }
+}
+
+TEST(VectorTile, DISABLED_DecodeBenchmark) {
+    const std::size_t featureCount = 2000;
+    const std::size_t bucketCount = 12;
+    const std::string data = buildTile(featureCount);
+
+    // Every bucket decodes every feature on its own, as if each had its own tile.
+    std::vector<util::ptr<const GeometryTileFeature>> retained;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t b = 0; b < bucketCount; ++b) {
+        VectorTile tile(toPBF(data));
+        auto layer = tile.getLayer("road");
+        for (std::size_t i = 0; i < layer->featureCount(); ++i) {
+            auto feature = layer->getFeature(i);
+            feature->getGeometries();
+            retained.push_back(feature);
+        }
+    }
+    const auto separate = std::chrono::steady_clock::now() - start;
+    retained.clear();
+
+    // All buckets share the decoded features of a single tile.
+    start = std::chrono::steady_clock::now();
+    VectorTile tile(toPBF(data));
+    auto layer = tile.getLayer("road");
+    for (std::size_t b = 0; b < bucketCount; ++b) {
+        for (std::size_t i = 0; i < layer->featureCount(); ++i) {
+            layer->getFeature(i)->getGeometries();
+        }
+    }
+    const auto shared = std::chrono::steady_clock::now() - start;
+
+    using std::chrono::microseconds;
+    test::reportBenchmark("decoding %zu features for %zu buckets: %lldus separately, %lldus shared",
+                          featureCount, bucketCount,
+                          (long long)std::chrono::duration_cast<microseconds>(separate).count(),
+                          (long long)std::chrono::duration_cast<microseconds>(shared).count());
+}
+
+TEST(VectorTile, DISABLED_FilterBenchmark) {
+    const std::size_t featureCount = 5000;
+    const std::size_t iterations = 20;
+    const std::string data = buildStreetsTile(featureCount);
+    VectorTile tile(toPBF(data));
+    auto layer = tile.getLayer("road");
+
+    std::vector<util::ptr<const GeometryTileFeature>> features;
+    for (std::size_t i = 0; i < layer->featureCount(); ++i) {
+        features.push_back(layer->getFeature(i));
+    }
+
+    std::vector<FilterExpression> filters;
+    for (const auto& json : streetsFilters) {
+        filters.push_back(parseFilter(json));
+    }
+
+    std::size_t interpretedMatches = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t n = 0; n < iterations; ++n) {
+        for (const auto& filter : filters) {
+            for (const auto& feature : features) {
+                interpretedMatches += evaluate(filter, GeometryTileFeatureExtractor(*feature));
+            }
+        }
+    }
+    const double interpreted = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    // Compile per iteration, like TileParser does once per bucket.
+    std::size_t compiledMatches = 0;
+    start = std::chrono::steady_clock::now();
+    for (std::size_t n = 0; n < iterations; ++n) {
+        for (const auto& filter : filters) {
+            const auto compiled = layer->compileFilter(filter);
+            for (const auto& feature : features) {
+                compiledMatches += (*compiled)(*feature);
+            }
+        }
+    }
+    const double compiled = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_EQ(interpretedMatches, compiledMatches);
+
+    const double evaluations = double(featureCount * iterations * filters.size());
+    test::reportBenchmark("filter evaluations/sec: %.0f interpreted, %.0f compiled",
+                          evaluations / interpreted, evaluations / compiled);
+}
@@ -0,0 +1,203 @@
+#include "storage.hpp"
+
+#include <uv.h>
+
+#include <mbgl/storage/default_file_source.hpp>
+#include <mbgl/util/io.hpp>
+
+#include <cstdio>
+#include <string>
+
+#include <unistd.h>
+
+#ifdef MBGL_ASSET_ZIP
+TEST_F(Storage, AssetZipEntries) {
+    SCOPED_TEST(Stored)
+    SCOPED_TEST(Deflated)
+    SCOPED_TEST(Empty)
+    SCOPED_TEST(Missing)
+
+    using namespace mbgl;
+
+    DefaultFileSource fs(nullptr, uv_default_loop(), "test/fixtures/storage/archive.zip");
+
+    auto &env = *static_cast<const Environment *>(nullptr);
+
+    fs.request({ Resource::Unknown, "asset://stored" }, uv_default_loop(), env,
+               [&](const Response &res) {
+        EXPECT_EQ(Response::Successful, res.status) << res.message;
+        EXPECT_EQ("stored content\n", *res.data);
+        EXPECT_LT(1420000000, res.modified);
+        EXPECT_NE("", res.etag);
+        Stored.finish();
+    });
+
+    fs.request({ Resource::Unknown, "asset://deflated" }, uv_default_loop(), env,
+               [&](const Response &res) {
+        EXPECT_EQ(Response::Successful, res.status) << res.message;
+        std::string expected;
+        for (int i = 0; i < 2000; i++) {
+            expected += "deflated line " + std::to_string(i % 50) + "\n";
+        }
+        EXPECT_EQ(expected, *res.data);
+        Deflated.finish();
+    });
+
+    fs.request({ Resource::Unknown, "asset://empty" }, uv_default_loop(), env,
+               [&](const Response &res) {
+        EXPECT_EQ(Response::Successful, res.status) << res.message;
+        EXPECT_EQ("", *res.data);
+        Empty.finish();
+    });
+
+    // Directories aren't entries either.
+    fs.request({ Resource::Unknown, "asset://tiles" }, uv_default_loop(), env,
+               [&](const Response &res) {
+        EXPECT_EQ(Response::Error, res.status);
+        EXPECT_EQ("No such file", res.message);
+        Missing.finish();
+    });
+
+    uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+}
+
+TEST_F(Storage, AssetZipManyEntries) {
+    using namespace mbgl;
+
+    DefaultFileSource fs(nullptr, uv_default_loop(), "test/fixtures/storage/archive.zip");
+
+    auto &env = *static_cast<const Environment *>(nullptr);
+
+    // All of these share one index of the archive.
+    int finished = 0;
+    for (int i = 0; i < 300; i++) {
+        fs.request({ Resource::Tile, "asset://tiles/" + std::to_string(i) }, uv_default_loop(), env,
+                   [&, i](const Response &res) {
+            EXPECT_EQ(Response::Successful, res.status) << res.message;
+            EXPECT_EQ("tile " + std::to_string(i), *res.data);
+            finished++;
+        });
+    }
+
+    uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+
+    EXPECT_EQ(300, finished);
+}
+
+TEST_F(Storage, AssetZipNotAnArchive) {
+    SCOPED_TEST(NotAnArchive)
+
+    using namespace mbgl;
+
+    DefaultFileSource fs(nullptr, uv_default_loop(), "test/fixtures/storage/nonempty");
+
+    auto &env = *static_cast<const Environment *>(nullptr);
+
+    fs.request({ Resource::Unknown, "asset://stored" }, uv_default_loop(), env,
+               [&](const Response &res) {
+        EXPECT_EQ(Response::Error, res.status);
+        EXPECT_EQ("Not a zip archive", res.message);
+        NotAnArchive.finish();
+    });
+
+    uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+}
+
+TEST_F(Storage, AssetZipReplaced) {
+    SCOPED_TEST(Original)
+    SCOPED_TEST(Replaced)
+
+    using namespace mbgl;
+
+    const std::string path = "/tmp/mbgl-archive-" + std::to_string(getpid()) + ".zip";
+    util::write_file(path, util::read_file("test/fixtures/storage/archive.zip"));
+
+    DefaultFileSource fs(nullptr, uv_default_loop(), path);
+
+    auto &env = *static_cast<const Environment *>(nullptr);
+
+    fs.request({ Resource::Unknown, "asset://stored" }, uv_default_loop(), env,
+               [&](const Response &res) {
+        EXPECT_EQ(Response::Successful, res.status) << res.message;
+        Original.finish();
+
+        // Replaces the archive with one that doesn't have this entry. The new one is indexed
+        // instead of reusing the old index.
+        util::write_file(path + ".new", util::read_file("test/fixtures/storage/assets.zip"));
+        std::rename((path + ".new").c_str(), path.c_str());
+
+        fs.request({ Resource::Unknown, "asset://stored" }, uv_default_loop(), env,
+                   [&](const Response &res2) {
+            EXPECT_EQ(Response::Error, res2.status);
+            EXPECT_EQ("No such file", res2.message);
+            Replaced.finish();
+        });
+    });
+
+    uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+
+    std::remove(path.c_str());
+}
+
+TEST_F(Storage, AssetZipCorruptSize) {
+    SCOPED_TEST(CorruptSize)
+
+    using namespace mbgl;
+
+    // Claims that the deflated entry inflates to almost 4 GB.
+    std::string data = util::read_file("test/fixtures/storage/archive.zip");
+    const std::string name = "assets/deflated";
+    const auto header = data.find("PK\x01\x02");
+    const auto entry = data.find(name, header);
+    ASSERT_NE(std::string::npos, entry);
+    data.replace(entry - 46 + 24, 4, "\xF0\xFF\xFF\xFF");
+
+    const std::string path = "/tmp/mbgl-archive-" + std::to_string(getpid()) + "-corrupt.zip";
+    util::write_file(path, data);
+
+    DefaultFileSource fs(nullptr, uv_default_loop(), path);
+
+    auto &env = *static_cast<const Environment *>(nullptr);
+
+    fs.request({ Resource::Unknown, "asset://deflated" }, uv_default_loop(), env,
+               [&](const Response &res) {
+        EXPECT_EQ(Response::Error, res.status);
+        EXPECT_EQ("Invalid zip file size", res.message);
+        CorruptSize.finish();
+    });
+
+    uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+
+    std::remove(path.c_str());
+}
+
+TEST_F(Storage, AssetZipCorruptDirectory) {
+    SCOPED_TEST(CorruptCount)
+
+    using namespace mbgl;
+
+    // Claims more entries than the central directory has room for.
+    std::string data = util::read_file("test/fixtures/storage/archive.zip");
+    const auto end = data.rfind("PK\x05\x06");
+    ASSERT_NE(std::string::npos, end);
+    data.replace(end + 10, 2, "\xFE\xFF");
+
+    const std::string path = "/tmp/mbgl-archive-" + std::to_string(getpid()) + "-count.zip";
+    util::write_file(path, data);
+
+    DefaultFileSource fs(nullptr, uv_default_loop(), path);
+
+    auto &env = *static_cast<const Environment *>(nullptr);
+
+    fs.request({ Resource::Unknown, "asset://stored" }, uv_default_loop(), env,
+               [&](const Response &res) {
+        EXPECT_EQ(Response::Error, res.status);
+        EXPECT_EQ("Invalid zip archive", res.message);
+        CorruptCount.finish();
+    });
+
+    uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+
+    std::remove(path.c_str());
+}
+#endif
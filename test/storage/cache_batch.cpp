@@ -0,0 +1,157 @@
+#include "storage.hpp"
+
+#include <mbgl/storage/default/sqlite_cache.hpp>
+#include <mbgl/storage/resource.hpp>
+#include <mbgl/storage/response.hpp>
+
+#include <cstdio>
+#include <future>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+// Unique per process, so that concurrent test runs don't share the database.
+const std::string databasePath = "/tmp/mbgl-cache-batch-" + std::to_string(getpid()) + ".db";
+
+void removeDatabase() {
+    std::remove(databasePath.c_str());
+    std::remove((databasePath + "-wal").c_str());
+    std::remove((databasePath + "-shm").c_str());
+}
+
+std::vector<std::unique_ptr<mbgl::Response>> getAll(mbgl::SQLiteCache &cache,
+                                                    const std::vector<mbgl::Resource> &resources) {
+    std::promise<std::vector<std::unique_ptr<mbgl::Response>>> result;
+    cache.get(resources, [&](std::vector<std::unique_ptr<mbgl::Response>> responses) {
+        result.set_value(std::move(responses));
+    });
+    return result.get_future().get();
+}
+
+}
+
+TEST_F(Storage, CacheBatchGet) {
+    using namespace mbgl;
+
+    SQLiteCache cache(":memory:");
+
+    auto resource = [](int i) {
+        return Resource { Resource::Tile, "http://127.0.0.1:3000/tile/" + std::to_string(i) };
+    };
+
+    for (int i = 0; i < 100; i++) {
+        auto response = std::make_shared<Response>();
+        response->status = Response::Successful;
+        response->data = std::make_shared<const std::string>("Tile " + std::to_string(i));
+        cache.put(resource(i), response, FileCache::Hint::Full);
+    }
+
+    // More resources than fit in one query, one that isn't stored, and one requested twice.
+    std::vector<Resource> resources;
+    for (int i = 99; i >= 0; i--) {
+        resources.push_back(resource(i));
+    }
+    resources.push_back(resource(100));
+    resources.push_back(resource(7));
+
+    std::promise<std::vector<std::unique_ptr<Response>>> result;
+    cache.get(resources, [&](std::vector<std::unique_ptr<Response>> responses) {
+        result.set_value(std::move(responses));
+    });
+
+    const auto responses = result.get_future().get();
+    ASSERT_EQ(resources.size(), responses.size());
+    for (int i = 0; i < 100; i++) {
+        ASSERT_TRUE(bool(responses[i])) << "entry " << i;
+        EXPECT_EQ("Tile " + std::to_string(99 - i), *responses[i]->data);
+    }
+    EXPECT_FALSE(bool(responses[100]));
+    ASSERT_TRUE(bool(responses[101]));
+    EXPECT_EQ("Tile 7", *responses[101]->data);
+}
+
+TEST_F(Storage, CacheBatchCorruptEntry) {
+    using namespace mbgl;
+
+    removeDatabase();
+
+    auto resource = [](int i) {
+        return Resource { Resource::Tile, "http://127.0.0.1:3000/tile/" + std::to_string(i) };
+    };
+    const Resource corrupt { Resource::JSON, "http://127.0.0.1:3000/corrupt.json" };
+    const Resource later { Resource::JSON, "http://127.0.0.1:3000/later.json" };
+
+    {
+        SQLiteCache cache(databasePath);
+        for (int i = 0; i < 40; i++) {
+            auto response = std::make_shared<Response>();
+            response->status = Response::Successful;
+            response->data = std::make_shared<const std::string>("Tile " + std::to_string(i));
+            cache.put(resource(i), response, FileCache::Hint::Full);
+        }
+
+        // Claims to be gzip, so the cache tries to inflate it when it's read.
+        auto response = std::make_shared<Response>();
+        response->status = Response::Successful;
+        response->data = std::make_shared<const std::string>("not gzip");
+        response->encoding = "gzip";
+        cache.put(corrupt, response, FileCache::Hint::Full);
+    }
+
+    {
+        // More resources than fit in one query, read outside of a write batch.
+        SQLiteCache cache(databasePath);
+        std::vector<Resource> resources;
+        for (int i = 0; i < 40; i++) {
+            resources.push_back(resource(i));
+        }
+        resources.push_back(corrupt);
+
+        // The corrupt entry is a miss, and doesn't take the others with it.
+        const auto responses = getAll(cache, resources);
+        ASSERT_EQ(resources.size(), responses.size());
+        for (int i = 0; i < 40; i++) {
+            ASSERT_TRUE(bool(responses[i])) << "entry " << i;
+            EXPECT_EQ("Tile " + std::to_string(i), *responses[i]->data);
+        }
+        EXPECT_FALSE(bool(responses[40]));
+
+        // Writes still work afterwards.
+        auto response = std::make_shared<Response>();
+        response->status = Response::Successful;
+        response->data = std::make_shared<const std::string>("Later");
+        cache.put(later, response, FileCache::Hint::Full);
+    }
+
+    {
+        SQLiteCache cache(databasePath);
+        const auto responses = getAll(cache, { later });
+        ASSERT_TRUE(bool(responses[0]));
+        EXPECT_EQ("Later", *responses[0]->data);
+    }
+
+    removeDatabase();
+}
+
+TEST_F(Storage, CacheBatchUnavailable) {
+    using namespace mbgl;
+
+    // The database can't be opened, so every lookup fails.
+    SQLiteCache cache("/tmp/mbgl-cache-batch-missing/cache.db");
+
+    const Resource tile { Resource::Tile, "http://127.0.0.1:3000/tile" };
+    std::promise<std::unique_ptr<Response>> single;
+    cache.get(tile, [&](std::unique_ptr<Response> res) {
+        single.set_value(std::move(res));
+    });
+
+    // Both requesters still get an answer, as misses.
+    const auto responses = getAll(cache, { tile, tile });
+    ASSERT_EQ(2u, responses.size());
+    EXPECT_FALSE(bool(responses[0]));
+    EXPECT_FALSE(bool(responses[1]));
+    EXPECT_FALSE(bool(single.get_future().get()));
+}
@@ -0,0 +1,93 @@
+#include "storage.hpp"
+
+#include <mbgl/storage/default/sqlite_cache.hpp>
+#include <mbgl/storage/resource.hpp>
+#include <mbgl/storage/response.hpp>
+#include <mbgl/util/std.hpp>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+#include <unistd.h>
+
+namespace {
+
+// Unique per process, so that concurrent test runs don't share the database.
+const std::string databasePath = "/tmp/mbgl-cache-benchmark-" + std::to_string(getpid()) + ".db";
+
+void removeDatabase() {
+    std::remove(databasePath.c_str());
+    std::remove((databasePath + "-wal").c_str());
+    std::remove((databasePath + "-shm").c_str());
+}
+
+double elapsedSeconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+// Reports the throughput of a cold-viewport-like burst of puts followed by a burst of gets against
+// an on-disk database.
+TEST_F(Storage, DISABLED_CacheBenchmark) {
+    using namespace mbgl;
+
+    const int count = 1000;
+    removeDatabase();
+
+    auto tile = std::make_shared<Response>();
+    tile->status = Response::Successful;
+    tile->expires = 1;
+    tile->data = std::make_shared<const std::string>(32 * 1024, 'x');
+
+    auto resource = [](int i) {
+        return Resource { Resource::Tile, "http://127.0.0.1:3000/tile/" + std::to_string(i) };
+    };
+
+    {
+        const auto start = std::chrono::steady_clock::now();
+        {
+            SQLiteCache cache(databasePath);
+            for (int i = 0; i < count; i++) {
+                cache.put(resource(i), tile, FileCache::Hint::Full);
+            }
+            // Destroying the cache waits for all writes to be committed.
+        }
+        const double seconds = elapsedSeconds(start);
+        test::reportBenchmark("SQLiteCache puts/sec: %.0f (%d puts in %.3fs)", count / seconds, count,
+                              seconds);
+    }
+
+    {
+        SQLiteCache cache(databasePath);
+        std::mutex mutex;
+        std::condition_variable cond;
+        int found = 0;
+        int answered = 0;
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; i++) {
+            cache.get(resource(i), [&](std::unique_ptr<Response> res) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (res && res->data->size() == tile->data->size()) {
+                    found++;
+                }
+                answered++;
+                cond.notify_one();
+            });
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        cond.wait(lock, [&] { return answered == count; });
+        const double seconds = elapsedSeconds(start);
+        test::reportBenchmark("SQLiteCache gets/sec: %.0f (%d gets in %.3fs)", count / seconds, count,
+                              seconds);
+
+        EXPECT_EQ(count, found);
+    }
+
+    removeDatabase();
+}
@@ -0,0 +1,104 @@
+#include "storage.hpp"
+
+#include <uv.h>
+
+#include <mbgl/storage/default_file_source.hpp>
+#include <mbgl/storage/default/sqlite_cache.hpp>
+#include <mbgl/util/compression.hpp>
+
+#include <future>
+
+TEST_F(Storage, CacheEncoding) {
+    using namespace mbgl;
+
+    SQLiteCache cache(":memory:");
+
+    auto get = [&](const Resource &resource) {
+        std::promise<std::unique_ptr<Response>> result;
+        cache.get(resource, [&](std::unique_ptr<Response> res) {
+            result.set_value(std::move(res));
+        });
+        return result.get_future().get();
+    };
+
+    // Tiles are stored and returned as they came from the server.
+    const Resource tile { Resource::Tile, "http://127.0.0.1:3000/tile" };
+    auto compressed = std::make_shared<Response>();
+    compressed->status = Response::Successful;
+    compressed->data = std::make_shared<const std::string>(util::compress("Tile"));
+    compressed->encoding = "deflate";
+    cache.put(tile, compressed, FileCache::Hint::Full);
+
+    auto tileResponse = get(tile);
+    ASSERT_TRUE(bool(tileResponse));
+    EXPECT_EQ("deflate", tileResponse->encoding);
+    EXPECT_EQ(*compressed->data, *tileResponse->data);
+    EXPECT_EQ("Tile", util::decompress(*tileResponse->data));
+
+    // Other resources are compressed by the cache and come back decoded.
+    const Resource json { Resource::JSON, "http://127.0.0.1:3000/source.json" };
+    auto plain = std::make_shared<Response>();
+    plain->status = Response::Successful;
+    plain->data = std::make_shared<const std::string>(1000, 'x');
+    cache.put(json, plain, FileCache::Hint::Full);
+
+    auto jsonResponse = get(json);
+    ASSERT_TRUE(bool(jsonResponse));
+    EXPECT_EQ("", jsonResponse->encoding);
+    EXPECT_EQ(*plain->data, *jsonResponse->data);
+}
+
+TEST_F(Storage, HTTPEncoding) {
+    SCOPED_TEST(HTTPEncodingTile)
+    SCOPED_TEST(HTTPEncodingOther)
+
+    using namespace mbgl;
+
+    DefaultFileSource fs(nullptr, uv_default_loop());
+
+    auto &env = *static_cast<const Environment *>(nullptr);
+
+    // Tiles keep the gzip stream for the tile worker.
+    fs.request({ Resource::Tile, "http://127.0.0.1:3000/gzip" }, uv_default_loop(), env,
+               [&](const Response &res) {
+        EXPECT_EQ(Response::Successful, res.status);
+        EXPECT_EQ("gzip", res.encoding);
+        EXPECT_EQ("Hello World!", util::decompress(*res.data));
+        HTTPEncodingTile.finish();
+    });
+
+    // Everything else is decoded right away.
+    fs.request({ Resource::Unknown, "http://127.0.0.1:3000/gzip" }, uv_default_loop(), env,
+               [&](const Response &res) {
+        EXPECT_EQ(Response::Successful, res.status);
+        EXPECT_EQ("", res.encoding);
+        EXPECT_EQ("Hello World!", *res.data);
+        HTTPEncodingOther.finish();
+    });
+
+    uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+}
+
+TEST_F(Storage, HTTPRedirectHeaders) {
+    SCOPED_TEST(HTTPRedirectHeaders)
+
+    using namespace mbgl;
+
+    DefaultFileSource fs(nullptr, uv_default_loop());
+
+    auto &env = *static_cast<const Environment *>(nullptr);
+
+    // The headers of the redirect don't carry over to the final response, and only gzip is kept
+    // as an encoding.
+    fs.request({ Resource::Tile, "http://127.0.0.1:3000/redirect-headers" }, uv_default_loop(), env,
+               [&](const Response &res) {
+        EXPECT_EQ(Response::Successful, res.status);
+        EXPECT_EQ("", res.encoding);
+        EXPECT_EQ("", res.etag);
+        EXPECT_EQ(0, res.expires);
+        EXPECT_EQ("Hello World!", *res.data);
+        HTTPRedirectHeaders.finish();
+    });
+
+    uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+}
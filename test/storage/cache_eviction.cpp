@@ -0,0 +1,98 @@
+#include "storage.hpp"
+
+#include <mbgl/storage/default/sqlite_cache.hpp>
+#include <mbgl/storage/resource.hpp>
+#include <mbgl/storage/response.hpp>
+
+#include <cstdio>
+#include <future>
+#include <string>
+
+#include <unistd.h>
+
+namespace {
+
+// Unique per process, so that concurrent test runs don't share the database.
+const std::string databasePath = "/tmp/mbgl-cache-eviction-" + std::to_string(getpid()) + ".db";
+
+void removeDatabase() {
+    std::remove(databasePath.c_str());
+    std::remove((databasePath + "-wal").c_str());
+    std::remove((databasePath + "-shm").c_str());
+}
+
+}
+
+TEST_F(Storage, CacheEviction) {
+    using namespace mbgl;
+
+    removeDatabase();
+
+    // Images are stored uncompressed, so every entry takes exactly 1000 bytes.
+    auto image = std::make_shared<Response>();
+    image->status = Response::Successful;
+    image->data = std::make_shared<const std::string>(1000, 'x');
+
+    auto resource = [](int i) {
+        return Resource { Resource::Image, "http://127.0.0.1:3000/image/" + std::to_string(i) };
+    };
+
+    {
+        SQLiteCache cache(databasePath, 5000);
+        for (int i = 0; i < 10; i++) {
+            cache.put(resource(i), image, FileCache::Hint::Full);
+        }
+    }
+
+    {
+        SQLiteCache cache(databasePath, 5000);
+        for (int i = 0; i < 10; i++) {
+            std::promise<bool> found;
+            cache.get(resource(i), [&](std::unique_ptr<Response> res) {
+                found.set_value(bool(res));
+            });
+            // The oldest entries were evicted to get back under the limit.
+            EXPECT_EQ(i >= 5, found.get_future().get()) << "entry " << i;
+        }
+    }
+
+    removeDatabase();
+}
+
+TEST_F(Storage, CachePinning) {
+    using namespace mbgl;
+
+    removeDatabase();
+
+    auto image = std::make_shared<Response>();
+    image->status = Response::Successful;
+    image->data = std::make_shared<const std::string>(1000, 'x');
+
+    auto resource = [](int i) {
+        return Resource { Resource::Image, "http://127.0.0.1:3000/image/" + std::to_string(i) };
+    };
+
+    {
+        SQLiteCache cache(databasePath, 5000);
+        for (int i = 0; i < 10; i++) {
+            cache.put(resource(i), image, FileCache::Hint::Full);
+            if (i == 0) {
+                cache.pin(resource(i));
+            }
+        }
+    }
+
+    {
+        SQLiteCache cache(databasePath, 5000);
+        for (int i = 0; i < 10; i++) {
+            std::promise<bool> found;
+            cache.get(resource(i), [&](std::unique_ptr<Response> res) {
+                found.set_value(bool(res));
+            });
+            // The pinned entry is neither evicted nor counted against the limit.
+            EXPECT_EQ(i == 0 || i >= 5, found.get_future().get()) << "entry " << i;
+        }
+    }
+
+    removeDatabase();
+}
@@ -0,0 +1,126 @@
+#include "storage.hpp"
+
+#include <uv.h>
+
+#include <mbgl/storage/default_file_source.hpp>
+#include <mbgl/storage/default/sqlite_cache.hpp>
+
+TEST_F(Storage, CacheStaleWhileRevalidate) {
+    SCOPED_TEST(CacheStaleSame)
+    SCOPED_TEST(CacheStaleChanged)
+    SCOPED_TEST(CacheStaleNotAccepted)
+
+    using namespace mbgl;
+
+    SQLiteCache cache(":memory:");
+    DefaultFileSource fs(&cache, uv_default_loop());
+    fs.setStaleWhileRevalidate(true);
+
+    auto &env = *static_cast<const Environment *>(nullptr);
+
+    // Both entries expired long ago and have to be revalidated.
+    auto stale = [](const std::string &data, const std::string &etag) {
+        auto response = std::make_shared<Response>();
+        response->status = Response::Successful;
+        response->data = std::make_shared<const std::string>(data);
+        response->etag = etag;
+        response->expires = 1;
+        return response;
+    };
+
+    const std::string sameURL = "http://127.0.0.1:3000/revalidate-same";
+    const std::string changedURL = "http://127.0.0.1:3000/revalidate-etag";
+    cache.put({ Resource::Tile, sameURL }, stale("Response", "snowfall"), FileCache::Hint::Full);
+    cache.put({ Resource::Tile, changedURL }, stale("Stale", "response-0"), FileCache::Hint::Full);
+
+    // The server answers with a 304, so the second callback confirms the stale data.
+    int sameCount = 0;
+    fs.request({ Resource::Tile, sameURL, 0, true }, uv_default_loop(), env, [&](const Response &res) {
+        sameCount++;
+        EXPECT_EQ(Response::Successful, res.status);
+        EXPECT_EQ("Response", *res.data);
+        EXPECT_EQ("snowfall", res.etag);
+        if (sameCount == 1) {
+            EXPECT_TRUE(res.stale);
+            EXPECT_FALSE(res.notModified);
+        } else {
+            EXPECT_EQ(2, sameCount);
+            EXPECT_FALSE(res.stale);
+            EXPECT_TRUE(res.notModified);
+            EXPECT_LT(1, res.expires);
+            CacheStaleSame.finish();
+        }
+    });
+
+    // The server sends new data, which arrives in a second callback.
+    int changedCount = 0;
+    fs.request({ Resource::Tile, changedURL, 0, true }, uv_default_loop(), env, [&](const Response &res) {
+        changedCount++;
+        if (changedCount == 1) {
+            EXPECT_TRUE(res.stale);
+            EXPECT_EQ("Stale", *res.data);
+        } else {
+            EXPECT_EQ(2, changedCount);
+            EXPECT_FALSE(res.stale);
+            EXPECT_EQ(Response::Successful, res.status);
+            EXPECT_NE("Stale", *res.data);
+            CacheStaleChanged.finish();
+        }
+    });
+
+    // Requests that don't accept stale data only get the revalidated response, even when they
+    // share it with one that does.
+    int notAcceptedCount = 0;
+    fs.request({ Resource::Tile, sameURL }, uv_default_loop(), env, [&](const Response &res) {
+        EXPECT_EQ(1, ++notAcceptedCount);
+        EXPECT_FALSE(res.stale);
+        EXPECT_EQ(Response::Successful, res.status);
+        EXPECT_EQ("Response", *res.data);
+        EXPECT_TRUE(res.notModified);
+        EXPECT_LT(0, res.expires);
+        CacheStaleNotAccepted.finish();
+    });
+
+    uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+
+    EXPECT_EQ(2, sameCount);
+    EXPECT_EQ(2, changedCount);
+    EXPECT_EQ(1, notAcceptedCount);
+}
+
+TEST_F(Storage, CacheStaleCancel) {
+    SCOPED_TEST(CacheStaleCanceled)
+
+    using namespace mbgl;
+
+    SQLiteCache cache(":memory:");
+    DefaultFileSource fs(&cache, uv_default_loop());
+    fs.setStaleWhileRevalidate(true);
+
+    auto &env = *static_cast<const Environment *>(nullptr);
+
+    auto response = std::make_shared<Response>();
+    response->status = Response::Successful;
+    response->data = std::make_shared<const std::string>("Stale");
+    response->etag = "response-0";
+    response->expires = 1;
+
+    const std::string url = "http://127.0.0.1:3000/revalidate-etag";
+    cache.put({ Resource::Tile, url }, response, FileCache::Hint::Full);
+
+    // The request is still revalidating after the stale response, and can be canceled. The changed
+    // data isn't delivered anymore.
+    int count = 0;
+    Request *req = nullptr;
+    req = fs.request({ Resource::Tile, url, 0, true }, uv_default_loop(), env, [&](const Response &res) {
+        EXPECT_EQ(1, ++count);
+        EXPECT_TRUE(res.stale);
+        EXPECT_EQ("Stale", *res.data);
+        fs.cancel(req);
+        CacheStaleCanceled.finish();
+    });
+
+    uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+
+    EXPECT_EQ(1, count);
+}
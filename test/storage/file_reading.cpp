@@ -4,6 +4,14 @@
 
 #include <mbgl/storage/default_file_source.hpp>
 #include <mbgl/platform/platform.hpp>
+#include <mbgl/util/io.hpp>
+
+#include <chrono>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 TEST_F(Storage, AssetEmptyFile) {
     SCOPED_TEST(EmptyFile)
@@ -21,7 +29,7 @@ TEST_F(Storage, AssetEmptyFile) {
     fs.request({ Resource::Unknown, "asset://TEST_DATA/fixtures/storage/empty" }, uv_default_loop(),
                env, [&](const Response &res) {
         EXPECT_EQ(Response::Successful, res.status);
-        EXPECT_EQ(0ul, res.data.size());
+        EXPECT_EQ(0ul, res.data->size());
         EXPECT_EQ(0, res.expires);
         EXPECT_LT(1420000000, res.modified);
         EXPECT_NE("", res.etag);
@@ -48,12 +56,12 @@ TEST_F(Storage, AssetNonEmptyFile) {
     fs.request({ Resource::Unknown, "asset://TEST_DATA/fixtures/storage/nonempty" },
                uv_default_loop(), env, [&](const Response &res) {
         EXPECT_EQ(Response::Successful, res.status);
-        EXPECT_EQ(16ul, res.data.size());
+        EXPECT_EQ(16ul, res.data->size());
         EXPECT_EQ(0, res.expires);
         EXPECT_LT(1420000000, res.modified);
         EXPECT_NE("", res.etag);
         EXPECT_EQ("", res.message);
-        EXPECT_EQ("content is here\n", res.data);
+        EXPECT_EQ("content is here\n", *res.data);
         NonEmptyFile.finish();
     });
 
@@ -76,7 +84,7 @@ TEST_F(Storage, AssetNonExistentFile) {
     fs.request({ Resource::Unknown, "asset://TEST_DATA/fixtures/storage/does_not_exist" },
                uv_default_loop(), env, [&](const Response &res) {
         EXPECT_EQ(Response::Error, res.status);
-        EXPECT_EQ(0ul, res.data.size());
+        EXPECT_EQ(0ul, res.data->size());
         EXPECT_EQ(0, res.expires);
         EXPECT_EQ(0, res.modified);
         EXPECT_EQ("", res.etag);
@@ -90,3 +98,95 @@ TEST_F(Storage, AssetNonExistentFile) {
 
     uv_run(uv_default_loop(), UV_RUN_DEFAULT);
 }
+
+#ifdef MBGL_ASSET_FS
+TEST_F(Storage, AssetParallelReads) {
+    using namespace mbgl;
+
+    DefaultFileSource fs(nullptr, uv_default_loop());
+
+    auto &env = *static_cast<const Environment *>(nullptr);
+
+    // Reads are spread over the reader threads.
+    const std::string prefix = "/tmp/mbgl-asset-" + std::to_string(getpid()) + "-";
+    std::vector<std::string> contents;
+    for (std::size_t i = 0; i < 12; i++) {
+        contents.emplace_back((i % 3 == 0 ? 3u << 20 : 1000u) + i, char('a' + i));
+        util::write_file(prefix + std::to_string(i), contents.back());
+    }
+
+    std::size_t finished = 0;
+    for (std::size_t i = 0; i < contents.size(); i++) {
+        fs.request({ Resource::Unknown, "asset://" + prefix + std::to_string(i) }, uv_default_loop(),
+                   env, [&, i](const Response &res) {
+            EXPECT_EQ(Response::Successful, res.status) << res.message;
+            EXPECT_TRUE(contents[i] == *res.data) << i;
+            EXPECT_NE("", res.etag);
+            finished++;
+        });
+    }
+
+    uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+
+    EXPECT_EQ(contents.size(), finished);
+    for (std::size_t i = 0; i < contents.size(); i++) {
+        unlink((prefix + std::to_string(i)).c_str());
+    }
+}
+
+TEST_F(Storage, AssetReadsOverlap) {
+    using namespace mbgl;
+
+    DefaultFileSource fs(nullptr, uv_default_loop());
+
+    auto &env = *static_cast<const Environment *>(nullptr);
+
+    // Opening a FIFO for reading blocks until a writer opens it. The first read is held up that
+    // way, and the second one can only open its FIFO while the first is still blocked if the two
+    // run on different threads.
+    const std::string prefix = "/tmp/mbgl-asset-" + std::to_string(getpid()) + "-fifo-";
+    const std::string first = prefix + "a";
+    const std::string second = prefix + "b";
+    ASSERT_EQ(0, mkfifo(first.c_str(), 0600));
+    ASSERT_EQ(0, mkfifo(second.c_str(), 0600));
+
+    bool overlapped = false;
+    std::thread writer([&] {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (std::chrono::steady_clock::now() < deadline) {
+            // Fails with ENXIO as long as nobody has the FIFO open for reading.
+            int fd = open(second.c_str(), O_WRONLY | O_NONBLOCK);
+            if (fd >= 0) {
+                overlapped = true;
+                close(fd);
+                break;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        // Releases the blocked reads, so that the test finishes either way.
+        close(open(first.c_str(), O_WRONLY));
+        if (!overlapped) {
+            close(open(second.c_str(), O_WRONLY));
+        }
+    });
+
+    std::size_t finished = 0;
+    for (const auto &path : { first, second }) {
+        fs.request({ Resource::Unknown, "asset://" + path }, uv_default_loop(), env,
+                   [&](const Response &res) {
+            EXPECT_EQ(Response::Successful, res.status) << res.message;
+            EXPECT_EQ(0ul, res.data->size());
+            finished++;
+        });
+    }
+
+    uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+    writer.join();
+
+    EXPECT_TRUE(overlapped);
+    EXPECT_EQ(2ul, finished);
+    unlink(first.c_str());
+    unlink(second.c_str());
+}
+#endif
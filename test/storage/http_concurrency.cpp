@@ -0,0 +1,73 @@
+#include "storage.hpp"
+
+#include <uv.h>
+
+#include <mbgl/storage/default_file_source.hpp>
+
+#include <algorithm>
+
+TEST_F(Storage, HTTPConcurrency) {
+    SCOPED_TEST(HTTPConcurrency)
+
+    using namespace mbgl;
+
+    DefaultFileSource fs(nullptr, uv_default_loop());
+    fs.setMaximumConcurrentRequests(4);
+
+    auto &env = *static_cast<const Environment *>(nullptr);
+
+    const int count = 40;
+    int completed = 0;
+    int maximum = 0;
+
+    for (int i = 0; i < count; i++) {
+        fs.request({ Resource::Unknown,
+                     std::string("http://127.0.0.1:3000/concurrent/") + std::to_string(i) },
+                   uv_default_loop(), env, [&](const Response &res) {
+            EXPECT_EQ(Response::Successful, res.status);
+            maximum = std::max(maximum, std::stoi(*res.data));
+
+            if (++completed == count) {
+                // The remaining requests waited in the file source's queue.
+                EXPECT_LE(maximum, 4);
+                HTTPConcurrency.finish();
+            }
+        });
+    }
+
+    uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+}
+
+TEST_F(Storage, HTTPConnectionsPerHost) {
+    SCOPED_TEST(HTTPConnectionsPerHost)
+
+    using namespace mbgl;
+
+    DefaultFileSource fs(nullptr, uv_default_loop());
+    fs.setMaximumConnectionsPerHost(2);
+
+    auto &env = *static_cast<const Environment *>(nullptr);
+
+    const int count = 20;
+    int completed = 0;
+    int maximum = 0;
+
+    // Connections that the other tests left open to 127.0.0.1 don't count against the limit, so
+    // this uses a host name of its own.
+    for (int i = 0; i < count; i++) {
+        fs.request({ Resource::Unknown,
+                     std::string("http://localhost:3000/concurrent/") + std::to_string(i) },
+                   uv_default_loop(), env, [&](const Response &res) {
+            EXPECT_EQ(Response::Successful, res.status);
+            maximum = std::max(maximum, std::stoi(*res.data));
+
+            if (++completed == count) {
+                // All requests were started, but they waited for one of the connections.
+                EXPECT_LE(maximum, 2);
+                HTTPConnectionsPerHost.finish();
+            }
+        });
+    }
+
+    uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+}
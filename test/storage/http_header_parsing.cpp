@@ -20,7 +20,7 @@ TEST_F(Storage, HTTPHeaderParsing) {
                  "http://127.0.0.1:3000/test?modified=1420794326&expires=1420797926&etag=foo" },
                uv_default_loop(), env, [&](const Response &res) {
         EXPECT_EQ(Response::Successful, res.status);
-        EXPECT_EQ("Hello World!", res.data);
+        EXPECT_EQ("Hello World!", *res.data);
         EXPECT_EQ(1420797926, res.expires);
         EXPECT_EQ(1420794326, res.modified);
         EXPECT_EQ("foo", res.etag);
@@ -34,7 +34,7 @@ TEST_F(Storage, HTTPHeaderParsing) {
     fs.request({ Resource::Unknown, "http://127.0.0.1:3000/test?cachecontrol=max-age=120" },
                uv_default_loop(), env, [&](const Response &res) {
         EXPECT_EQ(Response::Successful, res.status);
-        EXPECT_EQ("Hello World!", res.data);
+        EXPECT_EQ("Hello World!", *res.data);
         EXPECT_GT(2, std::abs(res.expires - now - 120)) << "Expiration date isn't about 120 seconds in the future";
         EXPECT_EQ(0, res.modified);
         EXPECT_EQ("", res.etag);
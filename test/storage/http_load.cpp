@@ -4,6 +4,10 @@
 
 #include <mbgl/storage/default_file_source.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
 TEST_F(Storage, HTTPLoad) {
     SCOPED_TEST(HTTPLoad)
 
@@ -23,7 +27,7 @@ TEST_F(Storage, HTTPLoad) {
                      std::string("http://127.0.0.1:3000/load/") + std::to_string(current) },
                    uv_default_loop(), env, [&, current](const Response &res) {
             EXPECT_EQ(Response::Successful, res.status);
-            EXPECT_EQ(std::string("Request ") +  std::to_string(current), res.data);
+            EXPECT_EQ(std::string("Request ") +  std::to_string(current), *res.data);
             EXPECT_EQ(0, res.expires);
             EXPECT_EQ(0, res.modified);
             EXPECT_EQ("", res.etag);
@@ -44,3 +48,44 @@ TEST_F(Storage, HTTPLoad) {
 
     uv_run(uv_default_loop(), UV_RUN_DEFAULT);
 }
+
+// Issues a burst of requests at once, like a fast zoom does, and reports the throughput and the
+// latency including the time spent waiting for a free request slot.
+TEST_F(Storage, DISABLED_HTTPLoadBenchmark) {
+    SCOPED_TEST(HTTPLoadBenchmark)
+
+    using namespace mbgl;
+    using Clock = std::chrono::steady_clock;
+
+    DefaultFileSource fs(nullptr, uv_default_loop());
+
+    auto &env = *static_cast<const Environment *>(nullptr);
+
+    const int count = 2000;
+    std::vector<double> latencies;
+    latencies.reserve(count);
+
+    const auto start = Clock::now();
+    for (int i = 0; i < count; i++) {
+        const auto issued = Clock::now();
+        fs.request({ Resource::Unknown,
+                     std::string("http://127.0.0.1:3000/load/") + std::to_string(i) },
+                   uv_default_loop(), env, [&, issued](const Response &res) {
+            EXPECT_EQ(Response::Successful, res.status);
+            latencies.push_back(std::chrono::duration<double, std::milli>(Clock::now() - issued).count());
+
+            if (latencies.size() == count) {
+                const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+                std::sort(latencies.begin(), latencies.end());
+                test::reportBenchmark("HTTP requests/sec: %.0f (%d requests in %.3fs, %u concurrent)",
+                                      count / seconds, count, seconds,
+                                      DefaultFileSource::defaultMaximumConcurrentRequests);
+                test::reportBenchmark("HTTP latency p50: %.1fms, p99: %.1fms", latencies[count / 2],
+                                      latencies[count * 99 / 100]);
+                HTTPLoadBenchmark.finish();
+            }
+        });
+    }
+
+    uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+}
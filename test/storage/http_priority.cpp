@@ -0,0 +1,41 @@
+#include "storage.hpp"
+
+#include <uv.h>
+
+#include <mbgl/storage/default_file_source.hpp>
+
+#include <vector>
+
+TEST_F(Storage, HTTPPriority) {
+    SCOPED_TEST(HTTPPriority)
+
+    using namespace mbgl;
+
+    DefaultFileSource fs(nullptr, uv_default_loop());
+    fs.setMaximumConcurrentRequests(1);
+
+    auto &env = *static_cast<const Environment *>(nullptr);
+
+    std::vector<std::string> order;
+    auto request = [&](const std::string &path, double priority) {
+        return fs.request({ Resource::Unknown, "http://127.0.0.1:3000/" + path, priority },
+                          uv_default_loop(), env, [&, path](const Response &res) {
+            EXPECT_EQ(Response::Successful, res.status);
+            order.push_back(path);
+            if (order.size() == 4) {
+                // The first request occupied the only slot while the others were queued. The
+                // others take long enough that their callbacks can't be delivered together.
+                EXPECT_EQ((std::vector<std::string> { "delayed", "concurrent/3", "concurrent/1", "concurrent/2" }), order);
+                HTTPPriority.finish();
+            }
+        });
+    };
+
+    request("delayed", 0);
+    request("concurrent/1", 1);
+    request("concurrent/2", 2);
+    Request *third = request("concurrent/3", 3);
+    fs.setPriority(third, 0);
+
+    uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+}
@@ -0,0 +1,97 @@
+#include "storage.hpp"
+
+#include <uv.h>
+
+#include <mbgl/storage/default_file_source.hpp>
+#include <mbgl/util/compression.hpp>
+
+#include <rapidjson/document.h>
+
+TEST_F(Storage, MBTilesTileJSON) {
+    SCOPED_TEST(TileJSON)
+
+    using namespace mbgl;
+
+    DefaultFileSource fs(nullptr, uv_default_loop());
+
+    auto &env = *static_cast<const Environment *>(nullptr);
+
+    const std::string url = "mbtiles://TEST_DATA/fixtures/storage/tiles.mbtiles";
+    fs.request({ Resource::JSON, url }, uv_default_loop(), env, [&](const Response &res) {
+        ASSERT_EQ(Response::Successful, res.status) << res.message;
+
+        rapidjson::Document doc;
+        doc.Parse<0>(res.data->c_str());
+        ASSERT_FALSE(doc.HasParseError());
+
+        ASSERT_TRUE(doc["tiles"].IsArray());
+        ASSERT_EQ(1u, doc["tiles"].Size());
+        EXPECT_EQ(url + "/{z}/{x}/{y}", std::string(doc["tiles"][0u].GetString()));
+        EXPECT_EQ(0u, doc["minzoom"].GetUint());
+        EXPECT_EQ(1u, doc["maxzoom"].GetUint());
+        ASSERT_TRUE(doc["bounds"].IsArray());
+        EXPECT_EQ(-85, doc["bounds"][1u].GetDouble());
+        ASSERT_TRUE(doc["center"].IsArray());
+        EXPECT_EQ(1, doc["center"][2u].GetDouble());
+        EXPECT_EQ(std::string("Fixture attribution"), doc["attribution"].GetString());
+
+        // The layers come from the "json" metadata.
+        ASSERT_TRUE(doc["vector_layers"].IsArray());
+        EXPECT_EQ(std::string("water"), doc["vector_layers"][0u]["id"].GetString());
+        TileJSON.finish();
+    });
+
+    uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+}
+
+TEST_F(Storage, MBTilesTiles) {
+    SCOPED_TEST(PlainTile)
+    SCOPED_TEST(CompressedTile)
+    SCOPED_TEST(FlippedTile)
+    SCOPED_TEST(MissingTile)
+    SCOPED_TEST(MissingFile)
+
+    using namespace mbgl;
+
+    DefaultFileSource fs(nullptr, uv_default_loop());
+
+    auto &env = *static_cast<const Environment *>(nullptr);
+
+    const std::string url = "mbtiles://TEST_DATA/fixtures/storage/tiles.mbtiles";
+    fs.request({ Resource::Tile, url + "/0/0/0" }, uv_default_loop(), env, [&](const Response &res) {
+        EXPECT_EQ(Response::Successful, res.status) << res.message;
+        EXPECT_EQ("Tile 0/0/0", *res.data);
+        EXPECT_EQ("", res.encoding);
+        PlainTile.finish();
+    });
+
+    // Gzipped tiles are inflated by the tile worker.
+    fs.request({ Resource::Tile, url + "/1/0/0" }, uv_default_loop(), env, [&](const Response &res) {
+        EXPECT_EQ(Response::Successful, res.status) << res.message;
+        EXPECT_EQ("gzip", res.encoding);
+        EXPECT_EQ("Tile 1/0/0", util::decompress(*res.data));
+        CompressedTile.finish();
+    });
+
+    // The file stores rows from the bottom.
+    fs.request({ Resource::Tile, url + "/1/1/1" }, uv_default_loop(), env, [&](const Response &res) {
+        EXPECT_EQ(Response::Successful, res.status) << res.message;
+        EXPECT_EQ("Tile 1/1/1", *res.data);
+        FlippedTile.finish();
+    });
+
+    fs.request({ Resource::Tile, url + "/1/1/0" }, uv_default_loop(), env, [&](const Response &res) {
+        EXPECT_EQ(Response::Error, res.status);
+        EXPECT_EQ("Tile not found", res.message);
+        MissingTile.finish();
+    });
+
+    fs.request({ Resource::Tile, "mbtiles:///does/not/exist.mbtiles/0/0/0" }, uv_default_loop(), env,
+               [&](const Response &res) {
+        EXPECT_EQ(Response::Error, res.status);
+        EXPECT_NE("", res.message);
+        MissingFile.finish();
+    });
+
+    uv_run(uv_default_loop(), UV_RUN_DEFAULT);
+}
@@ -0,0 +1,259 @@
+#include "storage.hpp"
+
+#include <mbgl/storage/default_file_source.hpp>
+#include <mbgl/storage/default/sqlite_cache.hpp>
+#include <mbgl/storage/offline.hpp>
+#include <mbgl/storage/response.hpp>
+
+#include <rapidjson/document.h>
+
+#include <cstdio>
+#include <future>
+#include <string>
+
+#include <unistd.h>
+
+namespace {
+
+// Unique per process, so that concurrent test runs don't share the database.
+const std::string databasePath = "/tmp/mbgl-cache-offline-" + std::to_string(getpid()) + ".db";
+
+void removeDatabase() {
+    std::remove(databasePath.c_str());
+    std::remove((databasePath + "-wal").c_str());
+    std::remove((databasePath + "-shm").c_str());
+}
+
+}
+
+TEST_F(Storage, OfflineDownload) {
+    using namespace mbgl;
+
+    SQLiteCache cache(":memory:");
+    DefaultFileSource fs(&cache);
+
+    OfflineRegion region;
+    region.name = "test";
+    region.styleURL = "http://127.0.0.1:3000/offline/style.json";
+    region.bounds = { { -10, -10 }, { 10, 10 } };
+    region.minZoom = 0;
+    region.maxZoom = 2;
+
+    // One style, one TileJSON, the sprite JSON and image, 256 glyph ranges of the only font stack
+    // and 1 + 4 + 4 tiles.
+    const uint64_t required = 269;
+
+    {
+        std::promise<OfflineProgress> result;
+        std::string error = "not finished";
+        auto download = fs.downloadRegion(region, nullptr, [&](const OfflineProgress &progress, const std::string &err) {
+            error = err;
+            result.set_value(progress);
+        });
+        ASSERT_TRUE(bool(download));
+
+        const OfflineProgress progress = result.get_future().get();
+        EXPECT_EQ("", error);
+        EXPECT_EQ(required, progress.requiredResources);
+        EXPECT_EQ(required, progress.completedResources);
+        EXPECT_EQ(0u, progress.failedResources);
+        EXPECT_LT(0u, progress.completedBytes);
+    }
+
+    {
+        // Downloading the same region again resumes from the stored progress and has nothing left
+        // to fetch.
+        std::promise<OfflineProgress> first;
+        std::promise<OfflineProgress> result;
+        bool reported = false;
+        auto download = fs.downloadRegion(region, [&](const OfflineProgress &progress) {
+            if (!reported) {
+                reported = true;
+                first.set_value(progress);
+            }
+        }, [&](const OfflineProgress &progress, const std::string &) {
+            result.set_value(progress);
+        });
+
+        const OfflineProgress initial = first.get_future().get();
+        EXPECT_EQ(required, initial.requiredResources);
+        EXPECT_EQ(required, initial.completedResources);
+
+        const OfflineProgress progress = result.get_future().get();
+        EXPECT_EQ(0u, progress.completedBytes);
+    }
+}
+
+TEST_F(Storage, OfflineDownloadRestart) {
+    using namespace mbgl;
+
+    removeDatabase();
+
+    OfflineRegion region;
+    region.name = "restart";
+    region.styleURL = "http://127.0.0.1:3000/offline/style.json";
+    region.bounds = { { -10, -10 }, { 10, 10 } };
+    region.minZoom = 0;
+    region.maxZoom = 2;
+
+    const uint64_t required = 269;
+
+    // The bytes of a download that starts from scratch.
+    uint64_t totalBytes = 0;
+    {
+        SQLiteCache cache(":memory:");
+        DefaultFileSource fs(&cache);
+        std::promise<OfflineProgress> result;
+        auto download = fs.downloadRegion(region, nullptr, [&](const OfflineProgress &progress, const std::string &) {
+            result.set_value(progress);
+        });
+        totalBytes = result.get_future().get().completedBytes;
+    }
+
+    {
+        // Stops the download once more resources completed than fit into one progress interval.
+        SQLiteCache cache(databasePath);
+        DefaultFileSource fs(&cache);
+        std::promise<void> halfway;
+        bool stopping = false;
+        auto download = fs.downloadRegion(region, [&](const OfflineProgress &progress) {
+            if (!stopping && progress.completedResources > 100) {
+                stopping = true;
+                halfway.set_value();
+            }
+        }, nullptr);
+        halfway.get_future().get();
+        download.reset();
+    }
+
+    uint64_t stored = 0;
+    {
+        SQLiteCache cache(databasePath);
+        std::promise<std::string> data;
+        cache.get({ Resource::Unknown, "offline://restart" }, [&](std::unique_ptr<Response> res) {
+            data.set_value(res ? *res->data : "");
+        });
+        rapidjson::Document doc;
+        doc.Parse<0>(data.get_future().get().c_str());
+        ASSERT_FALSE(doc.HasParseError());
+        ASSERT_TRUE(doc.IsObject() && doc.HasMember("completed") && doc["completed"].IsUint64());
+        stored = doc["completed"].GetUint64();
+    }
+    EXPECT_LT(64u, stored);
+    ASSERT_GT(required, stored);
+
+    {
+        // The reopened cache resumes from the stored progress.
+        SQLiteCache cache(databasePath);
+        DefaultFileSource fs(&cache);
+        std::promise<OfflineProgress> first;
+        std::promise<OfflineProgress> result;
+        bool reported = false;
+        auto download = fs.downloadRegion(region, [&](const OfflineProgress &progress) {
+            if (!reported) {
+                reported = true;
+                first.set_value(progress);
+            }
+        }, [&](const OfflineProgress &progress, const std::string &) {
+            result.set_value(progress);
+        });
+
+        const OfflineProgress initial = first.get_future().get();
+        EXPECT_EQ(required, initial.requiredResources);
+        EXPECT_EQ(stored, initial.completedResources);
+
+        const OfflineProgress progress = result.get_future().get();
+        EXPECT_EQ(required, progress.completedResources);
+        EXPECT_EQ(0u, progress.failedResources);
+        EXPECT_LT(0u, progress.completedBytes);
+        EXPECT_GT(totalBytes, progress.completedBytes);
+    }
+
+    {
+        // Other entries push the cache over its limit.
+        SQLiteCache cache(databasePath, 1000);
+        auto image = std::make_shared<Response>();
+        image->status = Response::Successful;
+        image->data = std::make_shared<const std::string>(1000, 'x');
+        for (int i = 0; i < 3; i++) {
+            cache.put({ Resource::Image, "http://127.0.0.1:3000/image/" + std::to_string(i) }, image,
+                      FileCache::Hint::Full);
+        }
+    }
+
+    {
+        SQLiteCache cache(databasePath, 1000);
+        auto found = [&](const Resource &resource) {
+            std::promise<bool> result;
+            cache.get(resource, [&](std::unique_ptr<Response> res) {
+                result.set_value(bool(res));
+            });
+            return result.get_future().get();
+        };
+
+        EXPECT_FALSE(found({ Resource::Image, "http://127.0.0.1:3000/image/0" }));
+
+        // The pinned resources of both runs were not evicted.
+        EXPECT_TRUE(found({ Resource::JSON, "http://127.0.0.1:3000/offline/style.json" }));
+        EXPECT_TRUE(found({ Resource::Glyphs, "http://127.0.0.1:3000/offline/glyphs/Open%20Sans%20Regular/0-255.pbf" }));
+        EXPECT_TRUE(found({ Resource::Tile, "http://127.0.0.1:3000/offline/tiles/2-2-2.pbf" }));
+        EXPECT_TRUE(found({ Resource::Unknown, "offline://restart" }));
+    }
+
+    removeDatabase();
+}
+
+TEST_F(Storage, OfflineDownloadChangedResources) {
+    using namespace mbgl;
+
+    SQLiteCache cache(":memory:");
+    DefaultFileSource fs(&cache);
+
+    OfflineRegion region;
+    region.name = "changed";
+    region.styleURL = "http://127.0.0.1:3000/offline/style.json";
+    region.bounds = { { -10, -10 }, { 10, 10 } };
+    region.minZoom = 0;
+    region.maxZoom = 2;
+
+    {
+        std::promise<OfflineProgress> result;
+        auto download = fs.downloadRegion(region, nullptr, [&](const OfflineProgress &progress, const std::string &) {
+            result.set_value(progress);
+        });
+        EXPECT_EQ(269u, result.get_future().get().requiredResources);
+    }
+
+    {
+        // The high resolution sprite has different URLs, but the number of resources stays the
+        // same. The stored progress doesn't apply to them.
+        region.pixelRatio = 2;
+
+        std::promise<OfflineProgress> first;
+        std::promise<OfflineProgress> result;
+        bool reported = false;
+        auto download = fs.downloadRegion(region, [&](const OfflineProgress &progress) {
+            if (!reported) {
+                reported = true;
+                first.set_value(progress);
+            }
+        }, [&](const OfflineProgress &progress, const std::string &) {
+            result.set_value(progress);
+        });
+
+        const OfflineProgress initial = first.get_future().get();
+        EXPECT_EQ(269u, initial.requiredResources);
+        EXPECT_EQ(0u, initial.completedResources);
+
+        const OfflineProgress progress = result.get_future().get();
+        EXPECT_EQ(269u, progress.completedResources);
+        EXPECT_LT(0u, progress.completedBytes);
+    }
+}
+
+TEST_F(Storage, OfflineDownloadWithoutCache) {
+    using namespace mbgl;
+
+    DefaultFileSource fs(nullptr);
+    EXPECT_FALSE(bool(fs.downloadRegion({}, nullptr, nullptr)));
+}
@@ -3,6 +3,7 @@
 'use strict';
 
 var express = require('express');
+var zlib = require('zlib');
 var app = express();
 
 // We're manually setting Etag headers.
@@ -96,6 +97,84 @@ app.get('/load/:number(\\d+)', function(req, res) {
     res.send('Request ' + req.params.number);
 });
 
+app.get('/gzip', function(req, res) {
+    // Compressed by hand, so that clients that don't decode it see the gzip stream.
+    res.setHeader('Content-Encoding', 'gzip');
+    res.send(zlib.gzipSync('Hello World!'));
+});
+
+app.get('/redirect-headers', function(req, res) {
+    // None of these apply to the response the redirect leads to.
+    res.setHeader('ETag', 'redirect');
+    res.setHeader('Cache-Control', 'max-age=3600');
+    res.setHeader('Content-Encoding', 'gzip');
+    res.redirect('/identity');
+});
+
+app.get('/identity', function(req, res) {
+    res.setHeader('Content-Encoding', 'identity');
+    res.send('Hello World!');
+});
+
+var concurrent = 0;
+app.get('/concurrent/:number(\\d+)', function(req, res) {
+    // Reports how many of these requests were in flight when this one arrived.
+    concurrent++;
+    var current = concurrent;
+    setTimeout(function() {
+        concurrent--;
+        res.send(String(current));
+    }, 20);
+});
+
+app.get('/offline/style.json', function(req, res) {
+    res.setHeader('Cache-Control', 'max-age=3600');
+    res.send({
+        version: 6,
+        sources: {
+            vector: { type: 'vector', url: 'http://127.0.0.1:3000/offline/source.json' }
+        },
+        sprite: 'http://127.0.0.1:3000/offline/sprite',
+        glyphs: 'http://127.0.0.1:3000/offline/glyphs/{fontstack}/{range}.pbf',
+        layers: [{
+            id: 'water',
+            type: 'fill',
+            source: 'vector',
+            'source-layer': 'water'
+        }, {
+            id: 'label',
+            type: 'symbol',
+            source: 'vector',
+            'source-layer': 'place',
+            layout: { 'text-field': '{name}', 'text-font': 'Open Sans Regular' }
+        }]
+    });
+});
+
+app.get('/offline/source.json', function(req, res) {
+    res.setHeader('Cache-Control', 'max-age=3600');
+    res.send({
+        tiles: [ 'http://127.0.0.1:3000/offline/tiles/{z}-{x}-{y}.pbf' ],
+        minzoom: 0,
+        maxzoom: 14
+    });
+});
+
+app.get('/offline/:resource', function(req, res) {
+    res.setHeader('Cache-Control', 'max-age=3600');
+    res.send('Offline ' + req.params.resource);
+});
+
+app.get('/offline/:directory/:resource', function(req, res) {
+    res.setHeader('Cache-Control', 'max-age=3600');
+    res.send('Offline ' + req.params.directory + '/' + req.params.resource);
+});
+
+app.get('/offline/glyphs/:fontstack/:range', function(req, res) {
+    res.setHeader('Cache-Control', 'max-age=3600');
+    res.send('Offline glyphs ' + req.params.range);
+});
+
 var server = app.listen(3000, function () {
     var host = server.address().address;
     var port = server.address().port;
@@ -34,37 +34,57 @@
         'fixtures/util.cpp',
         'fixtures/fixture_log_observer.hpp',
         'fixtures/fixture_log_observer.cpp',
+        'fixtures/stub_file_source.hpp',
 
         'headless/headless.cpp',
 
         'miscellaneous/clip_ids.cpp',
         'miscellaneous/bilinear.cpp',
+        'miscellaneous/buffer.cpp',
         'miscellaneous/comparisons.cpp',
+        'miscellaneous/compression.cpp',
+        'miscellaneous/earcut.cpp',
         'miscellaneous/enums.cpp',
+        'miscellaneous/fill_batch.cpp',
         'miscellaneous/functions.cpp',
+        'miscellaneous/glyph_store.cpp',
         'miscellaneous/mapbox.cpp',
         'miscellaneous/merge_lines.cpp',
         'miscellaneous/rotation_range.cpp',
         'miscellaneous/style_parser.cpp',
         'miscellaneous/text_conversions.cpp',
         'miscellaneous/tile.cpp',
+        'miscellaneous/tile_cache.cpp',
+        'miscellaneous/tile_data.cpp',
         'miscellaneous/variant.cpp',
+        'miscellaneous/vector_tile.cpp',
+        'miscellaneous/uv_worker.cpp',
 
         'storage/storage.hpp',
         'storage/storage.cpp',
+        'storage/asset_zip.cpp',
+        'storage/cache_batch.cpp',
+        'storage/cache_benchmark.cpp',
+        'storage/cache_encoding.cpp',
+        'storage/cache_eviction.cpp',
         'storage/cache_response.cpp',
         'storage/cache_revalidate.cpp',
+        'storage/cache_stale.cpp',
         'storage/directory_reading.cpp',
         'storage/file_reading.cpp',
         'storage/http_cancel.cpp',
         'storage/http_coalescing.cpp',
+        'storage/http_concurrency.cpp',
         'storage/http_environment.cpp',
         'storage/http_error.cpp',
         'storage/http_header_parsing.cpp',
         'storage/http_load.cpp',
         'storage/http_noloop.cpp',
         'storage/http_other_loop.cpp',
+        'storage/http_priority.cpp',
         'storage/http_reading.cpp',
+        'storage/mbtiles.cpp',
+        'storage/offline.cpp',
       ],
       'libraries': [
         '<@(uv_static_libs)',
@@ -74,6 +94,7 @@
           '<@(uv_cflags)',
           '<@(opengl_cflags)',
           '<@(boost_cflags)',
+          '<@(lz4_cflags)',
         ],
         'ldflags': [
           '<@(uv_ldflags)',